@@ -1,621 +1,6955 @@
 /* This file is Copyright 2002 Level Control Systems.  See the included LICENSE.txt file for details. */  
 
-#include "dataio/FileDataIO.h"
+#include "dataio/TCPSocketDataIO.h"
+#include "iogateway/MessageIOGateway.h"
+#include "message/Message.h"
+#include "system/AtomicCounter.h"
+#include "system/Mutex.h"
 #include "system/SetupSystem.h"
 #include "system/SystemInfo.h"
+#include "system/Thread.h"
 #include "util/ByteBuffer.h"
+#include "util/Directory.h"
 #include "util/FilePathInfo.h"
 #include "util/Hashtable.h"
+#include "util/NetworkUtilityFunctions.h"
 #include "util/String.h"
 #include "util/StringTokenizer.h"
 
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <utime.h>
+
+#include <condition_variable>
+
+#ifndef __APPLE__
+# include <elf.h>
+#endif
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
 using namespace muscle;
 
-class SymbolRecord
+/** A condition variable that goes with a muscle Mutex, for when a thread needs to wait (without spinning) for another thread
+  * to change some Mutex-protected state.  Since muscle's Mutexes are recursive, the calling thread must have locked the Mutex
+  * exactly once (e.g. via a MutexGuard) when it calls Wait().
+  */
+class MutexConditionVariable
 {
 public:
-   SymbolRecord() : _startAddress(0), _length(0) {/* empty */}
+   MutexConditionVariable() {/* empty */}
 
-   uint64 _startAddress;
-   uint64 _length;
-   String _text;
+   /** Unlocks (mutex), blocks until NotifyAll() is called (or spuriously, so the caller should re-check its condition), and then re-locks (mutex) */
+   void Wait(const Mutex & mutex)
+   {
+      MutexAdapter adapter(mutex);
+      _condition.wait(adapter);
+   }
+
+   /** Wakes up all of the threads that are blocked in Wait().  The caller should hold the Mutex that the waiters are using. */
+   void NotifyAll() {_condition.notify_all();}
+
+private:
+   MutexConditionVariable(const MutexConditionVariable &);  // deliberately unimplemented
+   MutexConditionVariable & operator = (const MutexConditionVariable &);  // deliberately unimplemented
+
+   /** Gives a Mutex the lock()/unlock() methods that std::condition_variable_any expects */
+   class MutexAdapter
+   {
+   public:
+      MutexAdapter(const Mutex & mutex) : _mutex(mutex) {/* empty */}
+
+      void lock()   {(void) _mutex.Lock();}
+      void unlock() {(void) _mutex.Unlock();}
+
+   private:
+      const Mutex & _mutex;
+   };
+
+   std::condition_variable_any _condition;
 };
 
-class NameAndSymbolRecord : public SymbolRecord
+/** A run of characters (e.g. one line, or a symbol's whole text), as a pointer into text that is owned by someone else */
+class TextSpan
 {
 public:
-   NameAndSymbolRecord() : _name(NULL) {/* empty */}
-   NameAndSymbolRecord(const String * name, const SymbolRecord & sr) : SymbolRecord(sr), _name(name) {/* empty */}
+   TextSpan() : _chars(NULL), _length(0) {/* empty */}
+   TextSpan(const char * chars, uint32 length) : _chars(chars), _length(length) {/* empty */}
 
-   const String * GetName() const {return _name;}
+   bool operator == (const TextSpan & rhs) const {return (_length == rhs._length)&&((_chars == rhs._chars)||(memcmp(_chars, rhs._chars, _length) == 0));}
+   bool operator != (const TextSpan & rhs) const {return !(*this == rhs);}
 
-   // Convenience method for easier debugging
-   String ToString() const
+   int Compare(const TextSpan & rhs) const
    {
-      char buf[512];
-      muscleSprintf(buf, " [" XINT64_FORMAT_SPEC "-" XINT64_FORMAT_SPEC ") (length=" UINT64_FORMAT_SPEC ")", _startAddress, _startAddress+_length, _length);
-      return _name->Append(buf); 
+      const uint32 commonLength = muscleMin(_length, rhs._length);
+      const int ret = (commonLength > 0) ? memcmp(_chars, rhs._chars, commonLength) : 0;  // (empty spans may have NULL pointers)
+      return ret ? ret : muscleCompare(_length, rhs._length);
    }
 
-private:
-   const String * _name;
+   uint32 HashCode() const {return CalculateHashCode(_chars, _length);}
+
+   const char * _chars;
+   uint32 _length;
 };
 
-static String CalculateDiffs(const String & textA, const String & textB)
+/** A simple bump-allocator for text.  Rather than giving every symbol (and every line) its own heap-allocated
+  * String, all of an executable's text gets appended into a few large blocks, and each symbol just refers to
+  * its span within them.  That means far fewer allocations, and no per-String slack.  Spans are never freed
+  * individually; everything goes away at once when the TextArena is deleted.
+  */
+class TextArena : public RefCountable
 {
-   String tempPath;
-   if (GetSystemPath(SYSTEM_PATH_TEMPFILES, tempPath) != B_NO_ERROR) return "Error, couldn't find temp folder!";
+public:
+   TextArena(uint32 blockSize = 4*1024*1024) : _blockSize(blockSize), _numReleasedBlocks(0), _curBlock(NULL), _curBlockSize(0), _numUsed(0), _spanStart(0), _numBytesAllocated(0) {/* empty */}
+   virtual ~TextArena() {for (uint32 i=0; i<_blocks.GetNumItems(); i++) delete [] _blocks[i];}
 
-   const String tmpAPath = tempPath + "executable_diff_temp_a.txt";
-   const String tmpBPath = tempPath + "executable_diff_temp_b.txt";
+   /** Starts a new span; subsequent calls to Append() will add to it, until EndSpan() is called */
+   void BeginSpan() {_spanStart = _numUsed;}
 
-   // Rather than come up with my own diffing algorithm, I'm going to just cheese it and call out to `diff`
+   /** Appends (numChars) characters to the current span.  Returns B_NO_ERROR on success, or B_ERROR if out of memory. */
+   status_t Append(const char * chars, uint32 numChars)
    {
-      FileDataIO outA(fopen(tmpAPath(), "w"));
-      outA.WriteFully(textA(), textA.Length());
+      if (((_curBlockSize-_numUsed) < numChars)&&(GrowCurrentSpan(numChars) != B_NO_ERROR)) return B_ERROR;
+      memcpy(_curBlock+_numUsed, chars, numChars);
+      _numUsed += numChars;
+      return B_NO_ERROR;
    }
+
+   /** Appends a single character to the current span.  Returns B_NO_ERROR on success, or B_ERROR if out of memory. */
+   status_t Append(char c)
    {
-      FileDataIO outB(fopen(tmpBPath(), "w"));
-      outB.WriteFully(textB(), textB.Length());
+      if ((_numUsed == _curBlockSize)&&(GrowCurrentSpan(1) != B_NO_ERROR)) return B_ERROR;
+      _curBlock[_numUsed++] = c;
+      return B_NO_ERROR;
    }
 
-   FILE * pIn = popen(String("diff %1 %2").Arg(tmpAPath).Arg(tmpBPath)(), "r");
-   if (pIn)
+   /** Returns the span of everything that was appended since BeginSpan() was called.  The span remains valid for the lifetime of this TextArena. */
+   TextSpan EndSpan()
    {
-      String ret;
-      char buf[2048];
-      while(fgets(buf, sizeof(buf), pIn)) ret += buf;
-      pclose(pIn);
+      const TextSpan ret(_curBlock+_spanStart, _numUsed-_spanStart);
+      _spanStart = _numUsed;
       return ret;
    }
-   else return "Unable to launch diff!";
-}
 
-static void PrintSymbolDiffs(const String & symbolName, const String & symbolTextA, const String & symbolTextB, FILE * fpOut)
+   /** Discards (span), which must be the span that EndSpan() most recently returned, so that its space gets reused by the next span.
+     * (If that span had to be moved to a new block, the previous block's unused space is not reclaimed, though.)
+     */
+   void DiscardLastSpan(const TextSpan & span)
+   {
+      if ((span._length > 0)&&(span._chars+span._length == _curBlock+_numUsed)) _numUsed = _spanStart = (uint32)(span._chars-_curBlock);
+   }
+
+   /** Returns the total number of bytes this arena has allocated so far */
+   uint64 GetNumBytesAllocated() const {return _numBytesAllocated;}
+
+   /** Frees all of our blocks that precede the block containing (chars), which should point into one of our spans.
+     * Any spans in the freed blocks become invalid, of course.  This lets a caller that processes our spans in the
+     * order they were created release our memory as it goes, rather than all at once at the end.
+     */
+   void ReleaseBlocksBefore(const char * chars)
+   {
+      for (uint32 i=_numReleasedBlocks; i<_blocks.GetNumItems(); i++)
+      {
+         if ((chars >= _blocks[i])&&(chars < _blocks[i]+_blockSizes[i]))
+         {
+            for (uint32 j=_numReleasedBlocks; j<i; j++)
+            {
+               delete [] _blocks[j];
+               _blocks[j] = NULL;
+            }
+            _numReleasedBlocks = i;
+            return;
+         }
+      }
+   }
+
+private:
+   TextArena(const TextArena &);  // deliberately unimplemented
+   TextArena & operator = (const TextArena &);  // deliberately unimplemented
+
+   // Moves the current span to a new block with room for at least (numMoreChars) more characters, since spans must be contiguous
+   status_t GrowCurrentSpan(uint32 numMoreChars)
+   {
+      const uint32 spanLength   = _numUsed-_spanStart;
+      const uint32 newBlockSize = ((spanLength+numMoreChars) <= _blockSize) ? _blockSize : (spanLength+muscleMax(numMoreChars, spanLength));  // spans bigger than a block grow geometrically
+      char * newBlock = newnothrow_array(char, newBlockSize);
+      if (newBlock == NULL) {WARN_OUT_OF_MEMORY; return B_ERROR;}
+      if (_blockSizes.AddTail(newBlockSize) != B_NO_ERROR) {delete [] newBlock; return B_ERROR;}
+      if (_blocks.AddTail(newBlock) != B_NO_ERROR) {(void) _blockSizes.RemoveTail(); delete [] newBlock; return B_ERROR;}
+
+      if (spanLength > 0) memcpy(newBlock, _curBlock+_spanStart, spanLength);
+      _curBlock     = newBlock;
+      _curBlockSize = newBlockSize;
+      _numUsed      = spanLength;
+      _spanStart    = 0;
+      _numBytesAllocated += newBlockSize;
+      return B_NO_ERROR;
+   }
+
+   const uint32 _blockSize;
+   Queue<char *> _blocks;
+   Queue<uint32> _blockSizes;
+   uint32 _numReleasedBlocks;
+   char * _curBlock;
+   uint32 _curBlockSize;
+   uint32 _numUsed;    // number of bytes used in (_curBlock)
+   uint32 _spanStart;  // offset within (_curBlock) where the current span began
+   uint64 _numBytesAllocated;
+};
+DECLARE_REFTYPES(TextArena);
+
+/** A symbol's sanitized text, as the ID of each of its lines (see LineTable) rather than as the text itself */
+class LineIDSpan
 {
-   fprintf(fpOut, "\n\n===================== Diffs for [%s]:\n", symbolName());
-   fprintf(fpOut, "%s\n", CalculateDiffs(symbolTextA, symbolTextB)());
-}
+public:
+   LineIDSpan() : _ids(NULL), _numLines(0) {/* empty */}
+   LineIDSpan(const uint32 * ids, uint32 numLines) : _ids(ids), _numLines(numLines) {/* empty */}
 
-static bool IsHexChar(char c)
+   /** Interprets (bytes) (e.g. a span of a TextArena that was filled via AppendLineID()) as an array of line IDs */
+   explicit LineIDSpan(const TextSpan & bytes) : _ids((const uint32 *) bytes._chars), _numLines(bytes._length/sizeof(uint32)) {/* empty */}
+
+   bool operator == (const LineIDSpan & rhs) const {return (_numLines == rhs._numLines)&&((_ids == rhs._ids)||(memcmp(_ids, rhs._ids, _numLines*sizeof(uint32)) == 0));}
+   bool operator != (const LineIDSpan & rhs) const {return !(*this == rhs);}
+
+   /** Returns our IDs as raw bytes (e.g. for hashing them, or writing them to a file) */
+   TextSpan GetBytes() const {return TextSpan((const char *) _ids, _numLines*sizeof(uint32));}
+
+   const uint32 * _ids;
+   uint32 _numLines;
+};
+
+/** Appends (lineID) to the current span of (out).  Returns B_NO_ERROR on success, or B_ERROR if out of memory. */
+static status_t AppendLineID(uint32 lineID, TextArena & out) {return out.Append((const char *) &lineID, sizeof(lineID));}
+
+/** A small per-thread cache of recently-looked-up lines, for LineTable::GetLineID().  A few very common lines (e.g. "ret", or
+  * "push   %rbp") make up much of any disassembly, so many lookups get answered from here, without locking anything.
+  * Each thread should use its own cache, since the cache is modified by lookups.
+  */
+class LineIDCache : public RefCountable
 {
-   return muscleInRange(c, '0', '9') ||
-          muscleInRange(c, 'A', 'F') ||
-          muscleInRange(c, 'a', 'f');
-}
+public:
+   enum {NUM_SLOTS = 4096};  // must be a power of two
+
+   LineIDCache() {Clear();}
+
+   void Clear() {for (uint32 i=0; i<NUM_SLOTS; i++) _slots[i]._id = NOT_CACHED;}
+
+private:
+   friend class LineTable;
+
+   enum {NOT_CACHED = MUSCLE_NO_LIMIT};
+
+   class Slot
+   {
+   public:
+      TextSpan _line;  // points to the LineTable's copy of the line
+      uint32 _hash;
+      uint32 _id;      // NOT_CACHED, or the ID of (_line)
+   };
+   Slot _slots[NUM_SLOTS];
+};
+DECLARE_REFTYPES(LineIDCache);
 
-static String GetSymbolicAddressStringAux(uint64 addr, const Queue<NameAndSymbolRecord> & index, uint32 firstIdx, uint32 afterLastIdx)
+/** Assigns each distinct line of sanitized text a 32-bit ID, so that symbols can hold their text as arrays of IDs (see LineIDSpan).
+  * Executables repeat the same lines over and over again (there are typically ten or more times as many lines as distinct lines), so this
+  * takes several times less memory than the text would, and comparing or diffing two symbols only has to compare integers.
+  * Two symbols whose IDs came from the same LineTable have the same text iff they have the same line IDs, so the executables that are
+  * compared against each other share a LineTable (see SymbolTable::_lineTable); it goes away along with the last of them.  The lines are
+  * spread over NUM_STRIPES separately-locked stripes (by hash), so that many threads can add lines at once.  Lines are never removed.
+  *
+  * A LineTable may also be an overlay of a parent table (e.g. a baseline's, that several builds get compared against):  lines that the
+  * parent already has keep the parent's IDs, and only the other lines get added to (and freed along with) the overlay.  The parent must
+  * not have any more lines added to it once it has an overlay.
+  */
+class LineTable : public RefCountable
 {
-        if (firstIdx   >= afterLastIdx) return GetEmptyString();
-   else if (firstIdx+1 == afterLastIdx)
+public:
+   /** @param optParent if non-NULL, the table to overlay.  It may not be an overlay itself. */
+   LineTable(const ConstRef<LineTable> & optParent = ConstRef<LineTable>()) : _optParent(optParent) {/* empty */}
+
+   /** Returns the ID of the line (chars) (which should not include its newline), adding it to the table if necessary.  Thread-safe.
+     * @param chars the line's text
+     * @param length the number of chars in the line
+     * @param optCache if non-NULL, a cache to consult (and update) before locking and searching the table
+     */
+   uint32 GetLineID(const char * chars, uint32 length, LineIDCache * optCache = NULL)
    {
-      // single-object case; either we have it or we don't
-      const NameAndSymbolRecord & nasr = index[firstIdx];
-      const int64 diff = addr-nasr._startAddress;
-      return ((diff >= 0)&&(((uint64)diff < nasr._length))) ? *nasr.GetName() : GetEmptyString();
+      const HashedLine line(TextSpan(chars, length));
+      LineIDCache::Slot * slot = optCache ? &optCache->_slots[line._hash & (LineIDCache::NUM_SLOTS-1)] : NULL;
+      if ((slot)&&(slot->_id != (uint32) LineIDCache::NOT_CACHED)&&(slot->_hash == line._hash)&&(slot->_line == line._line)) return slot->_id;
+
+      uint32 id;
+      if ((_optParent() == NULL)||(_optParent()->FindLineID(line, id) != B_NO_ERROR))
+      {
+         const uint32 stripeIdx = GetStripeIndex(line);
+         Stripe & s = _stripes[stripeIdx];
+         MutexGuard mg(s._mutex);
+         const uint32 * lineIdx = s._lineIDs.Get(line);
+         id = ((lineIdx ? *lineIdx : s.AddLine(line))<<NUM_STRIPE_BITS)|stripeIdx|(_optParent() ? (uint32)OVERLAY_ID_BIT : 0);
+      }
+      if (slot)
+      {
+         slot->_line = GetLine(id);
+         slot->_hash = line._hash;
+         slot->_id   = id;
+      }
+      return id;
    }
-   else
+
+   /** Returns the text of the line with the given ID.  This doesn't lock anything, since a line's entry never moves once it has been added;
+     * it may be called from any thread that has obtained (id) (e.g. from GetLineID(), or from a LineIDSpan it was handed).
+     */
+   TextSpan GetLine(uint32 id) const
+   {
+      if ((_optParent())&&((id & OVERLAY_ID_BIT) == 0)) return _optParent()->GetLine(id);
+
+      uint32 chunkIdx, offset;
+      GetChunkPosition((id & ~OVERLAY_ID_BIT)>>NUM_STRIPE_BITS, chunkIdx, offset);
+      return _stripes[id&(NUM_STRIPES-1)]._chunks[chunkIdx][offset];
+   }
+
+   /** Returns a rough estimate of how many bytes of memory our lines are using (not including our parent's, if we have one) */
+   uint64 GetNumBytesAllocated() const
    {
-      // In this case we have at least two NameAndSymbolRecord objects in our range, so we'll divide and recurse
-      const uint32 midIdx = (firstIdx+afterLastIdx)/2;
-      const NameAndSymbolRecord & midNASR = index[midIdx];
- 
-      return (addr < midNASR._startAddress) 
-         ? GetSymbolicAddressStringAux(addr, index, firstIdx,       midIdx)
-         : GetSymbolicAddressStringAux(addr, index,   midIdx, afterLastIdx);
+      uint64 ret = 0;
+      for (uint32 i=0; i<NUM_STRIPES; i++)
+      {
+         const Stripe & s = _stripes[i];
+         MutexGuard mg(s._mutex);
+         ret += s._text.GetNumBytesAllocated()+(s._numLines*(sizeof(TextSpan)+sizeof(HashedLine)+sizeof(uint32)+16));  // 16 for the hashtable's own per-entry overhead
+      }
+      return ret;
    }
-}
 
-/** Returns true iff the 8 bytes pointed to by (s) end in four or more 0-bytes
-  * 4-byte integers placed into 8-byte fields seem to occur a lot in the .rodata
-  * section; I'm not sure what they are but they appear to be some kind of address
-  * offset so I'm going to ignore them as a false-positive.  -jaf
+private:
+   LineTable(const LineTable &);  // deliberately unimplemented
+   LineTable & operator = (const LineTable &);  // deliberately unimplemented
+
+   enum {
+      NUM_STRIPE_BITS  = 6,
+      NUM_STRIPES      = (1<<NUM_STRIPE_BITS),
+      MAX_STRIPE_LINES = (1<<(31-NUM_STRIPE_BITS)),  // so that every line ID fits into 31 bits
+      OVERLAY_ID_BIT   = (1u<<31),                   // set in the IDs of the lines that were added to an overlay rather than found in its parent
+      FIRST_CHUNK_BITS = 8,
+      FIRST_CHUNK_SIZE = (1<<FIRST_CHUNK_BITS),
+      MAX_CHUNKS       = 32                          // more than enough for MAX_STRIPE_LINES, since each chunk is twice as big as the one before it
+   };
+
+   /** A line along with its hash code, so that each line only has to be hashed once */
+   class HashedLine
+   {
+   public:
+      HashedLine() : _hash(0) {/* empty */}
+      explicit HashedLine(const TextSpan & line) : _line(line), _hash(line.HashCode()) {/* empty */}
+
+      bool operator == (const HashedLine & rhs) const {return (_hash == rhs._hash)&&(_line == rhs._line);}
+      uint32 HashCode() const {return _hash;}
+
+      TextSpan _line;
+      uint32 _hash;
+   };
+
+   static uint32 GetStripeIndex(const HashedLine & line) {return line._hash>>(32-NUM_STRIPE_BITS);}  // the high bits, since the Hashtable uses the low ones
+
+   // Sets (retID) to the ID of (line) and returns B_NO_ERROR, or returns B_ERROR if we don't have (line)
+   status_t FindLineID(const HashedLine & line, uint32 & retID) const
+   {
+      const uint32 stripeIdx = GetStripeIndex(line);
+      const Stripe & s = _stripes[stripeIdx];
+      MutexGuard mg(s._mutex);
+      const uint32 * lineIdx = s._lineIDs.Get(line);
+      if (lineIdx == NULL) return B_ERROR;
+      retID = ((*lineIdx)<<NUM_STRIPE_BITS)|stripeIdx;
+      return B_NO_ERROR;
+   }
+
+   // A stripe's line entries are held in chunks of doubling sizes, so that they never have to be moved (see GetLine())
+   static void GetChunkPosition(uint32 lineIdx, uint32 & retChunkIdx, uint32 & retOffset)
+   {
+      const uint32 n = lineIdx+FIRST_CHUNK_SIZE;
+      retChunkIdx = (31-__builtin_clz(n))-FIRST_CHUNK_BITS;
+      retOffset   = n-(FIRST_CHUNK_SIZE<<retChunkIdx);
+   }
+
+   class Stripe
+   {
+   public:
+      Stripe() : _text(64*1024), _numLines(0) {for (uint32 i=0; i<MAX_CHUNKS; i++) _chunks[i] = NULL;}
+      ~Stripe() {for (uint32 i=0; i<MAX_CHUNKS; i++) delete [] _chunks[i];}
+
+      // Copies (line) into our own storage and returns its index within this stripe.  Must be called with (_mutex) locked.
+      uint32 AddLine(const HashedLine & line)
+      {
+         if (_numLines == MAX_STRIPE_LINES)
+         {
+            LogTime(MUSCLE_LOG_CRITICALERROR, "Too many distinct lines of disassembly, giving up!\n");
+            exit(10);
+         }
+
+         uint32 chunkIdx, offset;
+         GetChunkPosition(_numLines, chunkIdx, offset);
+         if (_chunks[chunkIdx] == NULL) _chunks[chunkIdx] = newnothrow_array(TextSpan, FIRST_CHUNK_SIZE<<chunkIdx);
+
+         _text.BeginSpan();
+         if ((_chunks[chunkIdx] == NULL)||(_text.Append(line._line._chars, line._line._length) != B_NO_ERROR)) {WARN_OUT_OF_MEMORY; exit(10);}
+
+         HashedLine ourLine = line;
+         ourLine._line = _text.EndSpan();
+         if (_lineIDs.Put(ourLine, _numLines) != B_NO_ERROR) {WARN_OUT_OF_MEMORY; exit(10);}
+
+         _chunks[chunkIdx][offset] = ourLine._line;
+         return _numLines++;
+      }
+
+      mutable Mutex _mutex;
+      TextArena _text;                       // the text of our lines
+      Hashtable<HashedLine, uint32> _lineIDs;  // line text -> index within this stripe
+      TextSpan * _chunks[MAX_CHUNKS];        // line index -> line text
+      uint32 _numLines;
+   };
+
+   const ConstRef<LineTable> _optParent;
+   Stripe _stripes[NUM_STRIPES];
+};
+DECLARE_REFTYPES(LineTable);
+
+/** A read-only memory-mapping of an entire file */
+class MemoryMappedFile : public RefCountable
+{
+public:
+   MemoryMappedFile() : _fileData(NULL), _fileSize(0) {/* empty */}
+   virtual ~MemoryMappedFile() {Unmap();}
+
+   /** Memory-maps the specified file.  Returns B_NO_ERROR on success, or B_ERROR on failure (or if the file is empty). */
+   status_t Map(const char * path)
+   {
+      const int fd = open(path, O_RDONLY);
+      if (fd < 0) {Unmap(); return B_ERROR;}
+
+      const status_t ret = Map(fd);
+      close(fd);  // the mapping remains valid after the file descriptor is closed
+      return ret;
+   }
+
+   /** Memory-maps the file that (fd) refers to.  The caller retains ownership of (fd).
+     * Returns B_NO_ERROR on success, or B_ERROR on failure (or if the file is empty).
+     */
+   status_t Map(int fd)
+   {
+      Unmap();
+
+      struct stat st;
+      if ((fstat(fd, &st) == 0)&&(st.st_size > 0))
+      {
+         void * mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (mapping != MAP_FAILED)
+         {
+            _fileData = (const uint8 *) mapping;
+            _fileSize = st.st_size;
+         }
+      }
+      return _fileData ? B_NO_ERROR : B_ERROR;
+   }
+
+   /** Unmaps our file, if it was mapped */
+   void Unmap()
+   {
+      if (_fileData) (void) munmap(const_cast<uint8 *>(_fileData), _fileSize);
+      _fileData = NULL;
+      _fileSize = 0;
+   }
+
+   const uint8 * GetData() const {return _fileData;}
+   uint64 GetNumBytes() const {return _fileSize;}
+
+private:
+   MemoryMappedFile(const MemoryMappedFile &);  // deliberately unimplemented
+   MemoryMappedFile & operator = (const MemoryMappedFile &);  // deliberately unimplemented
+
+   const uint8 * _fileData;
+   uint64 _fileSize;
+};
+DECLARE_REFTYPES(MemoryMappedFile);
+
+/** Creates an anonymous temporary file in (directory), opened with the given fopen()-style (mode).  The file is unlinked right away,
+  * so it will disappear as soon as the returned handle is fclose()'d.  Returns NULL on failure.
   */
-static bool IsOffset(const uint8 * s)
+static FILE * CreateTemporaryFile(const String & directory, const char * mode)
 {
-   for (int i=4; i<8; i++) if (s[i] != 0) return false;
-   return true;
+   char pathBuf[2048];
+   muscleSnprintf(pathBuf, sizeof(pathBuf), "%s/executable_diff_spill_XXXXXX", directory());
+   const int fd = mkstemp(pathBuf);
+   if (fd < 0) return NULL;
+
+   (void) unlink(pathBuf);
+   FILE * ret = fdopen(fd, mode);
+   if (ret == NULL) close(fd);
+   return ret;
 }
 
-static String GetSymbolicAddressString(uint64 addr, const Queue<NameAndSymbolRecord> & index, const ByteBuffer * optROData, uint64 roStart)
+/** An anonymous temporary file that text can be appended to, so that the text doesn't have to be held in memory (see --low-memory).
+  * Once all of the text has been appended, the file gets memory-mapped, so that the text can be used in-place.  Since the mapped
+  * pages are backed by the file, the kernel can simply drop them again whenever it needs the memory for something else.
+  */
+class TextSpillFile : public RefCountable
 {
-   // For Linux/objdump:  If addr points to inside the .rodata section, return the literal-string it points to
-   if ((optROData)&&(addr >= roStart)&&(addr < (roStart+optROData->GetNumBytes())))
+public:
+   TextSpillFile() : _fpOut(NULL), _numBytesWritten(0), _writeFailed(false) {/* empty */}
+   virtual ~TextSpillFile() {Close();}
+
+   /** Creates our temporary file in (directory).  Returns B_NO_ERROR on success, or B_ERROR on failure. */
+   status_t Open(const String & directory)
    {
-      const uint8 * s = optROData->GetBuffer()+(addr-roStart);
-      return IsOffset(s) ? String("{(offset)}") : String("{%1}").Arg(String((const char *) s, (optROData->GetBuffer()+optROData->GetNumBytes())-s));
+      Close();
+      _fpOut = CreateTemporaryFile(directory, "wb");
+      return _fpOut ? B_NO_ERROR : B_ERROR;
    }
 
-   return GetSymbolicAddressStringAux(addr, index, 0, index.GetNumItems());
-}
+   /** Appends (text) to our file, and returns the offset it was written at. */
+   uint64 Append(const TextSpan & text)
+   {
+      const uint64 ret = _numBytesWritten;
+      if ((_fpOut)&&(text._length > 0)&&(fwrite(text._chars, 1, text._length, _fpOut) != text._length)) _writeFailed = true;
+      _numBytesWritten += text._length;
+      return ret;
+   }
+
+   /** Flushes everything we've appended, and memory-maps our file so that GetText() can be called.  No more text may be appended after this.
+     * Returns B_NO_ERROR on success, or B_ERROR on failure.
+     */
+   status_t Map()
+   {
+      if ((_fpOut == NULL)||(_writeFailed)||(fflush(_fpOut) != 0)) return B_ERROR;
+      const status_t ret = (_numBytesWritten > 0) ? _mapping.Map(fileno(_fpOut)) : B_NO_ERROR;
+      Close();
+      return ret;
+   }
+
+   /** Returns the text of (numBytes) bytes that was written at (offset).  Only valid after Map() has succeeded. */
+   TextSpan GetText(uint64 offset, uint32 numBytes) const {return TextSpan(numBytes ? (const char *)(_mapping.GetData()+offset) : NULL, numBytes);}
+
+   /** Returns the number of bytes that have been appended to our file so far */
+   uint64 GetNumBytesWritten() const {return _numBytesWritten;}
 
-static void SanitizeLine(const String & lineStr, String & ret, const Queue<NameAndSymbolRecord> & index, const ByteBuffer * optROData, uint64 roStart)
+private:
+   TextSpillFile(const TextSpillFile &);  // deliberately unimplemented
+   TextSpillFile & operator = (const TextSpillFile &);  // deliberately unimplemented
+
+   void Close()
+   {
+      if (_fpOut) fclose(_fpOut);
+      _fpOut = NULL;
+   }
+
+   FILE * _fpOut;
+   uint64 _numBytesWritten;
+   bool _writeFailed;
+   MemoryMappedFile _mapping;
+};
+DECLARE_REFTYPES(TextSpillFile);
+
+class SymbolRecord
 {
-   ret.Clear();
+public:
+   SymbolRecord() : _startAddress(0), _length(0), _linesHash(0) {/* empty */}
 
-   const char * p = lineStr();
-   while(*p)
+   /** Returns true iff our text is the same as (rhs)'s text.  The hash-codes are compared first, so that
+     * the full line-ID-comparison only has to be done to confirm a match.
+     */
+   bool HasSameTextAs(const SymbolRecord & rhs) const {return (_linesHash == rhs._linesHash)&&(_lines == rhs._lines);}
+
+   /** Recalculates (_linesHash) from (_lines).  Should be called whenever (_lines) changes. */
+   void UpdateLinesHash()
    {
-      if ((p[0] == '-')&&(p[1] == '0')&&(p[2] == 'x')) 
+      const TextSpan bytes = _lines.GetBytes();
+      _linesHash = CalculateHashCode64(bytes._chars, bytes._length);
+   }
+
+   uint64 _startAddress;
+   uint64 _length;
+   LineIDSpan _lines;  // the sanitized text, as line IDs; points into a TextArena (see SymbolTable)
+   uint64 _linesHash;  // 64-bit hash of (_lines), set after the text has been sanitized
+};
+
+/** All of the symbols parsed from one executable, along with the TextArenas that hold their line IDs */
+class SymbolTable
+{
+public:
+   SymbolTable() {/* empty */}
+
+   LineTableRef _lineTable;  // the dictionary that our symbols' line IDs refer to (see ParseSettings::_lineTable)
+   Hashtable<String, SymbolRecord> _symbols;
+   Queue<TextArenaRef> _textArenas;  // the SymbolRecords' spans point into these, so they must live as long as (_symbols) does
+   Queue<TextSpillFileRef> _spillFiles;  // with --low-memory, the symbols' spans point into these instead (or into the baseline's line IDs; see ParseSettings)
+};
+
+/** Computes the shortest edit script between two sequences of line-IDs, using the linear-space
+  * (divide-and-conquer) variant of Myers' O(ND) algorithm.  On return, every line that isn't part
+  * of the longest common subsequence has been flagged as changed.
+  */
+class MyersDiff
+{
+public:
+   MyersDiff(const LineIDSpan & a, Queue<bool> & changedA, const LineIDSpan & b, Queue<bool> & changedB) : _a(a._ids), _changedA(changedA), _b(b._ids), _changedB(changedB)
+   {
+      const uint32 maxD = ((a._numLines+b._numLines+1)/2)+1;
+      (void) _v1.EnsureSize(2*maxD, true);
+      (void) _v2.EnsureSize(2*maxD, true);
+      CompareSequences(0, a._numLines, 0, b._numLines);
+   }
+
+private:
+   void CompareSequences(int32 aLo, int32 aHi, int32 bLo, int32 bHi)
+   {
+      // Common prefixes and suffixes are trivially matched, so there's no need to search them
+      while((aLo < aHi)&&(bLo < bHi)&&(_a[aLo]   == _b[bLo]))   {aLo++; bLo++;}
+      while((aLo < aHi)&&(bLo < bHi)&&(_a[aHi-1] == _b[bHi-1])) {aHi--; bHi--;}
+
+           if (aLo == aHi) {for (int32 j=bLo; j<bHi; j++) _changedB[j] = true;}
+      else if (bLo == bHi) {for (int32 i=aLo; i<aHi; i++) _changedA[i] = true;}
+      else
       {
-         ret += "-0x";
-         p   += 3;  // e.g. for -0x20 we should just skip it, as we can't expand negative addresses
+         int32 midA, midB;
+         if (FindMiddleSnake(aLo, aHi, bLo, bHi, midA, midB))
+         {
+            CompareSequences(aLo, midA, bLo, midB);
+            CompareSequences(midA, aHi, midB, bHi);
+         }
+         else
+         {
+            // No lines in common at all
+            for (int32 i=aLo; i<aHi; i++) _changedA[i] = true;
+            for (int32 j=bLo; j<bHi; j++) _changedB[j] = true;
+         }
       }
-#ifdef __APPLE__
-      else if ((p[0] == '0')&&(p[1] == 'x'))
-#else
-      else if (((p[0] == '0')&&(p[1] == 'x')) || ((p[0] == ' ')&&(IsHexChar(p[1]))))
-#endif
+   }
+
+   /** Searches forwards and backwards at once until the two searches overlap; the overlap-point is where we split the problem */
+   bool FindMiddleSnake(int32 aLo, int32 aHi, int32 bLo, int32 bHi, int32 & retMidA, int32 & retMidB)
+   {
+      const int32 n = aHi-aLo;
+      const int32 m = bHi-bLo;
+      const int32 maxD    = (n+m+1)/2;
+      const int32 vOffset = maxD;
+      const int32 vLength = 2*maxD;
+      for (int32 i=0; i<vLength; i++) _v1[i] = _v2[i] = -1;
+      _v1[vOffset+1] = 0;
+      _v2[vOffset+1] = 0;
+
+      const int32 delta = n-m;
+      const bool front  = ((delta % 2) != 0);  // if true, the forward path can be the first to overlap the reverse path
+      int32 k1Start = 0, k1End = 0, k2Start = 0, k2End = 0;
+      for (int32 d=0; d<maxD; d++)
       {
-         const int offset = ((p[1] == '0')&&(p[2] == 'x')) ? 3 : ((p[1] == 'x') ? 2 : 1);
-         const char * q = &p[offset];
+         for (int32 k1=-d+k1Start; k1<=d-k1End; k1+=2)
+         {
+            const int32 k1Offset = vOffset+k1;
+            int32 x1 = ((k1 == -d)||((k1 != d)&&(_v1[k1Offset-1] < _v1[k1Offset+1]))) ? _v1[k1Offset+1] : (_v1[k1Offset-1]+1);
+            int32 y1 = x1-k1;
+            while((x1 < n)&&(y1 < m)&&(_a[aLo+x1] == _b[bLo+y1])) {x1++; y1++;}
+            _v1[k1Offset] = x1;
+
+                 if (x1 > n) k1End   += 2;  // ran off the right edge of the graph
+            else if (y1 > m) k1Start += 2;  // ran off the bottom edge of the graph
+            else if (front)
+            {
+               const int32 k2Offset = vOffset+delta-k1;
+               if ((k2Offset >= 0)&&(k2Offset < vLength)&&(_v2[k2Offset] != -1)&&(x1 >= n-_v2[k2Offset]))
+               {
+                  retMidA = aLo+x1;
+                  retMidB = bLo+y1;
+                  return true;
+               }
+            }
+         }
+
+         for (int32 k2=-d+k2Start; k2<=d-k2End; k2+=2)
+         {
+            const int32 k2Offset = vOffset+k2;
+            int32 x2 = ((k2 == -d)||((k2 != d)&&(_v2[k2Offset-1] < _v2[k2Offset+1]))) ? _v2[k2Offset+1] : (_v2[k2Offset-1]+1);
+            int32 y2 = x2-k2;
+            while((x2 < n)&&(y2 < m)&&(_a[aHi-x2-1] == _b[bHi-y2-1])) {x2++; y2++;}
+            _v2[k2Offset] = x2;
+
+                 if (x2 > n) k2End   += 2;  // ran off the left edge of the graph
+            else if (y2 > m) k2Start += 2;  // ran off the top edge of the graph
+            else if (front == false)
+            {
+               const int32 k1Offset = vOffset+delta-k2;
+               if ((k1Offset >= 0)&&(k1Offset < vLength)&&(_v1[k1Offset] != -1))
+               {
+                  const int32 x1 = _v1[k1Offset];
+                  if (x1 >= n-x2)
+                  {
+                     retMidA = aLo+x1;
+                     retMidB = bLo+(x1-(k1Offset-vOffset));
+                     return true;
+                  }
+               }
+            }
+         }
+      }
+      return false;
+   }
+
+   const uint32 * _a;
+   Queue<bool> & _changedA;
+   const uint32 * _b;
+   Queue<bool> & _changedB;
+   Queue<int32> _v1, _v2;  // furthest-reaching x-positions, per diagonal (forward and reverse searches)
+};
+
+/** One run of changed lines:  lines [_aFrom, _aTo) of text A were replaced by lines [_bFrom, _bTo) of text B */
+class DiffHunk
+{
+public:
+   DiffHunk() : _aFrom(0), _aTo(0), _bFrom(0), _bTo(0) {/* empty */}
+   DiffHunk(uint32 aFrom, uint32 aTo, uint32 bFrom, uint32 bTo) : _aFrom(aFrom), _aTo(aTo), _bFrom(bFrom), _bTo(bTo) {/* empty */}
+
+   uint32 _aFrom;
+   uint32 _aTo;
+   uint32 _bFrom;
+   uint32 _bTo;
+};
+
+/** Computes the line-by-line differences between two symbols' texts.  Everything is done in memory; nothing gets forked. */
+class LineDiffs
+{
+public:
+   /** (lineTable) is the dictionary that both (linesA) and (linesB)'s IDs refer to */
+   LineDiffs(const LineIDSpan & linesA, const LineIDSpan & linesB, const LineTable & lineTable)
+   {
+      const uint32 numA = linesA._numLines;
+      const uint32 numB = linesB._numLines;
+      (void) _linesA.EnsureSize(numA);
+      (void) _linesB.EnsureSize(numB);
+      for (uint32 i=0; i<numA; i++) (void) _linesA.AddTail(lineTable.GetLine(linesA._ids[i]));
+      for (uint32 i=0; i<numB; i++) (void) _linesB.AddTail(lineTable.GetLine(linesB._ids[i]));
+
+      Queue<bool> changedA, changedB;
+      (void) changedA.EnsureSize(numA+1, true);  // +1 so that the loop below can always check one past the end
+      (void) changedB.EnsureSize(numB+1, true);
+      for (uint32 i=0; i<=numA; i++) changedA[i] = false;
+      for (uint32 i=0; i<=numB; i++) changedB[i] = false;
+      {
+         MyersDiff md(linesA, changedA, linesB, changedB);  // equal lines have equal IDs, so the diff algorithm only has to compare integers
+      }
+
+      // Walk the two sequences in parallel, making one hunk for each run of changed lines
+      uint32 i = 0, j = 0;
+      while((i < numA)||(j < numB))
+      {
+         if ((i < numA)&&(j < numB)&&(changedA[i] == false)&&(changedB[j] == false)) {i++; j++; continue;}
+
+         uint32 aEnd = i; while((aEnd < numA)&&(changedA[aEnd])) aEnd++;
+         uint32 bEnd = j; while((bEnd < numB)&&(changedB[bEnd])) bEnd++;
+         if (_hunks.AddTail(DiffHunk(i, aEnd, j, bEnd)) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+
+         i = aEnd;
+         j = bEnd;
+      }
+   }
+
+   Queue<TextSpan> _linesA;
+   Queue<TextSpan> _linesB;
+   Queue<DiffHunk> _hunks;
+};
+
+static void AppendCString(const char * s, TextArena & out) {(void) out.Append(s, (uint32) strlen(s));}
+static void AppendString(const String & s, TextArena & out) {(void) out.Append(s(), s.Length());}
+
+/** Appends the (numChars) chars at (chars) to (out) as a quoted JSON string */
+static void AppendJSONString(const char * chars, uint32 numChars, TextArena & out)
+{
+   (void) out.Append('"');
+   const char * runStart = chars;  // start of the characters that don't need escaping and haven't been appended yet
+   for (uint32 i=0; i<numChars; i++)
+   {
+      const unsigned char c = (unsigned char) chars[i];
+      if ((c == '"')||(c == '\\')||(c < 0x20))
+      {
+         (void) out.Append(runStart, (uint32)(&chars[i]-runStart));
+         runStart = &chars[i+1];
+
+         char buf[8];
+         if (c < 0x20) muscleSprintf(buf, "\\u%04x", c);
+                  else muscleSprintf(buf, "\\%c", c);
+         AppendCString(buf, out);
+      }
+   }
+   (void) out.Append(runStart, (uint32)((chars+numChars)-runStart));
+   (void) out.Append('"');
+}
+
+static void AppendLineRange(const char * linePrefix, const Queue<TextSpan> & lines, uint32 from, uint32 to, TextArena & out)
+{
+   for (uint32 i=from; i<to; i++)
+   {
+      const TextSpan & tl = lines[i];
+      AppendCString(linePrefix, out);
+      (void) out.Append(tl._chars, tl._length);
+      (void) out.Append('\n');
+   }
+}
+
+static void AppendLineNumberRange(uint32 from, uint32 to, TextArena & out)
+{
+   // (from) and (to) are zero-based and half-open; diff's output uses one-based inclusive ranges
+   char buf[32];
+   if ((to-from) > 1) muscleSprintf(buf, UINT32_FORMAT_SPEC "," UINT32_FORMAT_SPEC, from+1, to);
+                 else muscleSprintf(buf, UINT32_FORMAT_SPEC, (to > from) ? to : from);
+   AppendCString(buf, out);
+}
+
+/** Appends (diffs) to (out), in the same "normal" output format that `diff textA textB` would use */
+static void AppendNormalDiffs(const LineDiffs & diffs, TextArena & out)
+{
+   for (uint32 i=0; i<diffs._hunks.GetNumItems(); i++)
+   {
+      const DiffHunk & h = diffs._hunks[i];
+      AppendLineNumberRange(h._aFrom, h._aTo, out);
+      (void) out.Append((h._aTo == h._aFrom) ? 'a' : ((h._bTo == h._bFrom) ? 'd' : 'c'));
+      AppendLineNumberRange(h._bFrom, h._bTo, out);
+      (void) out.Append('\n');
+
+      AppendLineRange("< ", diffs._linesA, h._aFrom, h._aTo, out);
+      if ((h._aTo > h._aFrom)&&(h._bTo > h._bFrom)) AppendCString("---\n", out);
+      AppendLineRange("> ", diffs._linesB, h._bFrom, h._bTo, out);
+   }
+}
+
+static void AppendSymbolDiffs(const String & symbolName, const LineDiffs & diffs, TextArena & out)
+{
+   AppendCString("\n\n===================== Diffs for [", out);
+   AppendString(symbolName, out);
+   AppendCString("]:\n", out);
+   AppendNormalDiffs(diffs, out);
+   (void) out.Append('\n');
+}
+
+static bool IsHexChar(char c)
+{
+   return muscleInRange(c, '0', '9') ||
+          muscleInRange(c, 'A', 'F') ||
+          muscleInRange(c, 'a', 'f');
+}
+
+/** Returns a pointer to the first char in the range [p, end) that is equal to (c1), (c2), (c3) or (c4), or (end) if there isn't one.
+  * The sanitizing code uses this to skip over the (usually long) runs of characters it doesn't need to look at, so it
+  * checks 32 (AVX2) or 16 (SSE2) chars at a time when it can.  Pass the same char more than once if you need fewer than four.
+  */
+static inline const char * FindFirstOf(const char * p, const char * end, char c1, char c2, char c3, char c4)
+{
+#if defined(__AVX2__)
+   const __m256i v1 = _mm256_set1_epi8(c1), v2 = _mm256_set1_epi8(c2), v3 = _mm256_set1_epi8(c3), v4 = _mm256_set1_epi8(c4);
+   while((end-p) >= 32)
+   {
+      const __m256i v = _mm256_loadu_si256((const __m256i *) p);
+      const uint32 mask = (uint32) _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, v1), _mm256_cmpeq_epi8(v, v2)), _mm256_or_si256(_mm256_cmpeq_epi8(v, v3), _mm256_cmpeq_epi8(v, v4))));
+      if (mask) return p+__builtin_ctz(mask);
+      p += 32;
+   }
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+   const __m128i w1 = _mm_set1_epi8(c1), w2 = _mm_set1_epi8(c2), w3 = _mm_set1_epi8(c3), w4 = _mm_set1_epi8(c4);
+   while((end-p) >= 16)
+   {
+      const __m128i w = _mm_loadu_si128((const __m128i *) p);
+      const uint32 mask = (uint32) _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(w, w1), _mm_cmpeq_epi8(w, w2)), _mm_or_si128(_mm_cmpeq_epi8(w, w3), _mm_cmpeq_epi8(w, w4))));
+      if (mask) return p+__builtin_ctz(mask);
+      p += 16;
+   }
+#endif
+   while((p < end)&&(*p != c1)&&(*p != c2)&&(*p != c3)&&(*p != c4)) p++;  // scalar fallback, and the last few chars
+   return p;
+}
+
+/** A small direct-mapped cache of recent AddressIndex lookups.  The same few target addresses
+  * (e.g. hot callees) tend to get looked up over and over again, so most lookups get answered from here.
+  * Each thread should use its own cache, since the cache is modified by lookups.
+  */
+class AddressLookupCache : public RefCountable
+{
+public:
+   enum {NUM_SLOTS = 4096};  // must be a power of two
+
+   AddressLookupCache() {Clear();}
+
+   void Clear() {for (uint32 i=0; i<NUM_SLOTS; i++) _slots[i]._entryIdx = NOT_CACHED;}
+
+private:
+   friend class AddressIndex;
+
+   enum {
+      NOT_CACHED = -2,
+      NOT_FOUND  = -1
+   };
+
+   static uint32 GetSlotIndex(uint64 addr) {return (uint32)((addr*11400714819323198485ULL)>>52) & (NUM_SLOTS-1);}
+
+   class Slot
+   {
+   public:
+      uint64 _addr;
+      int32 _entryIdx;  // NOT_CACHED, NOT_FOUND, or the index of the AddressIndex entry that contains _addr
+   };
+   Slot _slots[NUM_SLOTS];
+};
+DECLARE_REFTYPES(AddressLookupCache);
+
+/** A compact, flat index of symbol address-ranges, used to find which symbol (if any) contains a given address.
+  * The start-addresses are kept in their own array so that the binary search touches as little memory as possible,
+  * and the index holds only addresses, lengths and name-IDs -- none of the symbols' text.
+  */
+class AddressIndex
+{
+public:
+   AddressIndex() : _starts(NULL), _lengths(NULL), _nameIDs(NULL), _numEntries(0) {/* empty */}
+   ~AddressIndex() {Clear();}
+
+   /** Rebuilds the index from (symbols), which must already be sorted by start-address.
+     * The index refers to (symbols)'s keys, so (symbols) must not be modified while the index is in use.
+     */
+   status_t SetSymbols(const Hashtable<String, SymbolRecord> & symbols)
+   {
+      Clear();
+
+      const uint32 numSymbols = symbols.GetNumItems();
+      _starts  = newnothrow_array(uint64, numSymbols);
+      _lengths = newnothrow_array(uint64, numSymbols);
+      _nameIDs = newnothrow_array(uint32, numSymbols);
+      if ((_starts == NULL)||(_lengths == NULL)||(_nameIDs == NULL)||(_names.EnsureSize(numSymbols) != B_NO_ERROR))
+      {
+         WARN_OUT_OF_MEMORY;
+         Clear();
+         return B_ERROR;
+      }
+
+      for (HashtableIterator<String, SymbolRecord> iter(symbols); iter.HasData(); iter++)
+      {
+         _starts[_numEntries]  = iter.GetValue()._startAddress;
+         _lengths[_numEntries] = iter.GetValue()._length;
+         _nameIDs[_numEntries] = _names.GetNumItems();
+         (void) _names.AddTail(&iter.GetKey());
+         _numEntries++;
+      }
+      return B_NO_ERROR;
+   }
+
+   void Clear()
+   {
+      delete [] _starts;  _starts  = NULL;
+      delete [] _lengths; _lengths = NULL;
+      delete [] _nameIDs; _nameIDs = NULL;
+      _numEntries = 0;
+      _names.Clear();
+   }
+
+   /** Returns the name of the symbol whose address-range contains (addr), or NULL if there isn't one.
+     * @param addr the address to look up
+     * @param optCache if non-NULL, a cache to consult (and update) before doing the binary search
+     */
+   const String * GetSymbolNameForAddress(uint64 addr, AddressLookupCache * optCache) const
+   {
+      AddressLookupCache::Slot * slot = optCache ? &optCache->_slots[AddressLookupCache::GetSlotIndex(addr)] : NULL;
+      int32 entryIdx;
+      if ((slot)&&(slot->_entryIdx != AddressLookupCache::NOT_CACHED)&&(slot->_addr == addr)) entryIdx = slot->_entryIdx;
+      else
+      {
+         entryIdx = FindEntryIndex(addr);
+         if (slot)
+         {
+            slot->_addr     = addr;
+            slot->_entryIdx = entryIdx;
+         }
+      }
+      return (entryIdx >= 0) ? _names[_nameIDs[entryIdx]] : NULL;
+   }
+
+   uint32 GetNumEntries() const {return _numEntries;}
+
+private:
+   AddressIndex(const AddressIndex &);              // deliberately unimplemented
+   AddressIndex & operator=(const AddressIndex &);  // deliberately unimplemented
+
+   /** Returns the index of the entry whose address-range contains (addr), or -1 if there isn't one */
+   int32 FindEntryIndex(uint64 addr) const
+   {
+      if ((_numEntries == 0)||(addr < _starts[0])) return AddressLookupCache::NOT_FOUND;
+
+      // Branch-free binary search for the last entry whose start-address is <= (addr)
+      const uint64 * base = _starts;
+      uint32 n = _numEntries;
+      while(n > 1)
+      {
+         const uint32 half = n/2;
+         base = (base[half] <= addr) ? (base+half) : base;
+         n -= half;
+      }
+
+      const uint32 idx = (uint32)(base-_starts);
+      return ((addr-_starts[idx]) < _lengths[idx]) ? (int32)idx : AddressLookupCache::NOT_FOUND;
+   }
+
+   uint64 * _starts;   // sorted start-address of each entry
+   uint64 * _lengths;  // length (in bytes) of each entry
+   uint32 * _nameIDs;  // index into (_names) of each entry's symbol name
+   uint32 _numEntries;
+   Queue<const String *> _names;
+};
+
+/** A contiguous range of read-only data (e.g. the .rodata section) in an executable's address space */
+class ReadOnlyDataRegion
+{
+public:
+   ReadOnlyDataRegion() : _address(0), _data(NULL), _numBytes(0) {/* empty */}
+   ReadOnlyDataRegion(uint64 address, const uint8 * data, uint64 numBytes) : _address(address), _data(data), _numBytes(numBytes) {/* empty */}
+
+   uint64 _address;      // the address the region's first byte gets loaded at
+   const uint8 * _data;  // points to the region's bytes (typically inside a memory-mapped executable file)
+   uint64 _numBytes;     // the number of bytes in the region
+};
+
+class CompareRegionAddressesFunctor
+{
+public:
+   CompareRegionAddressesFunctor() {/* empty */}
+
+   int Compare(const ReadOnlyDataRegion & r1, const ReadOnlyDataRegion & r2, void *) const {return muscleCompare(r1._address, r2._address);}
+};
+
+/** The set of read-only data regions of an executable, sorted by address so that they can be searched quickly */
+class ReadOnlyData
+{
+public:
+   ReadOnlyData() {/* empty */}
+
+   status_t AddRegion(const ReadOnlyDataRegion & region)
+   {
+      if (_regions.AddTail(region) != B_NO_ERROR) return B_ERROR;
+      _regions.Sort(CompareRegionAddressesFunctor());
+      return B_NO_ERROR;
+   }
+
+   /** Returns the region that contains (addr), or NULL if (addr) isn't in any of our regions */
+   const ReadOnlyDataRegion * GetRegionContaining(uint64 addr) const
+   {
+      uint32 lo = 0, hi = _regions.GetNumItems();
+      while(lo < hi)
+      {
+         const uint32 mid = (lo+hi)/2;
+         if (addr < _regions[mid]._address) hi = mid;
+                                       else lo = mid+1;
+      }
+      if (lo == 0) return NULL;
+
+      const ReadOnlyDataRegion & r = _regions[lo-1];
+      return ((addr-r._address) < r._numBytes) ? &r : NULL;
+   }
+
+   bool HasRegions() const {return _regions.HasItems();}
+
+private:
+   Queue<ReadOnlyDataRegion> _regions;
+};
+
+/** Returns true iff the 8 bytes pointed to by (s) end in four or more 0-bytes
+  * 4-byte integers placed into 8-byte fields seem to occur a lot in the .rodata
+  * section; I'm not sure what they are but they appear to be some kind of address
+  * offset so I'm going to ignore them as a false-positive.  -jaf
+  */
+static bool IsOffset(const uint8 * s, uint64 numBytesAvailable)
+{
+   if (numBytesAvailable < 8) return false;
+   for (int i=4; i<8; i++) if (s[i] != 0) return false;
+   return true;
+}
+
+enum {
+   DEFERRED_ADDRESS_BEGIN = 0x01,  // marks the start of an address whose symbol-name hasn't been looked up yet
+   DEFERRED_ADDRESS_END   = 0x02   // marks the end of it (a BEGIN immediately followed by an END represents a literal BEGIN character)
+};
+
+/** Appends (c) to (out), escaping it if necessary so that it won't be mistaken for a deferred address */
+static void AppendLiteralChar(char c, TextArena & out)
+{
+   (void) out.Append(c);
+   if (c == DEFERRED_ADDRESS_BEGIN) (void) out.Append((char) DEFERRED_ADDRESS_END);
+}
+
+/** Appends to (out) a position-independent representation of the read-only data (e.g. the string literal) that (addr)
+  * points to and returns true, or returns false if (addr) doesn't point into a read-only data section.
+  * Note that the literal is re-scanned every time it is referenced, rather than being looked up in a table of already-expanded
+  * literals:  that allocates nothing, and the vectorized scan of a typical literal costs less than a hash-table lookup would
+  * (and in real executables, each literal is only referenced a couple of times on average anyway).
+  */
+static bool AppendReadOnlyDataString(uint64 addr, const ReadOnlyData * optROData, TextArena & out)
+{
+   // For Linux/objdump:  If addr points to inside a read-only data section, return the literal-string it points to
+   const ReadOnlyDataRegion * roRegion = optROData ? optROData->GetRegionContaining(addr) : NULL;
+   if (roRegion == NULL) return false;
+
+   const uint8 * s = roRegion->_data+(addr-roRegion->_address);
+   const uint64 numBytesLeft = roRegion->_numBytes-(addr-roRegion->_address);
+   if (IsOffset(s, numBytesLeft)) (void) out.Append("{(offset)}", 10);
+   else
+   {
+      (void) out.Append('{');
+      const char * p   = (const char *) s;
+      const char * end = p+numBytesLeft;
+      while(p < end)
+      {
+         const char * q = FindFirstOf(p, end, '\0', '\n', DEFERRED_ADDRESS_BEGIN, DEFERRED_ADDRESS_BEGIN);
+         (void) out.Append(p, (uint32)(q-p));
+         if ((q == end)||(*q == '\0')) break;
+
+         if (*q == '\n') (void) out.Append("\\n", 2);  // newlines mess with the diff output, otherwise
+                     else AppendLiteralChar(*q, out);
+         p = q+1;
+      }
+      (void) out.Append('}');
+   }
+   return true;
+}
+
+/** Given a pointer to an address-string that SanitizeLine() recognized (e.g. " 4137ac" or "0x4137ac"), returns the offset of its first hex digit */
+static int GetHexDigitsOffset(const char * p) {return ((p[1] == '0')&&(p[2] == 'x')) ? 3 : ((p[1] == 'x') ? 2 : 1);}
+
+/** Does the first stage of sanitizing one line of disassembly, appending the result to (out).  Addresses of read-only data get
+  * expanded into the literals they point to, but since symbol-names can't be looked up until all of the symbols have been parsed,
+  * any other addresses are only marked (see DEFERRED_ADDRESS_BEGIN), to be looked up later by ResolveSanitizedLine().
+  * (line) must be NUL-terminated (i.e. line[lineLength] must be 0).
+  */
+static void SanitizeLine(const char * line, uint32 lineLength, const ReadOnlyData * optROData, TextArena & out)
+{
+   const char * p   = line;
+   const char * end = line+lineLength;
+   while(p < end)
+   {
+      // Only these chars can start something that needs handling; everything before the next one gets copied as-is
+#ifdef __APPLE__
+      const char * q = FindFirstOf(p, end, '-', '0', DEFERRED_ADDRESS_BEGIN, DEFERRED_ADDRESS_BEGIN);
+#else
+      const char * q = FindFirstOf(p, end, '-', '0', ' ', DEFERRED_ADDRESS_BEGIN);
+#endif
+      (void) out.Append(p, (uint32)(q-p));
+      p = q;
+      if (p == end) break;
+
+      if ((p[0] == '-')&&(p[1] == '0')&&(p[2] == 'x')) 
+      {
+         (void) out.Append("-0x", 3);
+         p += 3;  // e.g. for -0x20 we should just skip it, as we can't expand negative addresses
+      }
+#ifdef __APPLE__
+      else if ((p[0] == '0')&&(p[1] == 'x'))
+#else
+      else if (((p[0] == '0')&&(p[1] == 'x')) || ((p[0] == ' ')&&(IsHexChar(p[1]))))
+#endif
+      {
+         const int offset = GetHexDigitsOffset(p);
+         const char * q = &p[offset];
+
+         while(IsHexChar(*q)) q++;
+         const uint64 addr = Atoxll(&p[offset]);
+
+         if (AppendReadOnlyDataString(addr, optROData, out) == false)
+         {
+            (void) out.Append((char) DEFERRED_ADDRESS_BEGIN);
+            (void) out.Append(p, (uint32)(q-p));
+            (void) out.Append((char) DEFERRED_ADDRESS_END);
+         }
+         p = q;
+      }
+      else AppendLiteralChar(*p++, out);
+   }
+}
+
+/** Does the second stage of sanitizing one line of disassembly (as produced by SanitizeLine()):  each marked address is
+  * replaced with the name of the symbol it points into, and address indicators like "<main+0x9b6>" are trimmed down to just "<main>".
+  */
+static void ResolveSanitizedLine(const char * line, uint32 lineLength, String & ret, const AddressIndex & index, AddressLookupCache * optCache)
+{
+   ret.Clear();
+
+   const char * p   = line;
+   const char * end = line+lineLength;
+   while(p < end)
+   {
+      if (*p != DEFERRED_ADDRESS_BEGIN) ret += *p++;
+      else
+      {
+         const char * addrStr = ++p;  // the address's original text, e.g. " 4137ac"
+         while((p < end)&&(*p != DEFERRED_ADDRESS_END)) p++;
+         if (p == addrStr) ret += (char) DEFERRED_ADDRESS_BEGIN;  // it was just an escaped literal character
+         else
+         {
+            const String * symbolName = index.GetSymbolNameForAddress(Atoxll(&addrStr[GetHexDigitsOffset(addrStr)]), optCache);
+            if (symbolName) ret += *symbolName;  // we inserted our expanded (symbol-relative) representation
+                       else while(addrStr < p) ret += *addrStr++;  // lookup failed?  Then leave it as-is (it's probably a numeric constant)
+         }
+         p++;  // skip past the END marker
+      }
+   }
+
+   if (ret.EndsWith('>'))
+   {
+      // Neutralize any address indicators like "<main+0x9b6>" down to just "<main>"
+      const int32 ob = ret.LastIndexOf('<');
+      const int32 pb = (ob >= 0) ? ret.LastIndexOf('+') : -1;
+      if (pb > ob) ret = ret.Substring(0, pb) + ">";  // remove the "+09b6" part
+   }
+}
+
+// Replaces any obvious addresses with a fixed dummy-string, to avoid false-positive diffs (first stage; see SanitizeLine()).
+// (rawText) must consist of NUL-terminated lines (as written by AppendRawLine()); the sanitized
+// text is written into (outArena) as newline-terminated lines, and its span is returned.
+static TextSpan SanitizeAddresses(const TextSpan & rawText, const ReadOnlyData * optROData, TextArena & outArena)
+{
+   outArena.BeginSpan();
+
+   const char * p   = rawText._chars;
+   const char * end = rawText._chars+rawText._length;
+   while(p < end)
+   {
+      const char * nul = (const char *) memchr(p, '\0', end-p);
+      const uint32 lineLength = (uint32)((nul ? nul : end)-p);
+      if (lineLength > 0)  // empty lines are dropped
+      {
+         SanitizeLine(p, lineLength, optROData, outArena);
+         if (outArena.Append('\n') != B_NO_ERROR) break;
+      }
+      p += lineLength+1;
+   }
+
+   return outArena.EndSpan();
+}
+
+// Second stage of SanitizeAddresses():  resolves the deferred addresses in (text), and appends the ID (in (lineTable))
+// of each resolved line to (outArena).  Returns the span of IDs.
+static LineIDSpan ResolveSanitizedText(const TextSpan & text, const AddressIndex & index, LineTable & lineTable, AddressLookupCache * optCache, LineIDCache * optLineCache, String & scratchStr, TextArena & outArena)
+{
+   outArena.BeginSpan();
+
+   const char * p   = text._chars;
+   const char * end = text._chars+text._length;
+   while(p < end)
+   {
+      const char * nl = (const char *) memchr(p, '\n', end-p);
+      const uint32 lineLength = (uint32)((nl ? nl : end)-p);
+      uint32 lineID;
+      if ((memchr(p, DEFERRED_ADDRESS_BEGIN, lineLength) == NULL)&&((lineLength == 0)||(p[lineLength-1] != '>'))) lineID = lineTable.GetLineID(p, lineLength, optLineCache);  // nothing to resolve
+      else
+      {
+         ResolveSanitizedLine(p, lineLength, scratchStr, index, optCache);
+         lineID = lineTable.GetLineID(scratchStr(), scratchStr.Length(), optLineCache);
+      }
+      if (AppendLineID(lineID, outArena) != B_NO_ERROR) break;
+      p += lineLength+1;
+   }
+
+   return LineIDSpan(outArena.EndSpan());
+}
+
+static uint32 GetHexLength(const char * p)
+{
+   uint32 count = 0;
+   while(IsHexChar(*p)) {count++; p++;}
+   return count;
+}
+
+static bool IsPointerOrOffset(const char * s)
+{
+   const uint32 hexLength = GetHexLength(s);
+   return ((hexLength >= 4)||(strncmp(&s[hexLength], "(%r", 3) == 0));
+}
+
+/** Returns true iff (line) (which must be NUL-terminated at (end)) contains "0x" anywhere */
+static bool ContainsHexPrefix(const char * line, const char * end)
+{
+   for (const char * p=line; (p=FindFirstOf(p, end, '0', '0', '0', '0')) < end; p++) if (p[1] == 'x') return true;
+   return false;
+}
+
+// Appends (line) (which must be NUL-terminated) to (arena), replacing any obvious addresses
+// with a fixed dummy-string, to avoid false-positive diffs
+static void AppendWithNeutralizedAddresses(const char * line, uint32 lineLength, TextArena & arena)
+{
+   // Find any hex values starting with 0x, and replace the hex-number with "?", to avoid pointless diffs
+   const char * end = line+lineLength;
+   if (ContainsHexPrefix(line, end) == false) {(void) arena.Append(line, lineLength); return;}
+
+   const char * runStart = line;  // start of the characters we haven't appended yet
+   const char * in       = line;
+   while((in = FindFirstOf(in, end, '0', '#', '0', '#')) < end)  // only these chars can start an address
+   {
+#ifdef __APPLE__
+      if ((in[0] == '0')&&(in[1] == 'x')&&(IsPointerOrOffset(&in[2])))
+#else
+      if (((in[0] == '0')&&(in[1] == 'x')&&(IsPointerOrOffset(&in[2]))) ||
+          ((in[0] == '#')&&(in[1] == ' ')&&(IsPointerOrOffset(&in[2]))))
+#endif
+      {
+         (void) arena.Append(runStart, (uint32)(in-runStart));
+         (void) arena.Append("0x?", 3);
+
+         in += 2;
+         while(IsHexChar(*in)) in++;
+         runStart = in;
+         if (in < end) in++;  // the character after the hex-number is always kept as-is
+      }
+      else in++;
+   }
+   (void) arena.Append(runStart, (uint32)(end-runStart));
+}
+
+/** Appends (line) (plus (optSuffix), if specified) to the current span of (rawArena), NUL-terminated,
+  * so that SanitizeAddresses() can later parse it in-place.
+  */
+static void AppendRawLine(const char * line, uint32 lineLength, bool neutralize, TextArena & rawArena, const char * optSuffix = NULL)
+{
+   if (neutralize) AppendWithNeutralizedAddresses(line, lineLength, rawArena);
+              else (void) rawArena.Append(line, lineLength);
+   if (optSuffix) (void) rawArena.Append(optSuffix, (uint32) strlen(optSuffix));
+   (void) rawArena.Append('\0');
+}
+
+static String GetUniqueSymbolName(const String & symbolName, const Hashtable<String, SymbolRecord> & symbols)
+{
+   String s = symbolName + "#0";
+   while(symbols.ContainsKey(s))
+   {
+      uint32 suffix = 0;
+      s = s.WithoutNumericSuffix(&suffix);
+      s += String("%1").Arg(suffix+1);
+   }
+   return s;
+}
+
+class CompareStartAddressesFunctor 
+{
+public:
+   CompareStartAddressesFunctor() {/* empty */}
+
+   // Symbols that start at the same address keep their existing (i.e. parse) order, since the sort is stable
+   int Compare(const SymbolRecord & r1, const SymbolRecord & r2, void *) const {return muscleCompare(r1._startAddress, r2._startAddress);}
+};
+
+/** Since more than one executable may be parsed at once, their \r-terminated progress-lines
+  * would overwrite each other if they were printed directly.  This class instead collects the
+  * current status of each parse (keyed by its label) and prints them all together on one line.
+  */
+class ProgressDisplay
+{
+public:
+   ProgressDisplay() : _lastLineLength(0) {/* empty */}
+
+   /** Updates the status-text shown for (label) and reprints the progress-line */
+   void SetStatus(const String & label, const String & status)
+   {
+      MutexGuard mg(_mutex);
+      (void) _statuses.Put(label, status);
+
+      String line;
+      for (HashtableIterator<String, String> iter(_statuses); iter.HasData(); iter++)
+      {
+         if (line.HasChars()) line += " | ";
+         line += String("[%1] %2").Arg(iter.GetKey()).Arg(iter.GetValue());
+      }
+
+      const uint32 lineLength = line.Length();
+      while(line.Length() < _lastLineLength) line += ' ';  // make sure we overwrite any leftover characters from the previous line
+      _lastLineLength = lineLength;
+
+      LogTime(MUSCLE_LOG_INFO, "%s\r", line());
+   }
+
+   /** Leaves the current progress-line visible, and stops displaying status for (label) */
+   void FinishStatus(const String & label)
+   {
+      MutexGuard mg(_mutex);
+      EndStatusLine();
+      (void) _statuses.Remove(label);
+   }
+
+   /** Prints a regular (newline-terminated) message without garbling the progress-line */
+   void LogMessage(int logLevel, const String & message)
+   {
+      MutexGuard mg(_mutex);
+      EndStatusLine();
+      LogTime(logLevel, "%s\n", message());
+   }
+
+private:
+   void EndStatusLine()
+   {
+      if (_lastLineLength > 0)
+      {
+         printf("\n");
+         _lastLineLength = 0;
+      }
+   }
+
+   Mutex _mutex;
+   Hashtable<String, String> _statuses;
+   uint32 _lastLineLength;
+};
+static ProgressDisplay _progressDisplay;
+
+static void PrintSanitizerStatus(const char * label, uint32 count, uint32 total)
+{
+   char buf[128];
+   muscleSprintf(buf, "Reconstructing symbol addresses: " UINT32_FORMAT_SPEC "/" UINT32_FORMAT_SPEC " (%.0f%%)...", count, total, (100.0f*count)/total);
+   _progressDisplay.SetStatus(label, buf);
+}
+
+static void PrintParseStatus(const char * label, const char * toolName, uint32 lineNumber, uint32 numSymbols)
+{
+   char buf[128];
+   muscleSprintf(buf, "Parsing %s output: " UINT32_FORMAT_SPEC " lines (" UINT32_FORMAT_SPEC " symbols) ...", toolName, lineNumber, numSymbols);
+   _progressDisplay.SetStatus(label, buf);
+}
+
+#ifdef EXECUTABLE_DIFF_COUNT_ALLOCATIONS
+// The benchmark harness (see executable_diff_bench.cpp) defines EXECUTABLE_DIFF_COUNT_ALLOCATIONS, so that every heap allocation the
+// process makes gets counted here, and it can report how many each phase made.  The count is spread across several cache-line-sized
+// slots (each thread uses its own slot), so that threads that allocate at the same time don't all contend for a single cache line.
+// executable_diff itself leaves the allocator alone.
+enum {NUM_ALLOCATION_COUNTER_SLOTS = 64};
+
+struct AllocationCounterSlot
+{
+   uint64 _count;
+   char _padding[64-sizeof(uint64)];
+};
+static AllocationCounterSlot _allocationCounterSlots[NUM_ALLOCATION_COUNTER_SLOTS];
+static uint32 _nextAllocationCounterSlot = 0;
+static __thread uint32 _allocationCounterSlot = 0;  // this thread's slot index, plus one (or zero if it hasn't been assigned one yet)
+static bool _countAllocations = false;              // set by EnableAllocationCounting(), before any other threads are started
+
+static inline void CountAllocation()
+{
+   if (_countAllocations == false) return;
+   if (_allocationCounterSlot == 0) _allocationCounterSlot = (__sync_fetch_and_add(&_nextAllocationCounterSlot, 1)%NUM_ALLOCATION_COUNTER_SLOTS)+1;
+   (void) __sync_fetch_and_add(&_allocationCounterSlots[_allocationCounterSlot-1]._count, 1);
+}
+
+/** Starts counting heap allocations.  Must be called before any other threads are started. */
+static void EnableAllocationCounting() {_countAllocations = true;}
+
+/** Returns the number of heap allocations counted so far */
+static uint64 GetNumAllocations()
+{
+   uint64 ret = 0;
+   for (uint32 i=0; i<NUM_ALLOCATION_COUNTER_SLOTS; i++) ret += __sync_fetch_and_add(&_allocationCounterSlots[i]._count, 0);
+   return ret;
+}
+
+#if defined(__SANITIZE_ADDRESS__)
+// AddressSanitizer supplies its own allocator, so we leave the allocation functions alone (and don't count anything)
+#elif defined(__GLIBC__)
+// Under glibc we can count malloc() calls directly, which catches the muscle Strings' buffers as well as operator new
+extern "C" {
+extern void * __libc_malloc(size_t numBytes);
+extern void * __libc_calloc(size_t numItems, size_t itemSize);
+extern void * __libc_realloc(void * ptr, size_t numBytes);
+extern void __libc_free(void * ptr);
+
+void * malloc(size_t numBytes) {CountAllocation(); return __libc_malloc(numBytes);}
+void * calloc(size_t numItems, size_t itemSize) {CountAllocation(); return __libc_calloc(numItems, itemSize);}
+void * realloc(void * ptr, size_t numBytes) {CountAllocation(); return __libc_realloc(ptr, numBytes);}
+void free(void * ptr) {__libc_free(ptr);}
+}
+#else
+// Elsewhere, we count only the allocations made via operator new (which includes newnothrow)
+void * operator new(size_t numBytes)
+{
+   CountAllocation();
+   void * ret = malloc(numBytes);
+   if (ret == NULL) throw std::bad_alloc();
+   return ret;
+}
+void * operator new[](size_t numBytes) {return operator new(numBytes);}
+void * operator new(size_t numBytes, const std::nothrow_t &) throw() {CountAllocation(); return malloc(numBytes);}
+void * operator new[](size_t numBytes, const std::nothrow_t &) throw() {CountAllocation(); return malloc(numBytes);}
+void operator delete(void * ptr) throw() {free(ptr);}
+void operator delete[](void * ptr) throw() {free(ptr);}
+void operator delete(void * ptr, const std::nothrow_t &) throw() {free(ptr);}
+void operator delete[](void * ptr, const std::nothrow_t &) throw() {free(ptr);}
+#endif
+
+#else
+static uint64 GetNumAllocations() {return 0;}  // allocations aren't counted (see above)
+#endif
+
+/** Returns the process's peak RSS (in bytes) so far */
+static uint64 GetPeakMemoryUsage()
+{
+#ifndef __APPLE__
+   // Linux's VmHWM can be reset (see the benchmark harness), whereas ru_maxrss can't, so we prefer VmHWM
+   FILE * fp = fopen("/proc/self/status", "r");
+   if (fp)
+   {
+      char buf[256];
+      while(fgets(buf, sizeof(buf), fp))
+      {
+         if (strncmp(buf, "VmHWM:", 6) == 0)
+         {
+            fclose(fp);
+            return ((uint64) atoll(&buf[6]))*1024;  // VmHWM is given in kilobytes
+         }
+      }
+      fclose(fp);
+   }
+#endif
+
+   struct rusage ru;
+   if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+   return (uint64) ru.ru_maxrss;  // already in bytes
+#else
+   return ((uint64) ru.ru_maxrss)*1024;
+#endif
+}
+
+/** Returns the CPU time (user plus system, in microseconds) used so far by all of this process's threads, or
+  * (if (children) is true) by all of its child processes (e.g. objdump) that have exited and been waited for.
+  */
+static uint64 GetCPUTimeMicros(bool children)
+{
+   struct rusage ru;
+   if (getrusage(children ? RUSAGE_CHILDREN : RUSAGE_SELF, &ru) != 0) return 0;
+   return ((((uint64) ru.ru_utime.tv_sec)+ru.ru_stime.tv_sec)*1000000)+ru.ru_utime.tv_usec+ru.ru_stime.tv_usec;
+}
+
+/** The resources used by one phase of a run (see --stats).  Since several phases may run at once (e.g. when both
+  * executables are parsed concurrently), the CPU times, allocation counts and peak RSS are process-wide figures:
+  * e.g. the CPU time of A's "disassemble" phase includes the CPU time that B's parse used meanwhile.
+  */
+class PhaseStats
+{
+public:
+   PhaseStats() : _startMicros(0), _wallMicros(0), _cpuMicros(0), _childCPUMicros(0), _numBytesRead(0), _numLines(0), _numSymbols(0), _numAllocations(0), _numSubprocesses(0), _peakMemoryUsage(0) {/* empty */}
+
+   String _name;             // what the phase did, e.g. "disassemble"
+   String _label;            // the executable the phase was working on (e.g. "A"), or empty if it wasn't specific to one
+   uint64 _startMicros;      // when the phase started, relative to the start of the run
+   uint64 _wallMicros;       // how long the phase took
+   uint64 _cpuMicros;        // CPU time used by this process during the phase
+   uint64 _childCPUMicros;   // CPU time used by child processes that finished during the phase
+   uint64 _numBytesRead;     // bytes of input read (e.g. from the disassembler's pipe)
+   uint64 _numLines;         // lines of input parsed
+   uint64 _numSymbols;       // symbols processed
+   uint64 _numAllocations;   // heap allocations made during the phase (only counted when EXECUTABLE_DIFF_COUNT_ALLOCATIONS is defined)
+   uint64 _numSubprocesses;  // child processes launched
+   uint64 _peakMemoryUsage;  // the process's peak RSS (in bytes) as of the end of the phase
+};
+
+/** Collects the PhaseStats of a run, and writes them out as JSON (see --stats).  Phases may be added by any thread. */
+class RunStats
+{
+public:
+   RunStats() : _startTime(GetRunTime64()) {/* empty */}
+
+   uint64 GetStartTime() const {return _startTime;}
+
+   void AddPhase(const PhaseStats & phase)
+   {
+      MutexGuard mg(_mutex);
+      if (_phases.AddTail(phase) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+   }
+
+   const Queue<PhaseStats> & GetPhases() const {return _phases;}
+
+   /** Writes our phases to (fileName) as a JSON object.  (executables) are the paths of the executables that were compared. */
+   status_t WriteJSONFile(const String & fileName, const Queue<String> & executables) const
+   {
+      FILE * fpOut = fopen(fileName(), "w");
+      if (fpOut == NULL) return B_ERROR;
+
+      MutexGuard mg(_mutex);
+      fprintf(fpOut, "{\n  \"version\": 1,\n  \"executables\": [");
+      for (uint32 i=0; i<executables.GetNumItems(); i++)
+      {
+         if (i > 0) fprintf(fpOut, ", ");
+         WriteJSONString(executables[i], fpOut);
+      }
+      fprintf(fpOut, "],\n  \"phases\": [\n");
+      for (uint32 i=0; i<_phases.GetNumItems(); i++)
+      {
+         const PhaseStats & p = _phases[i];
+         fprintf(fpOut, "    {\"name\": ");
+         WriteJSONString(p._name, fpOut);
+         fprintf(fpOut, ", \"label\": ");
+         WriteJSONString(p._label, fpOut);
+         fprintf(fpOut, ", \"startSeconds\": %.6f, \"wallSeconds\": %.6f, \"cpuSeconds\": %.6f, \"childCpuSeconds\": %.6f", p._startMicros/1000000.0, p._wallMicros/1000000.0, p._cpuMicros/1000000.0, p._childCPUMicros/1000000.0);
+         fprintf(fpOut, ", \"bytesRead\": " UINT64_FORMAT_SPEC ", \"lines\": " UINT64_FORMAT_SPEC ", \"symbols\": " UINT64_FORMAT_SPEC, p._numBytesRead, p._numLines, p._numSymbols);
+#ifdef EXECUTABLE_DIFF_COUNT_ALLOCATIONS
+         fprintf(fpOut, ", \"allocations\": " UINT64_FORMAT_SPEC, p._numAllocations);
+#endif
+         fprintf(fpOut, ", \"subprocesses\": " UINT64_FORMAT_SPEC ", \"peakRssBytes\": " UINT64_FORMAT_SPEC "}%s\n", p._numSubprocesses, p._peakMemoryUsage, ((i+1) < _phases.GetNumItems()) ? "," : "");
+      }
+      fprintf(fpOut, "  ]\n}\n");
+      return (fclose(fpOut) == 0) ? B_NO_ERROR : B_ERROR;
+   }
+
+private:
+   RunStats(const RunStats &);  // deliberately unimplemented
+   RunStats & operator = (const RunStats &);  // deliberately unimplemented
+
+   static void WriteJSONString(const String & s, FILE * fpOut)
+   {
+      fputc('"', fpOut);
+      for (uint32 i=0; i<s.Length(); i++)
+      {
+         const unsigned char c = (unsigned char) s[i];
+              if ((c == '"')||(c == '\\')) fprintf(fpOut, "\\%c", c);
+         else if (c < 0x20)                fprintf(fpOut, "\\u%04x", c);
+         else                              fputc(c, fpOut);
+      }
+      fputc('"', fpOut);
+   }
+
+   mutable Mutex _mutex;
+   const uint64 _startTime;
+   Queue<PhaseStats> _phases;
+};
+
+/** Measures one phase of a run:  declare a PhaseRecorder when the phase starts, fill in the phase's counts via GetStats(),
+  * and the phase gets added to the RunStats when Finish() is called (or when the PhaseRecorder is destroyed, if that comes first).
+  * If no RunStats is given (i.e. --stats wasn't specified), nothing gets measured.
+  */
+class PhaseRecorder
+{
+public:
+   PhaseRecorder(RunStats * optStats, const char * name, const char * optLabel = NULL) : _optStats(optStats), _startTime(0), _startCPUMicros(0), _startChildCPUMicros(0), _startAllocations(0)
+   {
+      if (_optStats)
+      {
+         _stats._name  = name;
+         _stats._label = optLabel;
+
+         _startTime           = GetRunTime64();
+         _startCPUMicros      = GetCPUTimeMicros(false);
+         _startChildCPUMicros = GetCPUTimeMicros(true);
+         _startAllocations    = GetNumAllocations();
+         _stats._startMicros  = _startTime-_optStats->GetStartTime();
+      }
+   }
+
+   ~PhaseRecorder() {Finish();}
+
+   /** Returns the stats of the phase being recorded, so that the caller can fill in its counts */
+   PhaseStats & GetStats() {return _stats;}
+
+   /** Ends the phase, and adds its stats to our RunStats.  Only the first call does anything. */
+   void Finish()
+   {
+      if (_optStats == NULL) return;
+
+      _stats._wallMicros      = GetRunTime64()-_startTime;
+      _stats._cpuMicros       = GetCPUTimeMicros(false)-_startCPUMicros;
+      _stats._childCPUMicros  = GetCPUTimeMicros(true)-_startChildCPUMicros;
+      _stats._numAllocations  = GetNumAllocations()-_startAllocations;
+      _stats._peakMemoryUsage = GetPeakMemoryUsage();
+      _optStats->AddPhase(_stats);
+      _optStats = NULL;
+   }
+
+private:
+   PhaseRecorder(const PhaseRecorder &);  // deliberately unimplemented
+   PhaseRecorder & operator = (const PhaseRecorder &);  // deliberately unimplemented
+
+   RunStats * _optStats;
+   PhaseStats _stats;
+   uint64 _startTime;
+   uint64 _startCPUMicros;
+   uint64 _startChildCPUMicros;
+   uint64 _startAllocations;
+};
+
+class DisassemblyTargets;
+
+/** Settings that control how an executable file gets parsed */
+class ParseSettings
+{
+public:
+   ParseSettings() : _numDisassemblyJobs(1), _numSanitizerThreads(1), _cacheMaxBytes(0), _optTargets(NULL), _optStats(NULL), _optBaseline(NULL) {/* empty */}
+
+   uint32 _numDisassemblyJobs;   // how many disassembler processes may be run at once for a single executable (objdump only)
+   uint32 _numSanitizerThreads;  // how many threads may be used to sanitize a single executable's symbols
+   String _cacheDirectory;       // where to cache parsed symbol tables, or empty if caching is disabled
+   uint64 _cacheMaxBytes;        // if non-zero, the least recently used cache files get deleted whenever the cache gets bigger than this (see --cache-max-mb)
+   String _spillDirectory;       // if non-empty, symbols' text gets written to temporary files here rather than held in memory (see --low-memory)
+   const DisassemblyTargets * _optTargets;  // if non-NULL, only these functions get disassembled (objdump only; see --prefilter)
+   RunStats * _optStats;                    // if non-NULL, the resources used by each phase of the parse get recorded here (see --stats)
+   const Hashtable<String, SymbolRecord> * _optBaseline;  // if non-NULL, each symbol whose text matches its same-named counterpart's in here
+                                                          // just points to the counterpart's text, rather than storing its own (see --low-memory)
+   LineTableRef _lineTable;      // the dictionary to add the symbols' lines to; executables that will be compared against each other must use the same one
+                                 // (or an overlay of the other's).  If NULL, the executable gets a dictionary of its own.
+};
+
+/** Interface for a batch of independent tasks that may be executed in any order, by any thread */
+class AbstractParallelTasks
+{
+public:
+   AbstractParallelTasks() {/* empty */}
+   virtual ~AbstractParallelTasks() {/* empty */}
+
+   /** Called (by one of the worker threads) to execute the specified task.
+     * @param taskIdx index of the task to execute
+     * @param workerIdx index of the calling worker (useful for accessing per-thread scratch data)
+     */
+   virtual void ExecuteTask(uint32 taskIdx, uint32 workerIdx) = 0;
+
+   /** Called periodically (by one worker at a time) with the number of tasks that have been completed so far */
+   virtual void ReportProgress(uint32 /*numTasksCompleted*/, uint32 /*numTasks*/) {/* empty */}
+};
+
+/** Executes a batch of tasks on a set of worker threads.  Each worker has its own deque of tasks; it takes
+  * tasks from the front of its own deque, and when its deque is empty, it steals tasks from the back of
+  * other workers' deques.  That way a few very expensive tasks don't leave the other workers idle.
+  */
+class WorkStealingExecutor
+{
+public:
+   WorkStealingExecutor(AbstractParallelTasks & tasks) : _tasks(tasks), _numTasks(0), _lastProgressAt(0) {/* empty */}
+
+   /** Executes the specified tasks, and returns after they have all completed.  The calling thread acts as one of the workers.
+     * @param taskIndices the indices of the tasks to execute, ideally sorted from most to least expensive
+     * @param numWorkers how many threads (including the calling thread) should execute the tasks
+     * @param inOrder if true, the tasks are started strictly in the order given (from a single shared queue, with no stealing),
+     *                so that a task may block until the tasks before it have made progress (see OrderedChunkWriter)
+     */
+   void ExecuteTasks(const Queue<uint32> & taskIndices, uint32 numWorkers, bool inOrder = false)
+   {
+      numWorkers = muscleMax(muscleMin(numWorkers, taskIndices.GetNumItems()), (uint32)1);
+
+      _numTasks = taskIndices.GetNumItems();
+      _numTasksCompleted.SetCount(0);
+      _lastProgressAt = GetRunTime64();
+
+      // Deal the tasks out round-robin, so that every worker starts out with a similar mix of expensive and cheap tasks
+      const uint32 numQueues = inOrder ? 1 : numWorkers;
+      _workerQueues.Clear();
+      for (uint32 i=0; i<numQueues; i++) if (_workerQueues.AddTail(WorkerQueueRef(newnothrow WorkerQueue)) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+      for (uint32 i=0; i<taskIndices.GetNumItems(); i++)
+      {
+         WorkerQueue * wq = _workerQueues[i%numQueues]();
+         if ((wq == NULL)||(wq->_taskIndices.AddTail(taskIndices[i]) != B_NO_ERROR)) _tasks.ExecuteTask(taskIndices[i], 0);  // out of memory?  Then just do it now
+      }
+
+      Queue<WorkerThreadRef> threads;
+      for (uint32 i=1; i<numWorkers; i++)
+      {
+         WorkerThreadRef t(newnothrow WorkerThread(*this, i));
+         if ((t())&&(t()->StartInternalThread() == B_NO_ERROR)) (void) threads.AddTail(t);
+      }
+
+      RunWorker(0);  // any tasks belonging to threads that failed to start will be stolen by us
+      for (uint32 i=0; i<threads.GetNumItems(); i++) (void) threads[i]()->WaitForInternalThreadToExit();
+      _workerQueues.Clear();
+   }
+
+private:
+   class WorkerQueue : public RefCountable
+   {
+   public:
+      WorkerQueue() {/* empty */}
+
+      Mutex _mutex;
+      Queue<uint32> _taskIndices;
+   };
+   DECLARE_REFTYPES(WorkerQueue);
+
+   class WorkerThread : public Thread
+   {
+   public:
+      WorkerThread(WorkStealingExecutor & executor, uint32 workerIdx) : _executor(executor), _workerIdx(workerIdx) {/* empty */}
+
+   protected:
+      virtual void InternalThreadEntry() {_executor.RunWorker(_workerIdx);}
+
+   private:
+      WorkStealingExecutor & _executor;
+      const uint32 _workerIdx;
+   };
+   DECLARE_REFTYPES(WorkerThread);
+
+   void RunWorker(uint32 workerIdx)
+   {
+      uint32 taskIdx;
+      while(GetNextTask(workerIdx, taskIdx) == B_NO_ERROR)
+      {
+         _tasks.ExecuteTask(taskIdx, workerIdx);
+         _numTasksCompleted.AtomicIncrement();
+
+         MutexGuard mg(_progressMutex);
+         if (OnceEvery(MillisToMicros(100), _lastProgressAt)) _tasks.ReportProgress(_numTasksCompleted.GetCount(), _numTasks);
+      }
+   }
+
+   status_t GetNextTask(uint32 workerIdx, uint32 & retTaskIdx)
+   {
+      const uint32 numQueues = _workerQueues.GetNumItems();  // (just one, shared by all workers, when executing in order)
+      for (uint32 i=0; i<numQueues; i++)
+      {
+         const uint32 victimIdx = (workerIdx+i)%numQueues;  // i==0 means our own queue
+         WorkerQueue * wq = _workerQueues[victimIdx]();
+         if (wq)
+         {
+            MutexGuard mg(wq->_mutex);
+            if ((((numQueues == 1)||(victimIdx == workerIdx)) ? wq->_taskIndices.RemoveHead(retTaskIdx) : wq->_taskIndices.RemoveTail(retTaskIdx)) == B_NO_ERROR) return B_NO_ERROR;
+         }
+      }
+      return B_ERROR;  // all queues are empty, so we're done
+   }
+
+   AbstractParallelTasks & _tasks;
+   Queue<WorkerQueueRef> _workerQueues;
+   uint32 _numTasks;
+   AtomicCounter _numTasksCompleted;
+   Mutex _progressMutex;
+   uint64 _lastProgressAt;
+};
+
+/** Per-thread state for the first (streaming) stage of sanitizing an executable's symbols */
+class SanitizerWorkerState : public RefCountable
+{
+public:
+   SanitizerWorkerState() {/* empty */}
+
+   TextArena _sanitizedText;          // the partially-sanitized text of each symbol we processed, in the order we processed them
+   Queue<uint32> _symbolIndices;      // the parse-order index of each symbol we processed, in the order we processed them
+   Queue<TextSpan> _symbolTexts;      // the span of each of those symbols within (_sanitizedText)
+   Queue<SymbolRecord *> _records;    // filled in by StreamingSanitizer::Finish(), in the same order (which also makes (_symbolTexts) match them up)
+   Queue<const String *> _names;      // the name of each of (_records), also filled in by StreamingSanitizer::Finish()
+
+   TextSpillFileRef _spillFile;       // if non-NULL, the partially-sanitized texts get moved out of (_sanitizedText) to here (see --low-memory)
+   Queue<uint64> _spillOffsets;       // ...in which case this holds the offset of each one within (_spillFile), and (_symbolTexts) only their lengths
+};
+DECLARE_REFTYPES(SanitizerWorkerState);
+
+/** The raw text of a batch of consecutively-parsed symbols, waiting to be sanitized */
+class RawSymbolBatch : public RefCountable
+{
+public:
+   enum {TARGET_NUM_BYTES = 1024*1024};  // when a batch gets this big, it's time to send it off to be sanitized
+
+   RawSymbolBatch() : _rawText(TARGET_NUM_BYTES+(TARGET_NUM_BYTES/4)), _numBytes(0) {/* empty */}
+
+   TextArena _rawText;
+   Queue<uint32> _symbolIndices;  // the parse-order index of each symbol in this batch
+   Queue<TextSpan> _symbolTexts;  // the span of each of those symbols within (_rawText)
+   uint32 _numBytes;
+};
+DECLARE_REFTYPES(RawSymbolBatch);
+
+/** Sanitizes (the first stage of) each of the symbols in (batch), and records the results in (state) */
+static void SanitizeBatch(const RawSymbolBatch & batch, const ReadOnlyData * optROData, SanitizerWorkerState & state)
+{
+   for (uint32 i=0; i<batch._symbolIndices.GetNumItems(); i++)
+   {
+      TextSpan sanitized = SanitizeAddresses(batch._symbolTexts[i], optROData, state._sanitizedText);
+      if (state._spillFile())
+      {
+         if (state._spillOffsets.AddTail(state._spillFile()->Append(sanitized)) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+         state._sanitizedText.DiscardLastSpan(sanitized);
+         state._sanitizedText.ReleaseBlocksBefore(sanitized._chars);  // in case (sanitized) had to be moved to a new block
+         sanitized._chars = NULL;
+      }
+      if ((state._symbolIndices.AddTail(batch._symbolIndices[i]) != B_NO_ERROR)||(state._symbolTexts.AddTail(sanitized) != B_NO_ERROR)) WARN_OUT_OF_MEMORY;
+   }
+}
+
+/** Thread-safe FIFO of RawSymbolBatches that are waiting for a SanitizerThread to process them */
+class PendingBatchesQueue
+{
+public:
+   PendingBatchesQueue() : _numBytes(0) {/* empty */}
+
+   status_t AddBatch(const RawSymbolBatchRef & batch)
+   {
+      MutexGuard mg(_mutex);
+      if (_batches.AddTail(batch) != B_NO_ERROR) return B_ERROR;
+      _numBytes += batch()->_numBytes;
+      return B_NO_ERROR;
+   }
+
+   /** Removes and returns the oldest batch, or returns a NULL reference if there aren't any */
+   RawSymbolBatchRef RemoveBatch()
+   {
+      MutexGuard mg(_mutex);
+      RawSymbolBatchRef ret;
+      if (_batches.RemoveHead(ret) == B_NO_ERROR) _numBytes -= ret()->_numBytes;
+      return ret;
+   }
+
+   /** Returns the total number of bytes of raw text that are currently waiting to be sanitized */
+   uint64 GetNumBytes() const
+   {
+      MutexGuard mg(_mutex);
+      return _numBytes;
+   }
+
+private:
+   mutable Mutex _mutex;
+   Queue<RawSymbolBatchRef> _batches;
+   uint64 _numBytes;
+};
+
+/** Sanitizes batches from a PendingBatchesQueue whenever its owner tells it that there might be some available */
+class SanitizerThread : public Thread
+{
+public:
+   SanitizerThread(PendingBatchesQueue & pending, const ReadOnlyData * optROData, SanitizerWorkerState & state) : _pending(pending), _optROData(optROData), _state(state) {/* empty */}
+
+protected:
+   virtual status_t MessageReceivedFromOwner(const MessageRef & msgRef, uint32 /*numLeft*/)
+   {
+      if (msgRef() == NULL) return B_ERROR;  // our owner wants us to exit
+
+      RawSymbolBatchRef batch;
+      while((batch = _pending.RemoveBatch())() != NULL) SanitizeBatch(*batch(), _optROData, _state);
+      return B_NO_ERROR;
+   }
+
+private:
+   PendingBatchesQueue & _pending;
+   const ReadOnlyData * _optROData;
+   SanitizerWorkerState & _state;
+};
+DECLARE_REFTYPES(SanitizerThread);
+
+/** Resolves the deferred addresses of all the symbols that one SanitizerWorkerState processed; there is one task per SanitizerWorkerState */
+class ResolveSymbolsTasks : public AbstractParallelTasks
+{
+public:
+   ResolveSymbolsTasks(const char * label, const Queue<SanitizerWorkerStateRef> & states, const AddressIndex & index, LineTable & lineTable, uint32 numSymbols, uint32 numWorkers, const ParseSettings & settings) : _label(label), _states(states), _index(index), _lineTable(lineTable), _numSymbols(numSymbols), _optBaseline(settings._optBaseline)
+   {
+      (void) _scratchStrings.EnsureSize(numWorkers, true);
+      for (uint32 i=0; i<numWorkers; i++) (void) _lookupCaches.AddTail(AddressLookupCacheRef(newnothrow AddressLookupCache));
+      for (uint32 i=0; i<numWorkers; i++) (void) _lineIDCaches.AddTail(LineIDCacheRef(newnothrow LineIDCache));
+      for (uint32 i=0; i<states.GetNumItems(); i++) (void) _outputArenas.AddTail(TextArenaRef(newnothrow TextArena));
+
+      // When there's a baseline, only the symbols that differ from it keep their text, so there's no need to spill that text
+      if ((settings._spillDirectory.HasChars())&&(_optBaseline == NULL))
+      {
+         (void) _spillOffsets.EnsureSize(states.GetNumItems(), true);
+         for (uint32 i=0; i<states.GetNumItems(); i++)
+         {
+            TextSpillFileRef spillFile(newnothrow TextSpillFile);
+            if (spillFile() == NULL) WARN_OUT_OF_MEMORY;
+            else if (spillFile()->Open(settings._spillDirectory) != B_NO_ERROR)
+            {
+               _progressDisplay.LogMessage(MUSCLE_LOG_WARNING, String("Unable to create a temporary file in [%1], keeping the symbols' text in memory instead.").Arg(settings._spillDirectory));
+               spillFile.Reset();
+            }
+            (void) _spillFiles.AddTail(spillFile);
+         }
+      }
+   }
+
+   virtual void ExecuteTask(uint32 taskIdx, uint32 workerIdx)
+   {
+      TextArena * outArena = _outputArenas[taskIdx]();
+      if (outArena == NULL) {WARN_OUT_OF_MEMORY; return;}
+
+      TextSpillFile * spillFile = (taskIdx < _spillFiles.GetNumItems()) ? _spillFiles[taskIdx]() : NULL;
+      SanitizerWorkerState & state = *_states[taskIdx]();
+      for (uint32 i=0; i<state._records.GetNumItems(); i++)
+      {
+         SymbolRecord * record = state._records[i];
+         const TextSpan & partialText = state._symbolTexts[i];
+         state._sanitizedText.ReleaseBlocksBefore(partialText._chars);  // the symbols are in the order they were written, so we're done with any blocks before this one
+         record->_lines = ResolveSanitizedText(partialText, _index, _lineTable, _lookupCaches[workerIdx](), _lineIDCaches[workerIdx](), _scratchStrings[workerIdx], *outArena);
+         record->UpdateLinesHash();
+
+         // A symbol that matches its counterpart in the baseline can share the counterpart's line IDs, so we don't need to keep our own copy
+         const SymbolRecord * baselineRecord = _optBaseline ? _optBaseline->Get(*state._names[i]) : NULL;
+         if ((baselineRecord)&&(baselineRecord->HasSameTextAs(*record)))
+         {
+            outArena->DiscardLastSpan(record->_lines.GetBytes());
+            record->_lines = baselineRecord->_lines;
+            _numBaselineMatches.AtomicIncrement();
+         }
+         else if (spillFile)
+         {
+            const TextSpan bytes = record->_lines.GetBytes();
+            if (_spillOffsets[taskIdx].AddTail(spillFile->Append(bytes)) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+            outArena->DiscardLastSpan(bytes);
+            outArena->ReleaseBlocksBefore(bytes._chars);  // in case the IDs had to be moved to a new block
+            record->_lines._ids = NULL;  // until FinishSpilledTexts() points them into the mapped spill file
+         }
+         _numSymbolsResolved.AtomicIncrement();
+      }
+      state._symbolTexts.Clear();
+      state._spillFile.Reset();  // unmaps the partially-sanitized text, if it was spilled, since we're done with it now
+   }
+
+   virtual void ReportProgress(uint32 /*numTasksCompleted*/, uint32 /*numTasks*/) {PrintSanitizerStatus(_label, _numSymbolsResolved.GetCount(), _numSymbols);}
+
+   /** Called after all the tasks have completed:  memory-maps our spill files (if any), points the spilled records' line IDs into them, and adds them to (table) */
+   void FinishSpilledTexts(SymbolTable & table)
+   {
+      for (uint32 i=0; i<_spillFiles.GetNumItems(); i++)
+      {
+         TextSpillFile * spillFile = _spillFiles[i]();
+         if (spillFile == NULL) continue;
+
+         if (spillFile->Map() != B_NO_ERROR)
+         {
+            LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to write or map the temporary file that holds the sanitized line IDs of executable %s!\n", _label);
+            exit(10);
+         }
+
+         const SanitizerWorkerState & state = *_states[i]();
+         const Queue<uint64> & offsets = _spillOffsets[i];
+         for (uint32 j=0; ((j<state._records.GetNumItems())&&(j<offsets.GetNumItems())); j++)
+         {
+            LineIDSpan & lines = state._records[j]->_lines;
+            lines = LineIDSpan(spillFile->GetText(offsets[j], lines._numLines*sizeof(uint32)));
+         }
+         (void) table._spillFiles.AddTail(_spillFiles[i]);
+      }
+   }
+
+   /** Returns the arenas that now hold our records' line IDs (one per task) */
+   const Queue<TextArenaRef> & GetOutputArenas() const {return _outputArenas;}
+
+   /** Returns the number of symbols whose text was found to match their counterparts' in the baseline (see ParseSettings::_optBaseline) */
+   uint32 GetNumBaselineMatches() const {return _numBaselineMatches.GetCount();}
+
+private:
+   const char * _label;
+   const Queue<SanitizerWorkerStateRef> & _states;
+   const AddressIndex & _index;
+   LineTable & _lineTable;
+   const uint32 _numSymbols;
+   const Hashtable<String, SymbolRecord> * _optBaseline;
+   AtomicCounter _numSymbolsResolved;
+   AtomicCounter _numBaselineMatches;
+   Queue<AddressLookupCacheRef> _lookupCaches;  // one per worker thread
+   Queue<LineIDCacheRef> _lineIDCaches;         // one per worker thread
+   Queue<String> _scratchStrings;               // one per worker thread, so that ResolveSanitizedLine() can reuse its buffer
+   Queue<TextArenaRef> _outputArenas;           // one per task, so that the workers never contend for them
+   Queue<TextSpillFileRef> _spillFiles;         // one per task, if the symbols' line IDs are being written to disk (see --low-memory)
+   Queue< Queue<uint64> > _spillOffsets;        // one per task:  where each symbol's line IDs were written within that task's spill file
+};
+
+/** Sanitizes an executable's symbols while they are still being parsed.  The parser appends each symbol's raw text to us
+  * as it goes, and every so often we hand a batch of completed symbols off to our worker threads, which sanitize them and
+  * then free their raw text.  That way, sanitizing overlaps with the disassembler's work, and the raw text of the whole
+  * executable never has to be held in memory at once.
+  *
+  * Looking up the symbol-names that addresses point to has to wait until every symbol is known, though, so that part is
+  * deferred to ResolveSymbols(), which is called after parsing is complete.
+  */
+class StreamingSanitizer
+{
+public:
+   /** @param spillDirectory if non-empty, the partially-sanitized texts get written to temporary files in this directory, rather than held in memory */
+   StreamingSanitizer(const char * label, const ReadOnlyData * optROData, uint32 numThreads, const String & spillDirectory = GetEmptyString()) : _label(label), _optROData(optROData), _nextSymbolIndex(0), _nextThreadIdx(0)
+   {
+      for (uint32 i=0; i<=numThreads; i++)  // the last one is for the parsing thread, for when it sanitizes a batch itself
+      {
+         SanitizerWorkerStateRef state(newnothrow SanitizerWorkerState);
+         if ((state() == NULL)||(_states.AddTail(state) != B_NO_ERROR)) {WARN_OUT_OF_MEMORY; break;}
+
+         if (spillDirectory.HasChars())
+         {
+            state()->_spillFile = TextSpillFileRef(newnothrow TextSpillFile);
+            if (state()->_spillFile() == NULL) WARN_OUT_OF_MEMORY;
+            else if (state()->_spillFile()->Open(spillDirectory) != B_NO_ERROR)
+            {
+               _progressDisplay.LogMessage(MUSCLE_LOG_WARNING, String("Unable to create a temporary file in [%1], keeping the symbols' text in memory instead.").Arg(spillDirectory));
+               state()->_spillFile.Reset();
+            }
+         }
+      }
+
+      for (uint32 i=0; (i+1)<_states.GetNumItems(); i++)
+      {
+         SanitizerThreadRef thread(newnothrow SanitizerThread(_pending, _optROData, *_states[i]()));
+         if ((thread() == NULL)||(thread()->StartInternalThread() != B_NO_ERROR)||(_threads.AddTail(thread) != B_NO_ERROR))
+         {
+            _progressDisplay.LogMessage(MUSCLE_LOG_WARNING, "Unable to start sanitizer thread, symbols will be sanitized synchronously instead.");
+            break;
+         }
+      }
+
+      StartNewBatch();
+   }
+
+   ~StreamingSanitizer() {StopThreads();}
+
+   /** Starts the raw text of the next symbol.  Symbols are numbered in the order they are begun. */
+   void BeginSymbol() {if (_curBatch()) _curBatch()->_rawText.BeginSpan();}
+
+   /** Appends a line of raw text to the current symbol (see AppendRawLine()) */
+   void AddRawLine(const char * line, uint32 lineLength, bool neutralize, const char * optSuffix = NULL) {if (_curBatch()) AppendRawLine(line, lineLength, neutralize, _curBatch()->_rawText, optSuffix);}
+
+   /** Ends the current symbol's raw text, and sends the current batch off to be sanitized if it is big enough */
+   void EndSymbol()
+   {
+      RawSymbolBatch * batch = _curBatch();
+      if (batch)
+      {
+         const TextSpan rawText = batch->_rawText.EndSpan();
+         if ((batch->_symbolIndices.AddTail(_nextSymbolIndex) != B_NO_ERROR)||(batch->_symbolTexts.AddTail(rawText) != B_NO_ERROR)) WARN_OUT_OF_MEMORY;
+         batch->_numBytes += rawText._length;
+         if (batch->_numBytes >= RawSymbolBatch::TARGET_NUM_BYTES) DispatchCurrentBatch();
+      }
+      _nextSymbolIndex++;
+   }
+
+   /** Waits for all symbols to be sanitized, then matches up each worker's partially-sanitized texts with their SymbolRecords.
+     * @param symbols the parsed symbols.  Must still be in parse-order (i.e. unsorted), so that the n'th symbol is symbol #n.
+     */
+   void Finish(Hashtable<String, SymbolRecord> & symbols)
+   {
+      DispatchCurrentBatch();
+      _curBatch.Reset();
+      StopThreads();
+
+      Queue<SymbolRecord *> records;
+      Queue<const String *> names;
+      (void) records.EnsureSize(symbols.GetNumItems());
+      (void) names.EnsureSize(symbols.GetNumItems());
+      for (HashtableIterator<String, SymbolRecord> iter(symbols); iter.HasData(); iter++)
+      {
+         (void) records.AddTail(&iter.GetValue());
+         (void) names.AddTail(&iter.GetKey());
+      }
+
+      // Note that the SymbolRecord pointers remain valid after the caller sorts (symbols), since sorting doesn't move the table's entries
+      for (uint32 i=0; i<_states.GetNumItems(); i++)
+      {
+         SanitizerWorkerState & state = *_states[i]();
+         TextSpillFile * spillFile = state._spillFile();
+         if ((spillFile)&&(spillFile->Map() != B_NO_ERROR))
+         {
+            LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to write or map the temporary file that holds the partially-sanitized text of executable %s!\n", _label);
+            exit(10);
+         }
+
+         Queue<TextSpan> texts;
+         (void) texts.EnsureSize(state._symbolIndices.GetNumItems());
+         (void) state._records.EnsureSize(state._symbolIndices.GetNumItems());
+         (void) state._names.EnsureSize(state._symbolIndices.GetNumItems());
+         for (uint32 j=0; j<state._symbolIndices.GetNumItems(); j++)
+         {
+            const uint32 symbolIdx = state._symbolIndices[j];
+            if (symbolIdx < records.GetNumItems())
+            {
+               (void) texts.AddTail(spillFile ? spillFile->GetText(state._spillOffsets[j], state._symbolTexts[j]._length) : state._symbolTexts[j]);
+               (void) state._records.AddTail(records[symbolIdx]);
+               (void) state._names.AddTail(names[symbolIdx]);
+            }
+         }
+         state._symbolTexts.SwapContents(texts);
+         state._symbolIndices.Clear();
+         state._spillOffsets.Clear();
+      }
+   }
+
+   /** Resolves each symbol's partially-sanitized text into its fully-sanitized line IDs (in (table._lineTable), which mustn't be NULL), now that (index) knows every symbol's address.
+     * This is done in parallel (one task per worker's output), freeing the partially-sanitized text as it goes.
+     * On return, the symbols' line IDs point into arenas or spill files that have been added to (table), or (if they
+     * match their counterparts in (settings._optBaseline)) into the baseline's line IDs.
+     */
+   void ResolveSymbols(SymbolTable & table, const AddressIndex & index, const ParseSettings & settings)
+   {
+      Queue<uint32> taskIndices;
+      for (uint32 i=0; i<_states.GetNumItems(); i++) (void) taskIndices.AddTail(i);
+
+      ResolveSymbolsTasks tasks(_label, _states, index, *table._lineTable(), table._symbols.GetNumItems(), settings._numSanitizerThreads, settings);
+      WorkStealingExecutor(tasks).ExecuteTasks(taskIndices, settings._numSanitizerThreads);
+      tasks.FinishSpilledTexts(table);
+
+      const Queue<TextArenaRef> & outputArenas = tasks.GetOutputArenas();
+      for (uint32 i=0; i<outputArenas.GetNumItems(); i++) if (outputArenas[i]()) (void) table._textArenas.AddTail(outputArenas[i]);
+      _states.Clear();  // frees whatever is left of the partially-sanitized text
+
+      PrintSanitizerStatus(_label, table._symbols.GetNumItems(), table._symbols.GetNumItems());
+      _progressDisplay.FinishStatus(_label);
+      if (settings._optBaseline) _progressDisplay.LogMessage(MUSCLE_LOG_INFO, String("%1 of the symbols of executable %2 match the baseline's, so only the other %3 were kept in memory").Arg(tasks.GetNumBaselineMatches()).Arg(_label).Arg(table._symbols.GetNumItems()-tasks.GetNumBaselineMatches()));
+   }
+
+private:
+   StreamingSanitizer(const StreamingSanitizer &);  // deliberately unimplemented
+   StreamingSanitizer & operator = (const StreamingSanitizer &);  // deliberately unimplemented
+
+   void StartNewBatch()
+   {
+      _curBatch = RawSymbolBatchRef(newnothrow RawSymbolBatch);
+      if (_curBatch() == NULL) WARN_OUT_OF_MEMORY;
+   }
+
+   void DispatchCurrentBatch()
+   {
+      if ((_curBatch() == NULL)||(_curBatch()->_symbolIndices.IsEmpty())) return;
+
+      // If our threads are falling behind, we'll sanitize this batch ourself; that also keeps the amount of raw text in memory bounded
+      if ((_threads.HasItems())&&(_pending.GetNumBytes() < (MAX_PENDING_BATCHES*RawSymbolBatch::TARGET_NUM_BYTES))&&(_pending.AddBatch(_curBatch) == B_NO_ERROR))
+      {
+         (void) _threads[_nextThreadIdx]()->SendMessageToInternalThread(GetMessageFromPool());  // wake up a thread to go look at the queue
+         _nextThreadIdx = (_nextThreadIdx+1)%_threads.GetNumItems();
+      }
+      else if (_states.HasItems()) SanitizeBatch(*_curBatch(), _optROData, *_states.Tail()());
+
+      StartNewBatch();
+   }
+
+   void StopThreads()
+   {
+      for (uint32 i=0; i<_threads.GetNumItems(); i++) _threads[i]()->ShutdownInternalThread();  // each thread processes any queued work before it exits
+      _threads.Clear();
+   }
+
+   enum {MAX_PENDING_BATCHES = 16};
+
+   const char * _label;
+   const ReadOnlyData * _optROData;
+   Queue<SanitizerWorkerStateRef> _states;  // one per thread, plus one for the parsing thread
+   Queue<SanitizerThreadRef> _threads;
+   PendingBatchesQueue _pending;
+   RawSymbolBatchRef _curBatch;  // the batch that the parser is currently appending raw text to
+   uint32 _nextSymbolIndex;
+   uint32 _nextThreadIdx;
+};
+
+/** Reads a stream in large blocks, and hands out its lines in-place, so that no per-line copying or allocation is necessary.
+  * Lines of any length are supported; the buffer grows as necessary to hold the longest line.
+  */
+class LineReader
+{
+public:
+   LineReader(FILE * fpIn, uint32 blockSize = 1024*1024) : _fpIn(fpIn), _buf(newnothrow_array(char, blockSize+1)), _bufSize(_buf ? blockSize : 0), _lineStart(0), _scanFrom(0), _numValid(0), _atEOF(false), _numBytesRead(0)
+   {
+      if (_buf == NULL) WARN_OUT_OF_MEMORY;
+   }
+
+   ~LineReader() {delete [] _buf;}
+
+   /** Returns the next line (NUL-terminated, without its newline) and sets (retLength) to its length, or returns NULL at the end of the stream.
+     * The returned line may be modified in-place by the caller, and remains valid until the next call to GetNextLine().
+     */
+   char * GetNextLine(uint32 & retLength)
+   {
+      while(true)
+      {
+         char * nl = (char *) memchr(_buf+_scanFrom, '\n', _numValid-_scanFrom);
+         if (nl)
+         {
+            *nl = '\0';
+            return ReturnLine((uint32)(nl-_buf), retLength);
+         }
+
+         if (_atEOF)
+         {
+            if (_lineStart == _numValid) return NULL;
+            _buf[_numValid] = '\0';  // there's always room for this, since we allocate one extra byte
+            return ReturnLine(_numValid, retLength);
+         }
+
+         FillBuffer();
+      }
+   }
+
+   /** Returns the total number of bytes read from our stream so far */
+   uint64 GetNumBytesRead() const {return _numBytesRead;}
+
+private:
+   LineReader(const LineReader &);  // deliberately unimplemented
+   LineReader & operator = (const LineReader &);  // deliberately unimplemented
+
+   char * ReturnLine(uint32 lineEnd, uint32 & retLength)
+   {
+      char * ret = _buf+_lineStart;
+      retLength  = lineEnd-_lineStart;
+      _lineStart = _scanFrom = muscleMin(lineEnd+1, _numValid);
+      return ret;
+   }
+
+   // Moves the partial line we have so far to the front of the buffer (growing the buffer if the line fills it), then reads more data after it
+   void FillBuffer()
+   {
+      const uint32 numPartial = _numValid-_lineStart;
+      if ((numPartial == _bufSize)&&(_bufSize > 0))
+      {
+         char * newBuf = newnothrow_array(char, (2*_bufSize)+1);
+         if (newBuf == NULL) {WARN_OUT_OF_MEMORY; _atEOF = true; return;}
+         memcpy(newBuf, _buf, numPartial);
+         delete [] _buf;
+         _buf      = newBuf;
+         _bufSize *= 2;
+      }
+      else if (_lineStart > 0) memmove(_buf, _buf+_lineStart, numPartial);
+
+      _lineStart = 0;
+      _scanFrom  = _numValid = numPartial;
+
+      const size_t numRead = (_bufSize > _numValid) ? fread(_buf+_numValid, 1, _bufSize-_numValid, _fpIn) : 0;
+      if (numRead == 0) _atEOF = true;
+      else
+      {
+         _numValid     += (uint32) numRead;
+         _numBytesRead += numRead;
+      }
+   }
+
+   FILE * _fpIn;
+   char * _buf;
+   uint32 _bufSize;    // not including the extra byte for the NUL terminator
+   uint32 _lineStart;  // offset of the first byte of the line we'll return next
+   uint32 _scanFrom;   // offset to continue searching for a newline from
+   uint32 _numValid;   // number of bytes of data currently in (_buf)
+   bool _atEOF;
+   uint64 _numBytesRead;
+};
+
+static bool IsWhitespaceChar(char c) {return ((c == ' ')||(c == '\t')||(c == '\r')||(c == '\n'));}
+
+/** Removes any leading and trailing whitespace from (line), in-place, and returns the trimmed line.  (length) is updated to the trimmed length. */
+static char * TrimLine(char * line, uint32 & length)
+{
+   while((length > 0)&&(IsWhitespaceChar(*line)))             {line++; length--;}
+   while((length > 0)&&(IsWhitespaceChar(line[length-1])))  length--;
+   line[length] = '\0';
+   return line;
+}
+
+static bool LineStartsWith(const char * line, const char * prefix) {return (strncmp(line, prefix, strlen(prefix)) == 0);}
+
+/** Returns the path of the disassembler we run:  otool under MacOS/X, or objdump under Linux */
+static const char * GetDisassemblerPath()
+{
+#ifdef __APPLE__
+   return "/usr/bin/otool";
+#else
+   return "/usr/bin/objdump";
+#endif
+}
+
+/** Returns (fileName) in a form that a command line tool won't mistake for an option, i.e. with "./" prepended if it starts with a dash */
+static String GetFileNameArgument(const char * fileName) {return (fileName[0] == '-') ? (String("./")+fileName) : String(fileName);}
+
+/** A child process (e.g. the disassembler) whose stdout we read.  The process is started directly, rather than via a shell,
+  * so its arguments (e.g. file names) are passed along verbatim, and can't be misinterpreted as shell syntax.
+  */
+class ChildProcess
+{
+public:
+   ChildProcess() : _pid(-1), _fpOut(NULL) {/* empty */}
+   ~ChildProcess() {(void) Close();}
+
+   /** Starts the program at (args[0]) (which must be an absolute path), passing it (args) as its argv.
+     * Returns a FILE handle that reads the process's stdout, or NULL on failure.  The handle remains owned by us.
+     */
+   FILE * Open(const Queue<String> & args)
+   {
+      (void) Close();
+      if (args.IsEmpty()) return NULL;
+
+      // Everything the child needs is prepared before we fork, since only async-signal-safe calls may be made in the child of a multithreaded process
+      Queue<char *> argv;
+      if (argv.EnsureSize(args.GetNumItems()+1) != B_NO_ERROR) return NULL;
+      for (uint32 i=0; i<args.GetNumItems(); i++) (void) argv.AddTail(const_cast<char *>(args[i]()));
+      (void) argv.AddTail(NULL);
+
+      // The pipe is close-on-exec, so that the children of other threads that are forking at the same time don't inherit it (and keep it open)
+      int fds[2];
+#ifdef __APPLE__
+      if (pipe(fds) != 0) return NULL;
+      (void) fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+      (void) fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#else
+      if (pipe2(fds, O_CLOEXEC) != 0) return NULL;
+#endif
+
+      _pid = fork();
+      if (_pid == 0)
+      {
+         if (dup2(fds[1], STDOUT_FILENO) >= 0) (void) execv(argv[0], &argv[0]);
+         _exit(127);
+      }
+
+      (void) close(fds[1]);
+      if (_pid < 0)
+      {
+         (void) close(fds[0]);
+         return NULL;
+      }
+
+      _fpOut = fdopen(fds[0], "r");
+      if (_fpOut == NULL) (void) close(fds[0]);
+      return _fpOut;
+   }
+
+   /** Closes the handle that Open() returned (if any), and waits for the process to exit.  Returns its exit code, or -1 if it didn't exit normally (or wasn't running). */
+   int Close()
+   {
+      if (_fpOut)
+      {
+         fclose(_fpOut);
+         _fpOut = NULL;
+      }
+      if (_pid <= 0) return -1;
+
+      int status;
+      while((waitpid(_pid, &status, 0) < 0)&&(errno == EINTR)) {/* empty */}
+      _pid = -1;
+      return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+   }
+
+private:
+   ChildProcess(const ChildProcess &);  // deliberately unimplemented
+   ChildProcess & operator = (const ChildProcess &);  // deliberately unimplemented
+
+   pid_t _pid;
+   FILE * _fpOut;
+};
+
+#ifdef __APPLE__
+
+// Routine for parsing the output of Apple's otool disassembler utility.  Returns B_ERROR if otool failed (in which case (retTable) may be incomplete)
+static status_t ParseOtoolOutput(const char * fileName, const char * label, const ParseSettings & settings, SymbolTable & retTable)
+{
+   const char * otoolPath = GetDisassemblerPath();
+
+   const FilePathInfo fpi(otoolPath);
+   if (fpi.Exists() == false)
+   {
+      String toolName = otoolPath;
+      toolName = toolName.Substring("/");  // only include the executable name itself
+      LogTime(MUSCLE_LOG_CRITICALERROR, "%s not found -- executable_diff needs to be able run %s in order to function.\n", otoolPath, toolName());
+      LogTime(MUSCLE_LOG_CRITICALERROR, "To install %s, install XCode (and its command line tools)\n", otoolPath, toolName(), toolName());
+      exit(10);
+   }
+
+   PhaseRecorder disassemblePhase(settings._optStats, "disassemble", label);
+   disassemblePhase.GetStats()._numSubprocesses = 1;
+
+   Queue<String> args;
+   (void) args.AddTail(otoolPath);
+   (void) args.AddTail("-tV");
+   (void) args.AddTail(GetFileNameArgument(fileName));
+
+   ChildProcess otool;
+   FILE * fpIn = otool.Open(args);
+   if (fpIn == NULL)
+   {
+      LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to open executable [%s] for reading\n", fileName);
+      exit(10);
+   }
+
+   _progressDisplay.LogMessage(MUSCLE_LOG_INFO, String("Opening executable file %1 [%2]...").Arg(label).Arg(fileName));
+   Hashtable<String, SymbolRecord> & symbols = retTable._symbols;
+   (void) symbols.EnsureSize(100000);  // try to avoid reallocations as they could be expensive
+
+   StreamingSanitizer sanitizer(label, NULL, settings._numSanitizerThreads, settings._spillDirectory);  // sanitizes each symbol's text while we parse the rest
+
+   SymbolRecord * curSymbolContents  = NULL;
+
+   uint32 lineNumber  = 1;
+   uint32 numSymbols  = 0;
+   uint64 lastPrintAt = GetRunTime64();
+
+   const String ripStr = "(%rip)";  // indicates instruction-pointer-relative addressing!
+   const String rspStr = "(%rip)";  // stack-frame-pointer
+
+   String keptComment;  // declared out here so that its buffer gets reused
+
+   LineReader reader(fpIn);
+   uint32 lineLength;
+   char * line;
+   (void) reader.GetNextLine(lineLength);  // skip the first line, as it is just the name of the executable
+   while((line = reader.GetNextLine(lineLength)) != NULL)
+   {
+      line = TrimLine(line, lineLength);
+
+      if ((lineLength > 0)&&(line[lineLength-1] == ':'))
+      {
+         line[--lineLength] = '\0';
+         if (curSymbolContents) sanitizer.EndSymbol();
+
+         curSymbolContents = symbols.PutAndGet(GetUniqueSymbolName(String(line, lineLength), symbols));
+         if (curSymbolContents)
+         {
+            sanitizer.BeginSymbol();
+            numSymbols++;
+         }
+         else WARN_OUT_OF_MEMORY;
+      }
+      else if (curSymbolContents)
+      {
+         char * firstTab = strchr(line, '\t');
+         if (firstTab)
+         {
+            const uint64 addr = Atoxll(line);  // the address-column (Atoxll() stops parsing at the tab)
+            if (curSymbolContents->_startAddress == 0) curSymbolContents->_startAddress = addr;
+            curSymbolContents->_length = muscleMax(curSymbolContents->_length, (addr-curSymbolContents->_startAddress)+4);
+            lineLength -= (uint32)((firstTab+1)-line);
+            line        = firstTab+1;
+         }
+
+         char * comment = strstr(line, " ## ");
+         const bool neutralize = ((strstr(line, "(%rip)"))||((comment)&&((strstr(comment, " for: "))||(strstr(comment, " symbol address:"))))) || (((LineStartsWith(line, "call"))||(LineStartsWith(line, "jmp")))&&(comment == NULL));
+         const bool keepComment = ((comment)&&(strstr(comment, "literal")));
+         if (keepComment) keptComment = comment;
+         if (comment)
+         {
+            *comment   = '\0';  // so that (line) now contains only the part before the comment
+            lineLength = (uint32)(comment-line);
+         }
+
+         sanitizer.AddRawLine(line, lineLength, neutralize, keepComment ? keptComment() : NULL);
+      }
+
+      if (OnceEvery(MillisToMicros(100), lastPrintAt)) PrintParseStatus(label, "otool", lineNumber, numSymbols);
+      lineNumber++;
+   }
+   const int exitCode = otool.Close();
+   if (exitCode != 0) LogTime(MUSCLE_LOG_ERROR, "%s failed (exit code %i) while disassembling executable [%s]\n", otoolPath, exitCode, fileName);
+   disassemblePhase.GetStats()._numBytesRead = reader.GetNumBytesRead();
+   disassemblePhase.GetStats()._numLines     = lineNumber-1;
+   disassemblePhase.GetStats()._numSymbols   = numSymbols;
+   disassemblePhase.Finish();
+
+   PhaseRecorder resolvePhase(settings._optStats, "resolve symbols", label);
+   if (curSymbolContents) sanitizer.EndSymbol();
+   sanitizer.Finish(symbols);
+
+   symbols.SortByValue(CompareStartAddressesFunctor());
+
+   AddressIndex index;  // used for quick (O(logN)) address-lookups
+   (void) index.SetSymbols(symbols);
+
+   // Now that we know where every symbol is, we can replace any absolute addresses with symbol-relative representations
+   sanitizer.ResolveSymbols(retTable, index, settings);
+
+   symbols.SortByKey();
+   resolvePhase.GetStats()._numSymbols = symbols.GetNumItems();
+   _progressDisplay.LogMessage(MUSCLE_LOG_INFO, String("Parsed %1 unique symbols from %2").Arg(symbols.GetNumItems()).Arg(fileName));
+   return (exitCode == 0) ? B_NO_ERROR : B_ERROR;
+}
+
+#else
+
+/** Information about one section of an ELF file */
+class ElfSection
+{
+public:
+   ElfSection() : _type(0), _flags(0), _address(0), _fileOffset(0), _numBytes(0), _link(0) {/* empty */}
+
+   String _name;
+   uint32 _type;         // e.g. SHT_PROGBITS
+   uint64 _flags;        // e.g. SHF_ALLOC|SHF_EXECINSTR
+   uint64 _address;      // the address the section gets loaded at
+   uint64 _fileOffset;   // where the section's bytes are located within the file
+   uint64 _numBytes;     // the size of the section
+   uint32 _link;         // index of an associated section (e.g. a symbol table's string table)
+};
+
+/** Information about one symbol in an ELF file's symbol table */
+class ElfSymbol
+{
+public:
+   ElfSymbol() : _address(0), _numBytes(0), _binding(0), _sectionIndex(0) {/* empty */}
+
+   String _name;
+   uint64 _address;        // the address of the function or data object
+   uint64 _numBytes;       // its size
+   uint32 _binding;        // e.g. STB_GLOBAL
+   uint32 _sectionIndex;   // index of the section it is in
+};
+
+/** Memory-maps an ELF executable file and gives zero-copy, read-only access to its sections.
+  * Only ELF files with the same byte-ordering as the host are supported.
+  */
+class ElfFile
+{
+public:
+   ElfFile() : _fileData(NULL), _fileSize(0), _is64Bit(false), _machine(EM_NONE) {/* empty */}
+   ~ElfFile() {Close();}
+
+   /** Memory-maps the specified file and parses its section headers.  Returns B_NO_ERROR on success. */
+   status_t Open(const char * path)
+   {
+      Close();
+
+      if ((_file.Map(path) != B_NO_ERROR)||(_file.GetNumBytes() <= EI_NIDENT))
+      {
+         Close();
+         return B_ERROR;
+      }
+      _fileData = _file.GetData();
+      _fileSize = _file.GetNumBytes();
+
+      status_t ret = B_ERROR;
+      if ((memcmp(_fileData, ELFMAG, SELFMAG) == 0)&&(_fileData[EI_DATA] == (B_HOST_IS_LENDIAN ? ELFDATA2LSB : ELFDATA2MSB)))
+      {
+         switch(_fileData[EI_CLASS])
+         {
+            case ELFCLASS64: ret = ParseSectionHeaders<Elf64_Ehdr, Elf64_Shdr>(); _is64Bit = true; break;
+            case ELFCLASS32: ret = ParseSectionHeaders<Elf32_Ehdr, Elf32_Shdr>(); break;
+            default:         /* empty */                                          break;
+         }
+      }
+
+      if (ret != B_NO_ERROR) Close();
+      return ret;
+   }
+
+   /** Unmaps our file, if it was mapped */
+   void Close()
+   {
+      _file.Unmap();
+      _fileData = NULL;
+      _fileSize = 0;
+      _is64Bit  = false;
+      _machine  = EM_NONE;
+      _sections.Clear();
+   }
+
+   const Queue<ElfSection> & GetSections() const {return _sections;}
+
+   /** Returns true iff we are a 64-bit (ELFCLASS64) file */
+   bool Is64Bit() const {return _is64Bit;}
+
+   /** Returns the architecture our code is for (e.g. EM_X86_64) */
+   uint32 GetMachine() const {return _machine;}
+
+   /** Returns a pointer to the in-file bytes of the given section, or NULL if the section has no bytes in the file (e.g. .bss) */
+   const uint8 * GetSectionData(const ElfSection & section) const
+   {
+      if ((section._type == SHT_NOBITS)||(section._fileOffset > _fileSize)||(section._numBytes > (_fileSize-section._fileOffset))) return NULL;
+      return _fileData+section._fileOffset;
+   }
+
+   /** Adds all of our allocated, non-writable, non-executable data sections (.rodata and friends) to (ret) */
+   void GetReadOnlyData(ReadOnlyData & ret) const
+   {
+      for (uint32 i=0; i<_sections.GetNumItems(); i++)
+      {
+         const ElfSection & s = _sections[i];
+         if ((s._type == SHT_PROGBITS)&&(s._numBytes > 0)&&((s._flags & (SHF_ALLOC|SHF_WRITE|SHF_EXECINSTR)) == SHF_ALLOC))
+         {
+            const uint8 * data = GetSectionData(s);
+            if ((data)&&(ret.AddRegion(ReadOnlyDataRegion(s._address, data, s._numBytes)) != B_NO_ERROR)) WARN_OUT_OF_MEMORY;
+         }
+      }
+   }
+
+   /** Returns the index of the executable section that contains (addr), or -1 if (addr) isn't in an executable section */
+   int32 GetExecutableSectionIndex(uint64 addr) const
+   {
+      for (uint32 i=0; i<_sections.GetNumItems(); i++)
+      {
+         const ElfSection & s = _sections[i];
+         if (((s._flags & (SHF_ALLOC|SHF_EXECINSTR)) == (SHF_ALLOC|SHF_EXECINSTR))&&(addr >= s._address)&&((addr-s._address) < s._numBytes)) return i;
+      }
+      return -1;
+   }
+
+   /** Returns a pointer to the in-file machine code for the (numBytes) bytes starting at (addr), or NULL if
+     * those bytes aren't all inside a single executable section.
+     */
+   const uint8 * GetCodeBytes(uint64 addr, uint64 numBytes) const
+   {
+      const int32 sectionIdx = GetExecutableSectionIndex(addr);
+      if (sectionIdx < 0) return NULL;
+
+      const ElfSection & s = _sections[sectionIdx];
+      const uint8 * data = GetSectionData(s);
+      return ((data)&&(numBytes <= (s._numBytes-(addr-s._address)))) ? (data+(addr-s._address)) : NULL;
+   }
+
+   /** Adds to (retSymbols) every symbol of the given type (e.g. STT_FUNC) that has a non-zero size and is in a loaded section.
+     * The symbols come from our symbol table, or from our dynamic symbol table if we have no regular symbol table (e.g. because we were stripped).
+     * Returns B_NO_ERROR on success, or B_ERROR on failure.
+     */
+   status_t GetSymbols(uint32 symbolType, Queue<ElfSymbol> & retSymbols) const
+   {
+      uint32 symTabType = SHT_DYNSYM;
+      for (uint32 i=0; i<_sections.GetNumItems(); i++) if (_sections[i]._type == SHT_SYMTAB) symTabType = SHT_SYMTAB;
+
+      for (uint32 i=0; i<_sections.GetNumItems(); i++)
+      {
+         const ElfSection & s = _sections[i];
+         if ((s._type == symTabType)&&(s._link < _sections.GetNumItems()))
+         {
+            const status_t ret = _is64Bit ? ParseSymbols<Elf64_Sym>(s, _sections[s._link], symbolType, retSymbols) : ParseSymbols<Elf32_Sym>(s, _sections[s._link], symbolType, retSymbols);
+            if (ret != B_NO_ERROR) return B_ERROR;
+         }
+      }
+      return B_NO_ERROR;
+   }
+
+private:
+   ElfFile(const ElfFile &);              // deliberately unimplemented
+   ElfFile & operator=(const ElfFile &);  // deliberately unimplemented
+
+   template<typename EhdrType, typename ShdrType> status_t ParseSectionHeaders()
+   {
+      if (_fileSize < sizeof(EhdrType)) return B_ERROR;
+      const EhdrType * ehdr = (const EhdrType *) _fileData;
+      if ((ehdr->e_shentsize != sizeof(ShdrType))||(ehdr->e_shoff > _fileSize)||(((uint64)ehdr->e_shnum*sizeof(ShdrType)) > (_fileSize-ehdr->e_shoff))) return B_ERROR;
+
+      _machine = ehdr->e_machine;
+
+      const ShdrType * shdrs = (const ShdrType *) (_fileData+ehdr->e_shoff);
+      const ShdrType * strTab = (ehdr->e_shstrndx < ehdr->e_shnum) ? &shdrs[ehdr->e_shstrndx] : NULL;
+      for (uint32 i=0; i<ehdr->e_shnum; i++)
+      {
+         const ShdrType & sh = shdrs[i];
+
+         ElfSection s;
+         s._type       = sh.sh_type;
+         s._flags      = sh.sh_flags;
+         s._address    = sh.sh_addr;
+         s._fileOffset = sh.sh_offset;
+         s._numBytes   = sh.sh_size;
+         s._link       = sh.sh_link;
+         if ((strTab)&&(strTab->sh_offset < _fileSize)&&(sh.sh_name < strTab->sh_size)&&(sh.sh_name < (_fileSize-strTab->sh_offset)))
+         {
+            const uint64 nameOffset = strTab->sh_offset+sh.sh_name;
+            s._name.SetCstr((const char *) (_fileData+nameOffset), (uint32) muscleMin(_fileSize-nameOffset, (uint64) MUSCLE_NO_LIMIT));
+         }
+         if (_sections.AddTail(s) != B_NO_ERROR) return B_ERROR;
+      }
+      return B_NO_ERROR;
+   }
+
+   template<typename SymType> status_t ParseSymbols(const ElfSection & symTab, const ElfSection & strTab, uint32 symbolType, Queue<ElfSymbol> & retSymbols) const
+   {
+      const uint8 * symData = GetSectionData(symTab);
+      const uint8 * strData = GetSectionData(strTab);
+      if ((symData == NULL)||(strData == NULL)) return B_NO_ERROR;  // nothing to parse
+
+      const SymType * syms = (const SymType *) symData;
+      const uint64 numSyms = symTab._numBytes/sizeof(SymType);
+      for (uint64 i=0; i<numSyms; i++)
+      {
+         const SymType & sym = syms[i];
+         if (((uint32)(sym.st_info & 0x0F) == symbolType)&&(sym.st_size > 0)&&(sym.st_name < strTab._numBytes)&&(sym.st_shndx < _sections.GetNumItems())&&((_sections[sym.st_shndx]._flags & SHF_ALLOC) != 0))
+         {
+            ElfSymbol es;
+            es._name.SetCstr((const char *) (strData+sym.st_name), (uint32) muscleMin(strTab._numBytes-sym.st_name, (uint64) MUSCLE_NO_LIMIT));
+            es._address      = sym.st_value;
+            es._numBytes     = sym.st_size;
+            es._binding      = sym.st_info >> 4;
+            es._sectionIndex = sym.st_shndx;
+            if ((es._name.HasChars())&&(retSymbols.AddTail(es) != B_NO_ERROR)) return B_ERROR;
+         }
+      }
+      return B_NO_ERROR;
+   }
+
+   MemoryMappedFile _file;
+   const uint8 * _fileData;
+   uint64 _fileSize;
+   bool _is64Bit;
+   uint32 _machine;
+   Queue<ElfSection> _sections;
+};
+
+/** Describes one field of a machine-code instruction that might hold an address */
+class AddressField
+{
+public:
+   enum {
+      TYPE_RELATIVE = 0,  // a branch-displacement or RIP-relative displacement (relative to the end of the instruction)
+      TYPE_ABSOLUTE       // a 32-bit (or larger) displacement or immediate value, which might be an absolute address
+   };
+
+   AddressField() : _type(TYPE_RELATIVE), _offset(0), _numBytes(0) {/* empty */}
+   AddressField(uint32 type, uint32 offset, uint32 numBytes) : _type(type), _offset(offset), _numBytes(numBytes) {/* empty */}
+
+   uint32 _type;
+   uint32 _offset;    // where the field starts, relative to the start of the instruction
+   uint32 _numBytes;  // how many bytes long the field is (1, 2, 4 or 8)
+};
+
+/** The parts of a decoded x86 or x86-64 instruction that the prefilter needs to know about */
+class X86Instruction
+{
+public:
+   X86Instruction() : _length(0), _numAddressFields(0) {/* empty */}
+
+   status_t AddAddressField(uint32 type, uint32 offset, uint32 numBytes)
+   {
+      if (_numAddressFields >= ARRAYITEMS(_addressFields)) return B_ERROR;
+      _addressFields[_numAddressFields++] = AddressField(type, offset, numBytes);
+      return B_NO_ERROR;
+   }
+
+   uint32 _length;                 // the total number of bytes in the instruction
+   uint32 _numAddressFields;       // how many of the entries in (_addressFields) are valid
+   AddressField _addressFields[2]; // in the order they appear in the instruction (e.g. a displacement and then an immediate)
+};
+
+enum {
+   X86_MODRM   = 0x01,  // the opcode is followed by a ModRM byte
+   X86_IMM8    = 0x02,  // ...and then by an 8-bit immediate
+   X86_IMM16   = 0x04,  // ...and then by a 16-bit immediate
+   X86_IMMZ    = 0x08,  // ...and then by a 16-bit or 32-bit immediate, depending on the operand-size
+   X86_REL8    = 0x10,  // ...and then by an 8-bit branch-displacement
+   X86_RELZ    = 0x20,  // ...and then by a 16-bit or 32-bit branch-displacement
+   X86_SPECIAL = 0x40,  // needs special handling (see DecodeX86Instruction())
+   X86_INVALID = 0x80   // not a valid opcode (or at least, not one we know how to decode)
+};
+
+/** Returns the X86_* flags describing an opcode in the one-byte opcode map */
+static uint32 GetX86OneByteOpcodeFlags(uint8 op, bool is64Bit)
+{
+   if (op < 0x40)
+   {
+      switch(op & 0x07)
+      {
+         case 0: case 1: case 2: case 3: return X86_MODRM;
+         case 4:                         return X86_IMM8;
+         case 5:                         return X86_IMMZ;
+         default:                        return is64Bit ? X86_INVALID : 0;  // push/pop segment-register, DAA, etc
+      }
+   }
+   if (op < 0x60) return 0;  // (inc/dec in 32-bit mode; REX prefixes are handled before we get here), push, pop
+   if (op < 0x62) return is64Bit ? X86_INVALID : 0;
+   if (op == 0x62) return X86_SPECIAL;  // EVEX prefix (or BOUND in 32-bit mode)
+   if (op == 0x63) return X86_MODRM;
+   if (op == 0x68) return X86_IMMZ;
+   if (op == 0x69) return X86_MODRM|X86_IMMZ;
+   if (op == 0x6A) return X86_IMM8;
+   if (op == 0x6B) return X86_MODRM|X86_IMM8;
+   if (op < 0x70) return 0;
+   if (op < 0x80) return X86_REL8;
+   if (op == 0x81) return X86_MODRM|X86_IMMZ;
+   if (op == 0x82) return is64Bit ? X86_INVALID : (X86_MODRM|X86_IMM8);
+   if (op < 0x84) return X86_MODRM|X86_IMM8;
+   if (op < 0x90) return X86_MODRM;
+   if (op == 0x9A) return is64Bit ? X86_INVALID : X86_SPECIAL;  // far call
+   if (op < 0xA0) return 0;
+   if (op < 0xA4) return X86_SPECIAL;  // mov to/from a memory-offset
+   if (op == 0xA8) return X86_IMM8;
+   if (op == 0xA9) return X86_IMMZ;
+   if (op < 0xB0) return 0;
+   if (op < 0xB8) return X86_IMM8;
+   if (op < 0xC0) return X86_SPECIAL;  // mov immediate (which is 64 bits with REX.W)
+   switch(op)
+   {
+      case 0xC0: case 0xC1: case 0xC6: return X86_MODRM|X86_IMM8;
+      case 0xC2: case 0xCA:            return X86_IMM16;
+      case 0xC4: case 0xC5:            return X86_SPECIAL;  // VEX prefix (or LES/LDS in 32-bit mode)
+      case 0xC7:                       return X86_MODRM|X86_IMMZ;
+      case 0xC8:                       return X86_IMM16|X86_IMM8;
+      case 0xCD:                       return X86_IMM8;
+      case 0xCE:                       return is64Bit ? X86_INVALID : 0;
+      case 0xD4: case 0xD5:            return is64Bit ? X86_INVALID : X86_IMM8;
+      case 0xD6:                       return X86_INVALID;
+      case 0xE8: case 0xE9:            return X86_RELZ;
+      case 0xEA:                       return is64Bit ? X86_INVALID : X86_SPECIAL;  // far jmp
+      case 0xEB:                       return X86_REL8;
+      case 0xF6: case 0xF7:            return X86_SPECIAL;  // the immediate's presence depends on the ModRM byte
+      case 0xFE: case 0xFF:            return X86_MODRM;
+      default:                         /* empty */ break;
+   }
+   if ((op >= 0xD0)&&(op < 0xE0)) return X86_MODRM;  // shifts and x87
+   if ((op >= 0xE0)&&(op < 0xE4)) return X86_REL8;   // loop, jcxz
+   if ((op >= 0xE4)&&(op < 0xE8)) return X86_IMM8;   // in, out
+   return 0;
+}
+
+/** Returns the X86_* flags describing an opcode in the two-byte (0x0F-prefixed) opcode map */
+static uint32 GetX86TwoByteOpcodeFlags(uint8 op)
+{
+   if (op < 0x10)
+   {
+      switch(op)
+      {
+         case 0x00: case 0x01: case 0x02: case 0x03: case 0x0D: return X86_MODRM;
+         case 0x0F:                                             return X86_MODRM|X86_IMM8;  // 3DNow!
+         case 0x04: case 0x0A: case 0x0C:                       return X86_INVALID;
+         default:                                               return 0;
+      }
+   }
+   if ((op >= 0x24)&&(op < 0x28)) return X86_INVALID;
+   if (op < 0x30) return X86_MODRM;
+   if (op < 0x38) return 0;
+   if (op < 0x40) return X86_INVALID;  // (0x38 and 0x3A are the three-byte escapes, and are handled before we get here)
+   if ((op >= 0x70)&&(op < 0x74)) return X86_MODRM|X86_IMM8;
+   if (op == 0x77) return 0;
+   if (op < 0x80) return X86_MODRM;
+   if (op < 0x90) return X86_RELZ;
+   if (op < 0xA0) return X86_MODRM;
+   switch(op)
+   {
+      case 0xA0: case 0xA1: case 0xA2: case 0xA8: case 0xA9: case 0xAA: return 0;
+      case 0xA6: case 0xA7:                                             return X86_INVALID;
+      case 0xA4: case 0xAC: case 0xBA: case 0xC2: case 0xC4: case 0xC5: case 0xC6: return X86_MODRM|X86_IMM8;
+      default:                                                          /* empty */ break;
+   }
+   return ((op >= 0xC8)&&(op < 0xD0)) ? 0 : X86_MODRM;  // bswap
+}
+
+/** Returns the (1, 2, 4 or 8 byte) little-endian value at (p), sign-extended to 64 bits */
+static int64 GetSignedFieldValue(const uint8 * p, uint32 numBytes)
+{
+   switch(numBytes)
+   {
+      case 1:  return (int8) p[0];
+      case 2:  {int16 v; memcpy(&v, p, sizeof(v)); return v;}
+      case 4:  {int32 v; memcpy(&v, p, sizeof(v)); return v;}
+      default: {int64 v; memcpy(&v, p, sizeof(v)); return v;}
+   }
+}
+
+/** Decodes the length of the x86 (or x86-64, if (is64Bit) is true) instruction at (p), and the locations of any fields in it
+  * that might contain addresses.  Returns B_NO_ERROR on success, or B_ERROR if the bytes aren't an instruction we can decode
+  * or if the instruction would extend past the (numBytesAvailable) bytes that are available.
+  */
+static status_t DecodeX86Instruction(const uint8 * p, uint64 numBytesAvailable, bool is64Bit, X86Instruction & ret)
+{
+   ret = X86Instruction();
+   const uint32 maxLength = (uint32) muscleMin(numBytesAvailable, (uint64) 15);  // no x86 instruction is longer than 15 bytes
+
+   // Prefixes
+   uint32 i = 0;
+   bool operandSize16 = false, addressSizeOverride = false, rexW = false;
+   while(i < maxLength)
+   {
+      const uint8 b = p[i];
+      if (b == 0x66) operandSize16 = true;
+      else if (b == 0x67) addressSizeOverride = true;
+      else if ((is64Bit)&&((b & 0xF0) == 0x40)) rexW = ((b & 0x08) != 0);
+      else if ((b != 0xF0)&&(b != 0xF2)&&(b != 0xF3)&&(b != 0x26)&&(b != 0x2E)&&(b != 0x36)&&(b != 0x3E)&&(b != 0x64)&&(b != 0x65)) break;
+      i++;
+   }
+   if (i >= maxLength) return B_ERROR;
+
+   // Opcode
+   const uint8 op = p[i++];
+   uint32 flags;
+   if (op == 0x0F)
+   {
+      if (i >= maxLength) return B_ERROR;
+      const uint8 op2 = p[i++];
+      if (op2 == 0x38) flags = X86_MODRM;
+      else if (op2 == 0x3A) flags = X86_MODRM|X86_IMM8;
+      else flags = GetX86TwoByteOpcodeFlags(op2);
+      if ((op2 == 0x38)||(op2 == 0x3A)) i++;  // skip the third opcode byte
+   }
+   else
+   {
+      flags = GetX86OneByteOpcodeFlags(op, is64Bit);
+      if (flags & X86_SPECIAL)
+      {
+         const bool isVexOrEvex = ((op == 0x62)||(op == 0xC4)||(op == 0xC5))&&((is64Bit)||((i < maxLength)&&((p[i] & 0xC0) == 0xC0)));
+         if (isVexOrEvex)
+         {
+            // VEX and EVEX prefixes encode the opcode-map, and are followed by the opcode and (usually) a ModRM byte
+            const uint32 numPayloadBytes = (op == 0x62) ? 3 : ((op == 0xC4) ? 2 : 1);
+            if ((i+numPayloadBytes) >= maxLength) return B_ERROR;
+
+            const uint32 map = (op == 0xC5) ? 1 : (p[i] & ((op == 0x62) ? 0x07 : 0x1F));
+            i += numPayloadBytes;
+            const uint8 vexOp = p[i++];
+            switch(map)
+            {
+               case 1:          flags = GetX86TwoByteOpcodeFlags(vexOp); break;
+               case 2: case 5: case 6: flags = X86_MODRM;            break;
+               case 3:          flags = X86_MODRM|X86_IMM8;           break;
+               default:         return B_ERROR;
+            }
+            if (flags & (X86_INVALID|X86_REL8|X86_RELZ)) return B_ERROR;
+         }
+         else if ((op == 0x62)||(op == 0xC4)||(op == 0xC5)) flags = X86_MODRM;  // BOUND, LES, LDS
+         else if ((op == 0x9A)||(op == 0xEA)) flags = X86_IMMZ|X86_IMM16;  // far call/jmp:  offset and segment
+         else if ((op >= 0xA0)&&(op < 0xA4))
+         {
+            // mov to/from a memory-offset, which is address-sized
+            const uint32 numBytes = is64Bit ? (addressSizeOverride ? 4 : 8) : (addressSizeOverride ? 2 : 4);
+            if (((numBytes >= 4)&&(ret.AddAddressField(AddressField::TYPE_ABSOLUTE, i, numBytes) != B_NO_ERROR))||((i+numBytes) > maxLength)) return B_ERROR;
+            ret._length = i+numBytes;
+            return B_NO_ERROR;
+         }
+         else if ((op >= 0xB8)&&(op < 0xC0))
+         {
+            // mov immediate to register
+            const uint32 numBytes = rexW ? 8 : (operandSize16 ? 2 : 4);
+            if (((numBytes >= 4)&&(ret.AddAddressField(AddressField::TYPE_ABSOLUTE, i, numBytes) != B_NO_ERROR))||((i+numBytes) > maxLength)) return B_ERROR;
+            ret._length = i+numBytes;
+            return B_NO_ERROR;
+         }
+         else  // 0xF6 or 0xF7:  test has an immediate, but the other instructions in this group don't
+         {
+            if (i >= maxLength) return B_ERROR;
+            const uint32 reg = (p[i] >> 3) & 0x07;
+            flags = X86_MODRM|((reg < 2) ? ((op == 0xF6) ? X86_IMM8 : X86_IMMZ) : 0);
+         }
+      }
+   }
+   if ((flags & X86_INVALID)||(i > maxLength)) return B_ERROR;
+
+   // ModRM, SIB and displacement
+   if (flags & X86_MODRM)
+   {
+      if (i >= maxLength) return B_ERROR;
+      const uint8 modrm = p[i++];
+      const uint32 mod  = modrm >> 6;
+      const uint32 rm   = modrm & 0x07;
+      if (mod != 3)
+      {
+         if ((is64Bit == false)&&(addressSizeOverride))
+         {
+            // 16-bit addressing:  no SIB byte, and displacements are too small to be interesting
+            if ((mod == 0)&&(rm == 6)) i += 2;
+            else if (mod == 1) i += 1;
+            else if (mod == 2) i += 2;
+         }
+         else
+         {
+            bool hasBaseRegister = true;
+            if (rm == 4)
+            {
+               if (i >= maxLength) return B_ERROR;
+               const uint8 sib = p[i++];
+               if ((mod == 0)&&((sib & 0x07) == 5)) hasBaseRegister = false;
+            }
+
+            if ((mod == 0)&&(rm == 5))
+            {
+               // RIP-relative in 64-bit mode, or an absolute address in 32-bit mode
+               if (ret.AddAddressField(is64Bit ? AddressField::TYPE_RELATIVE : AddressField::TYPE_ABSOLUTE, i, 4) != B_NO_ERROR) return B_ERROR;
+               i += 4;
+            }
+            else if ((mod == 2)||(hasBaseRegister == false))
+            {
+               // a 32-bit displacement might be the address of a global array, e.g. 0x404040(,%rax,4)
+               if (ret.AddAddressField(AddressField::TYPE_ABSOLUTE, i, 4) != B_NO_ERROR) return B_ERROR;
+               i += 4;
+            }
+            else if (mod == 1) i += 1;
+         }
+      }
+   }
+
+   // Immediates and branch-displacements
+   if (flags & X86_IMM8)  i += 1;
+   if (flags & X86_IMM16) i += 2;
+   if (flags & X86_IMMZ)
+   {
+      const uint32 numBytes = ((operandSize16)&&(rexW == false)) ? 2 : 4;
+      if ((numBytes == 4)&&(ret.AddAddressField(AddressField::TYPE_ABSOLUTE, i, 4) != B_NO_ERROR)) return B_ERROR;
+      i += numBytes;
+   }
+   if (flags & X86_REL8)
+   {
+      if (ret.AddAddressField(AddressField::TYPE_RELATIVE, i, 1) != B_NO_ERROR) return B_ERROR;
+      i += 1;
+   }
+   if (flags & X86_RELZ)
+   {
+      const uint32 numBytes = ((operandSize16)&&(is64Bit == false)) ? 2 : 4;
+      if (ret.AddAddressField(AddressField::TYPE_RELATIVE, i, numBytes) != B_NO_ERROR) return B_ERROR;
+      i += numBytes;
+   }
+   if (i > maxLength) return B_ERROR;
+
+   ret._length = i;
+   return B_NO_ERROR;
+}
+
+class CompareElfSymbolsFunctor
+{
+public:
+   CompareElfSymbolsFunctor() {/* empty */}
+
+   /** Sorts by address; for aliases (several symbols at the same address), global symbols come first, then weak, then local */
+   int Compare(const ElfSymbol & s1, const ElfSymbol & s2, void *) const
+   {
+      int ret = muscleCompare(s1._address, s2._address);
+      if (ret == 0) ret = muscleCompare(GetBindingRank(s1._binding), GetBindingRank(s2._binding));
+      if (ret == 0) ret = s1._name.CompareTo(s2._name);
+      return ret;
+   }
+
+private:
+   static uint32 GetBindingRank(uint32 binding) {return (binding == STB_GLOBAL) ? 0 : ((binding == STB_WEAK) ? 1 : 2);}
+};
+
+/** What an address (or something that might be an address) found in an executable's machine code refers to */
+class ResolvedAddress
+{
+public:
+   enum {
+      TYPE_UNKNOWN = 0,     // not an address we know anything about
+      TYPE_READ_ONLY_DATA,  // points into a read-only data section
+      TYPE_SYMBOL           // points into a function or a writable data object (or into a section with no symbol at its start)
+   };
+
+   ResolvedAddress() : _type(TYPE_UNKNOWN), _symbolName(NULL), _offset(0), _data(NULL), _numBytes(0) {/* empty */}
+
+   uint32 _type;
+   const String * _symbolName;  // for TYPE_SYMBOL:  the (unique) name of the symbol
+   uint64 _offset;              // for TYPE_SYMBOL:  how far past the start of the symbol the address is
+   const uint8 * _data;         // for TYPE_READ_ONLY_DATA:  the data that the address points to
+   uint64 _numBytes;            // for TYPE_READ_ONLY_DATA:  the number of bytes available at (_data)
+};
+
+/** Everything the raw-byte prefilter needs to know about one ELF executable:  its function-symbols (named the same way
+  * ParseObjdumpOutput() names them), its machine code and read-only data, and indices for resolving addresses.
+  */
+class PrefilterImage
+{
+public:
+   PrefilterImage() : _imageStart(0), _imageEnd(0) {/* empty */}
+
+   /** Memory-maps (fileName) and reads its symbols.  Returns B_NO_ERROR on success, or B_ERROR if the file
+     * couldn't be read, has no function-symbols, or isn't an x86 or x86-64 ELF file.
+     */
+   status_t Open(const char * fileName)
+   {
+      if (_elfFile.Open(fileName) != B_NO_ERROR) return B_ERROR;
+      if ((_elfFile.GetMachine() != (_elfFile.Is64Bit() ? EM_X86_64 : EM_386))) return B_ERROR;  // DecodeX86Instruction() is the only decoder we have
+      _elfFile.GetReadOnlyData(_roData);
+
+      Queue<ElfSymbol> funcSymbols, dataSymbols;
+      if ((_elfFile.GetSymbols(STT_FUNC, funcSymbols) != B_NO_ERROR)||(_elfFile.GetSymbols(STT_OBJECT, dataSymbols) != B_NO_ERROR)) return B_ERROR;
+      funcSymbols.Sort(CompareElfSymbolsFunctor());
+      dataSymbols.Sort(CompareElfSymbolsFunctor());
+
+      const Queue<ElfSection> & sections = _elfFile.GetSections();
+      for (uint32 i=0; i<funcSymbols.GetNumItems(); i++)
+      {
+         const ElfSymbol & es = funcSymbols[i];
+         if ((i > 0)&&(es._address == funcSymbols[i-1]._address)) continue;  // objdump shows only one label per address, so we ignore aliases too
+         if ((_elfFile.GetCodeBytes(es._address, es._numBytes) == NULL)||(AddSymbol(es._name, es._address, es._numBytes, _functions) != B_NO_ERROR)) continue;
+         if (_indexEntries.Put(*_functions.GetLastKey(), *_functions.GetLastValue()) != B_NO_ERROR) return B_ERROR;
+      }
+      if (_functions.IsEmpty()) return B_ERROR;
+
+      // Writable data objects (e.g. global variables) get indexed too, so that references to them can be compared by name
+      for (uint32 i=0; i<dataSymbols.GetNumItems(); i++)
+      {
+         const ElfSymbol & es = dataSymbols[i];
+         if ((i > 0)&&(es._address == dataSymbols[i-1]._address)) continue;
+         if ((sections[es._sectionIndex]._flags & SHF_WRITE)&&(AddSymbol(es._name, es._address, es._numBytes, _indexEntries) != B_NO_ERROR)) return B_ERROR;
+      }
+
+      // Every code and writable-data section also gets a pseudo-symbol at its start (e.g. ".plt"), so that addresses
+      // that aren't inside any symbol (e.g. PLT stubs) resolve consistently rather than to some preceding symbol.
+      _imageStart = _functions.GetFirstValue()->_startAddress;
+      _imageEnd   = _imageStart;
+      for (uint32 i=0; i<sections.GetNumItems(); i++)
+      {
+         const ElfSection & s = sections[i];
+         if (((s._flags & SHF_ALLOC) == 0)||(s._numBytes == 0)) continue;
+
+         _imageStart = muscleMin(_imageStart, s._address);
+         _imageEnd   = muscleMax(_imageEnd,   s._address+s._numBytes);
+         if ((s._flags & (SHF_EXECINSTR|SHF_WRITE))&&(s._name.HasChars())&&(AddSymbol(s._name, s._address, s._numBytes, _indexEntries) != B_NO_ERROR)) return B_ERROR;
+      }
+      ExtendEntries(_indexEntries);
+
+      // The disassembly gets resolved against only the labels that objdump would show in a full disassembly, so that
+      // a prefiltered parse resolves each address to the same name that a normal parse would
+      if ((AddCodeLabels(fileName) != B_NO_ERROR)||(_disassemblyIndex.SetSymbols(_disassemblyEntries) != B_NO_ERROR)) return B_ERROR;
+      return _index.SetSymbols(_indexEntries);
+   }
+
+   /** Returns our function-symbols (unique name -> address range), sorted by address */
+   const Hashtable<String, SymbolRecord> & GetFunctions() const {return _functions;}
+
+   /** Returns the index that SanitizeLine()'s deferred addresses should be resolved against, when only some of our functions are disassembled.
+     * It holds the same labels that ParseObjdumpOutput() would have indexed after disassembling all of them.
+     */
+   const AddressIndex & GetAddressIndex() const {return _disassemblyIndex;}
+
+   const ElfFile & GetElfFile() const {return _elfFile;}
+
+   /** Sets (ret) to describe what (addr) points to in our executable */
+   void ResolveAddress(uint64 addr, ResolvedAddress & ret) const
+   {
+      ret = ResolvedAddress();
+      if ((addr < _imageStart)||(addr >= _imageEnd)) return;  // quick rejection of most non-address values
+
+      const ReadOnlyDataRegion * roRegion = _roData.GetRegionContaining(addr);
+      if (roRegion)
+      {
+         ret._type     = ResolvedAddress::TYPE_READ_ONLY_DATA;
+         ret._data     = roRegion->_data+(addr-roRegion->_address);
+         ret._numBytes = roRegion->_numBytes-(addr-roRegion->_address);
+         return;
+      }
+
+      const String * symbolName = _index.GetSymbolNameForAddress(addr, NULL);
+      const SymbolRecord * rec = symbolName ? _indexEntries.Get(*symbolName) : NULL;
+      if (rec)
+      {
+         ret._type       = ResolvedAddress::TYPE_SYMBOL;
+         ret._symbolName = symbolName;
+         ret._offset     = addr-rec->_startAddress;
+      }
+   }
+
+private:
+   PrefilterImage(const PrefilterImage &);              // deliberately unimplemented
+   PrefilterImage & operator=(const PrefilterImage &);  // deliberately unimplemented
+
+   /** Sorts (table) by address, and then extends each of its entries up to the start of the next one (as in ParseObjdumpOutput()),
+     * but never past the end of its own section
+     */
+   void ExtendEntries(Hashtable<String, SymbolRecord> & table) const
+   {
+      table.SortByValue(CompareStartAddressesFunctor());
+
+      const Queue<ElfSection> & sections = _elfFile.GetSections();
+      SymbolRecord * prev = NULL;
+      uint64 prevSectionEnd = 0;
+      for (HashtableIterator<String, SymbolRecord> iter(table); iter.HasData(); iter++)
+      {
+         SymbolRecord & rec = iter.GetValue();
+         if (prev) prev->_length = muscleMin(rec._startAddress, prevSectionEnd)-prev->_startAddress;
+
+         prev = &rec;
+         prevSectionEnd = rec._startAddress+rec._length;
+         for (uint32 i=0; i<sections.GetNumItems(); i++)
+         {
+            const ElfSection & s = sections[i];
+            if ((s._flags & SHF_ALLOC)&&(rec._startAddress >= s._address)&&((rec._startAddress-s._address) < s._numBytes)) {prevSectionEnd = muscleMax(prevSectionEnd, s._address+s._numBytes); break;}
+         }
+      }
+   }
+
+   /** Fills in (_disassemblyEntries) with the labels objdump shows when disassembling (fileName):  our function-symbols, a label for each
+     * code section that doesn't start with one of them (e.g. ".text"), and, for the code sections that contain no function-symbols at
+     * all (e.g. ".plt"), whatever labels objdump shows for them (e.g. "printf@plt", which it synthesizes from the relocations).
+     * Those last ones are found by disassembling just those sections, which are small.
+     */
+   status_t AddCodeLabels(const char * fileName)
+   {
+      for (HashtableIterator<String, SymbolRecord> iter(_functions); iter.HasData(); iter++) if (_disassemblyEntries.Put(iter.GetKey(), iter.GetValue()) != B_NO_ERROR) return B_ERROR;
+
+      Queue<String> args;
+      (void) args.AddTail(GetDisassemblerPath());
+      (void) args.AddTail("-d");
+      (void) args.AddTail("--no-show-raw-insn");
+      const uint32 numFixedArgs = args.GetNumItems();
+
+      const Queue<ElfSection> & sections = _elfFile.GetSections();
+      for (uint32 i=0; i<sections.GetNumItems(); i++)
+      {
+         const ElfSection & s = sections[i];
+         if (((s._flags & SHF_EXECINSTR) == 0)||(s._numBytes == 0)||(s._name.IsEmpty())) continue;
+
+         bool hasFunctions = false, startsWithFunction = false;
+         for (HashtableIterator<String, SymbolRecord> iter(_functions); iter.HasData(); iter++)
+         {
+            const uint64 addr = iter.GetValue()._startAddress;
+            if ((addr >= s._address)&&((addr-s._address) < s._numBytes)) hasFunctions = true;
+            if (addr == s._address) startsWithFunction = true;
+         }
+         if (hasFunctions == false)
+         {
+            (void) args.AddTail("-j");
+            (void) args.AddTail(s._name);
+         }
+         else if ((startsWithFunction == false)&&(AddSymbol(s._name, s._address, 0, _disassemblyEntries) != B_NO_ERROR)) return B_ERROR;
+      }
+
+      if (args.GetNumItems() > numFixedArgs)
+      {
+         (void) args.AddTail(GetFileNameArgument(fileName));
+
+         ChildProcess objdump;
+         FILE * fpIn = objdump.Open(args);
+         if (fpIn == NULL) return B_ERROR;
+
+         status_t ret = B_NO_ERROR;
+         LineReader reader(fpIn);
+         uint32 lineLength;
+         char * line;
+         while((line = reader.GetNextLine(lineLength)) != NULL)
+         {
+            // label-lines look like e.g. "0000000000001030 <printf@plt>:"
+            line = TrimLine(line, lineLength);
+            if ((lineLength < 2)||(line[lineLength-2] != '>')||(line[lineLength-1] != ':')) continue;
+
+            const uint64 addr = Atoxll(line);
+            const char * name = strrchr(line, '<');
+            if ((addr > 0)&&(name)&&(AddSymbol(String(name+1, (uint32)((&line[lineLength-2])-(name+1))), addr, 0, _disassemblyEntries) != B_NO_ERROR)) ret = B_ERROR;
+         }
+         if ((objdump.Close() != 0)||(ret != B_NO_ERROR)) return B_ERROR;
+      }
+
+      ExtendEntries(_disassemblyEntries);
+      return B_NO_ERROR;
+   }
+
+   /** Adds an entry for the given symbol to (table), under a unique version of (name) */
+   static status_t AddSymbol(const String & name, uint64 address, uint64 numBytes, Hashtable<String, SymbolRecord> & table)
+   {
+      SymbolRecord rec;
+      rec._startAddress = address;
+      rec._length       = numBytes;
+      return table.Put(GetUniqueSymbolName(name, table), rec);
+   }
+
+   ElfFile _elfFile;
+   ReadOnlyData _roData;
+   Hashtable<String, SymbolRecord> _functions;     // unique function-name -> address range, sorted by address
+   Hashtable<String, SymbolRecord> _indexEntries;  // (_functions), writable data objects and sections' pseudo-symbols, sorted by address
+   AddressIndex _index;                            // built from (_indexEntries); used to compare the machine code (see ResolveAddress())
+   Hashtable<String, SymbolRecord> _disassemblyEntries;  // the labels that objdump shows in the code sections, sorted by address (see AddCodeLabels())
+   AddressIndex _disassemblyIndex;                       // built from (_disassemblyEntries); used to resolve the disassembly (see GetAddressIndex())
+   uint64 _imageStart;                             // the lowest address of any of our loaded sections
+   uint64 _imageEnd;                               // one past the highest address of any of our loaded sections
+};
+
+/** Returns true iff SanitizeLine() would expand the read-only data at (a) and at (b) to the same text */
+static bool AreReadOnlyDataStringsEquivalent(const ResolvedAddress & a, const ResolvedAddress & b)
+{
+   const bool isOffsetA = IsOffset(a._data, a._numBytes);
+   const bool isOffsetB = IsOffset(b._data, b._numBytes);
+   if ((isOffsetA)||(isOffsetB)) return (isOffsetA == isOffsetB);
+
+   for (uint64 i=0; true; i++)
+   {
+      const uint8 ca = (i < a._numBytes) ? a._data[i] : 0;
+      const uint8 cb = (i < b._numBytes) ? b._data[i] : 0;
+      if (ca != cb) return false;
+      if (ca == 0)  return true;
+   }
+}
+
+/** Returns true iff (addrA) in (imageA) and (addrB) in (imageB) refer to equivalent locations (the same offset
+  * into the same-named symbol, or read-only data with the same contents).
+  * @param unknownsAreEquivalent what to return if neither address refers to anything we know about (e.g. because
+  *                              they are actually just numeric constants)
+  */
+static bool AreLocationsEquivalent(const PrefilterImage & imageA, uint64 addrA, const PrefilterImage & imageB, uint64 addrB, bool unknownsAreEquivalent)
+{
+   ResolvedAddress ra, rb;
+   imageA.ResolveAddress(addrA, ra);
+   imageB.ResolveAddress(addrB, rb);
+   if (ra._type != rb._type) return false;
+
+   switch(ra._type)
+   {
+      case ResolvedAddress::TYPE_READ_ONLY_DATA: return AreReadOnlyDataStringsEquivalent(ra, rb);
+      case ResolvedAddress::TYPE_SYMBOL:         return (ra._offset == rb._offset)&&(*ra._symbolName == *rb._symbolName);
+      default:                                   return unknownsAreEquivalent;
+   }
+}
+
+/** Returns true iff the machine code of function (funcA) in (imageA) is equivalent to that of function (funcB) in (imageB):
+  * every instruction must be byte-for-byte identical, except for the fields that might hold addresses, which must refer
+  * to equivalent locations (see AreLocationsEquivalent()).  Wherever it is unsure (e.g. an instruction it can't decode),
+  * this returns false, since functions that might differ simply get disassembled and compared in the usual way.
+  */
+static bool AreFunctionsEquivalent(const PrefilterImage & imageA, const SymbolRecord & funcA, const PrefilterImage & imageB, const SymbolRecord & funcB)
+{
+   if (funcA._length != funcB._length) return false;
+
+   const uint64 numBytes = funcA._length;
+   const uint8 * bytesA = imageA.GetElfFile().GetCodeBytes(funcA._startAddress, numBytes);
+   const uint8 * bytesB = imageB.GetElfFile().GetCodeBytes(funcB._startAddress, numBytes);
+   if ((bytesA == NULL)||(bytesB == NULL)) return false;
+
+   const bool is64Bit = imageA.GetElfFile().Is64Bit();
+   X86Instruction insn;
+   for (uint64 offset=0; offset<numBytes; offset+=insn._length)
+   {
+      // Since everything except the address-fields must match, the instruction decodes the same way in (bytesB)
+      const uint8 * insnA = bytesA+offset;
+      const uint8 * insnB = bytesB+offset;
+      if (DecodeX86Instruction(insnA, numBytes-offset, is64Bit, insn) != B_NO_ERROR) return false;
+
+      uint32 numBytesChecked = 0;
+      for (uint32 i=0; i<insn._numAddressFields; i++)
+      {
+         const AddressField & field = insn._addressFields[i];
+         if (memcmp(insnA+numBytesChecked, insnB+numBytesChecked, field._offset-numBytesChecked) != 0) return false;
+
+         const int64 valueA = GetSignedFieldValue(insnA+field._offset, field._numBytes);
+         const int64 valueB = GetSignedFieldValue(insnB+field._offset, field._numBytes);
+         const uint64 locationA = (field._type == AddressField::TYPE_RELATIVE) ? (funcA._startAddress+offset+insn._length+valueA) : (uint64)((field._numBytes < 8) ? (valueA & 0xFFFFFFFF) : valueA);
+         const uint64 locationB = (field._type == AddressField::TYPE_RELATIVE) ? (funcB._startAddress+offset+insn._length+valueB) : (uint64)((field._numBytes < 8) ? (valueB & 0xFFFFFFFF) : valueB);
+         if (AreLocationsEquivalent(imageA, locationA, imageB, locationB, (valueA == valueB)) == false) return false;
+
+         numBytesChecked = field._offset+field._numBytes;
+      }
+      if (memcmp(insnA+numBytesChecked, insnB+numBytesChecked, insn._length-numBytesChecked) != 0) return false;
+   }
+   return true;
+}
+
+/** Compares the raw machine code of each pair of same-named functions; there is one task per pair */
+class PrefilterTasks : public AbstractParallelTasks
+{
+public:
+   PrefilterTasks(const PrefilterImage & imageA, const PrefilterImage & imageB) : _imageA(imageA), _imageB(imageB)
+   {
+      for (HashtableIterator<String, SymbolRecord> iter(imageA.GetFunctions()); iter.HasData(); iter++)
+      {
+         const SymbolRecord * funcB = imageB.GetFunctions().Get(iter.GetKey());
+         if ((funcB)&&((_funcsA.AddTail(&iter.GetValue()) != B_NO_ERROR)||(_funcsB.AddTail(funcB) != B_NO_ERROR)||(_names.AddTail(&iter.GetKey()) != B_NO_ERROR))) WARN_OUT_OF_MEMORY;
+      }
+      (void) _isEquivalent.EnsureSize(_names.GetNumItems(), true);
+   }
+
+   virtual void ExecuteTask(uint32 taskIdx, uint32 /*workerIdx*/) {_isEquivalent[taskIdx] = AreFunctionsEquivalent(_imageA, *_funcsA[taskIdx], _imageB, *_funcsB[taskIdx]);}
+
+   virtual void ReportProgress(uint32 numTasksCompleted, uint32 numTasks)
+   {
+      char buf[128];
+      muscleSprintf(buf, "Comparing machine code: " UINT32_FORMAT_SPEC "/" UINT32_FORMAT_SPEC " (%.0f%%)...", numTasksCompleted, numTasks, (100.0f*numTasksCompleted)/numTasks);
+      _progressDisplay.SetStatus("prefilter", buf);
+   }
+
+   uint32 GetNumPairs() const {return _names.GetNumItems();}
+   const String & GetName(uint32 idx) const {return *_names[idx];}
+   uint64 GetNumBytes(uint32 idx) const {return _funcsA[idx]->_length;}
+   bool IsEquivalent(uint32 idx) const {return _isEquivalent[idx];}
+
+private:
+   const PrefilterImage & _imageA;
+   const PrefilterImage & _imageB;
+   Queue<const String *> _names;
+   Queue<const SymbolRecord *> _funcsA;
+   Queue<const SymbolRecord *> _funcsB;
+   Queue<bool> _isEquivalent;  // one per pair, written by whichever worker compared that pair
+};
+
+/** Tells ParseObjdumpOutput() which of an executable's functions need to be disassembled, when the raw-byte prefilter is in use */
+class DisassemblyTargets
+{
+public:
+   DisassemblyTargets() : _image(NULL) {/* empty */}
+
+   const PrefilterImage * _image;          // the executable's function-symbols and address-index
+   Hashtable<uint64, String> _functions;   // start address -> unique name, for each function that must be disassembled (sorted by address):
+                                           // those whose machine code might differ, and those with no same-named counterpart in the other executable
+};
+
+class CompareFunctionSizesFunctor
+{
+public:
+   CompareFunctionSizesFunctor() {/* empty */}
+
+   int Compare(const uint32 & idx1, const uint32 & idx2, void * cookie) const
+   {
+      const PrefilterTasks & tasks = *((const PrefilterTasks *) cookie);
+      return muscleCompare(tasks.GetNumBytes(idx2), tasks.GetNumBytes(idx1));  // largest first
+   }
+};
+
+/** Opens (fileA) into (imageA) and (fileB) into (imageB).  Returns B_NO_ERROR on success, or B_ERROR if the prefilter can't
+  * be used on these files (e.g. they aren't ELF files, they have no symbol tables, or they are for different architectures).
+  */
+static status_t OpenPrefilterImages(const char * fileA, PrefilterImage & imageA, const char * fileB, PrefilterImage & imageB)
+{
+   if ((imageA.Open(fileA) != B_NO_ERROR)||(imageB.Open(fileB) != B_NO_ERROR)) return B_ERROR;
+   return ((imageA.GetElfFile().GetMachine() == imageB.GetElfFile().GetMachine())&&(imageA.GetElfFile().Is64Bit() == imageB.GetElfFile().Is64Bit())) ? B_NO_ERROR : B_ERROR;
+}
+
+/** Compares the raw machine code of (imageA) and (imageB) (see OpenPrefilterImages()), so that only the functions that might
+  * differ need to be disassembled.  (retTargetsA) and (retTargetsB) are filled in with the functions to disassemble, and
+  * (retNumMatches) is set to the number of functions found to be equivalent.
+  */
+static void PrefilterExecutables(const PrefilterImage & imageA, DisassemblyTargets & retTargetsA, const PrefilterImage & imageB, DisassemblyTargets & retTargetsB, uint32 numThreads, uint32 & retNumMatches)
+{
+   PrefilterTasks tasks(imageA, imageB);
+   Queue<uint32> taskIndices;
+   for (uint32 i=0; i<tasks.GetNumPairs(); i++) (void) taskIndices.AddTail(i);
+   taskIndices.Sort(CompareFunctionSizesFunctor(), 0, MUSCLE_NO_LIMIT, &tasks);
+   WorkStealingExecutor(tasks).ExecuteTasks(taskIndices, numThreads);
+   _progressDisplay.FinishStatus("prefilter");
+
+   retTargetsA._image = &imageA;
+   retTargetsB._image = &imageB;
+   retNumMatches = 0;
+   for (uint32 i=0; i<tasks.GetNumPairs(); i++)
+   {
+      if (tasks.IsEquivalent(i)) retNumMatches++;
+      else
+      {
+         const String & name = tasks.GetName(i);
+         (void) retTargetsA._functions.Put(imageA.GetFunctions().Get(name)->_startAddress, name);
+         (void) retTargetsB._functions.Put(imageB.GetFunctions().Get(name)->_startAddress, name);
+      }
+   }
+
+   // Functions that only exist in one of the executables get disassembled too, so that they can be reported (and matched up as renames)
+   uint32 numUnpaired = 0;
+   for (HashtableIterator<String, SymbolRecord> iter(imageA.GetFunctions()); iter.HasData(); iter++) if ((imageB.GetFunctions().ContainsKey(iter.GetKey()) == false)&&(retTargetsA._functions.Put(iter.GetValue()._startAddress, iter.GetKey()) == B_NO_ERROR)) numUnpaired++;
+   for (HashtableIterator<String, SymbolRecord> iter(imageB.GetFunctions()); iter.HasData(); iter++) if ((imageA.GetFunctions().ContainsKey(iter.GetKey()) == false)&&(retTargetsB._functions.Put(iter.GetValue()._startAddress, iter.GetKey()) == B_NO_ERROR)) numUnpaired++;
+
+   retTargetsA._functions.SortByKey();
+   retTargetsB._functions.SortByKey();
+
+   _progressDisplay.LogMessage(MUSCLE_LOG_INFO, String("Prefilter:  %1 of %2 same-named functions have equivalent machine code; %3 need to be disassembled, plus %4 that are present in only one executable").Arg(retNumMatches).Arg(tasks.GetNumPairs()).Arg(tasks.GetNumPairs()-retNumMatches).Arg(numUnpaired));
+}
+
+enum {MAX_DISASSEMBLY_RANGES_PER_JOB = 8};  // each range costs an objdump process-launch, so we don't want too many of them
+
+/** Groups the functions in (targets) into at most (maxRanges) address-ranges for objdump to disassemble.  Adjacent functions
+  * in the same section share a range; if that still leaves too many ranges, the ones separated by the smallest gaps get merged
+  * too (the functions inside those gaps get disassembled as well, but ParseObjdumpOutput() ignores them).
+  */
+static void GetDisassemblyRanges(const DisassemblyTargets & targets, uint32 maxRanges, Queue<uint64> & retStarts, Queue<uint64> & retStops)
+{
+   retStarts.Clear();
+   retStops.Clear();
+
+   const ElfFile & elfFile = targets._image->GetElfFile();
+   Queue<int32> sectionIndices;
+   for (HashtableIterator<uint64, String> iter(targets._functions); iter.HasData(); iter++)
+   {
+      const uint64 start        = iter.GetKey();
+      const uint64 stop         = start+targets._image->GetFunctions().Get(iter.GetValue())->_length;
+      const int32 sectionIdx    = elfFile.GetExecutableSectionIndex(start);
+      if ((retStops.HasItems())&&(sectionIndices.Tail() == sectionIdx)&&(start <= retStops.Tail())) retStops.Tail() = muscleMax(retStops.Tail(), stop);
+      else
+      {
+         (void) retStarts.AddTail(start);
+         (void) retStops.AddTail(stop);
+         (void) sectionIndices.AddTail(sectionIdx);
+      }
+   }
+   if (retStarts.GetNumItems() <= maxRanges) return;
+
+   // Find the size of the largest gap we need to close, then close every gap of that size or smaller
+   const uint64 cannotMerge = (uint64) -1;
+   Queue<uint64> gaps;
+   for (uint32 i=0; (i+1)<retStarts.GetNumItems(); i++) (void) gaps.AddTail((sectionIndices[i] == sectionIndices[i+1]) ? (retStarts[i+1]-retStops[i]) : cannotMerge);
+   Queue<uint64> sortedGaps = gaps;
+   sortedGaps.Sort();
+   const uint64 maxGap = sortedGaps[retStarts.GetNumItems()-maxRanges-1];
+
+   Queue<uint64> mergedStarts, mergedStops;
+   for (uint32 i=0; i<retStarts.GetNumItems(); i++)
+   {
+      if ((i > 0)&&(gaps[i-1] <= maxGap)&&(gaps[i-1] != cannotMerge)) mergedStops.Tail() = retStops[i];
+      else
+      {
+         (void) mergedStarts.AddTail(retStarts[i]);
+         (void) mergedStops.AddTail(retStops[i]);
+      }
+   }
+   retStarts.SwapContents(mergedStarts);
+   retStops.SwapContents(mergedStops);
+}
+
+/** Runs a single objdump process (typically restricted to an address-range) and captures its output into memory
+  * (or, with --low-memory, into a temporary file), so that several objdump processes can be disassembling different
+  * parts of the same executable at once.
+  */
+class ObjdumpShardThread : public Thread
+{
+public:
+   /** @param args the objdump command line (see ChildProcess::Open()) */
+   ObjdumpShardThread(const Queue<String> & args, const String & spillDirectory) : _args(args), _spillDirectory(spillDirectory), _spillFile(NULL), _launchFailed(false), _exitCode(-1) {/* empty */}
+   virtual ~ObjdumpShardThread() {if (_spillFile) fclose(_spillFile);}
+
+   /** Blocks until our objdump process has exited, then returns a FILE handle that reads its captured output.
+     * Returns NULL on failure, or if objdump produced no output.  The caller should fclose() the returned handle when done with it.
+     */
+   FILE * OpenOutput()
+   {
+      (void) WaitForInternalThreadToExit();
+      if (_launchFailed) return NULL;
+      if (_spillFile)
+      {
+         FILE * ret = _spillFile;
+         _spillFile = NULL;
+         rewind(ret);
+         return ret;
+      }
+      return _output.IsEmpty() ? NULL : fmemopen(const_cast<char *>(_output()), _output.Length(), "r");
+   }
+
+   /** Returns our objdump process's exit code (see ChildProcess::Close()), or -1 if it couldn't be run or its output couldn't be captured.
+     * Only valid after OpenOutput() has returned.
+     */
+   int GetExitCode() const {return _launchFailed ? -1 : _exitCode;}
+
+protected:
+   virtual void InternalThreadEntry()
+   {
+      if (_spillDirectory.HasChars())
+      {
+         _spillFile = CreateTemporaryFile(_spillDirectory, "w+b");
+         if (_spillFile == NULL) {_launchFailed = true; return;}
+      }
+
+      ChildProcess objdump;
+      FILE * fpIn = objdump.Open(_args);
+      if (fpIn)
+      {
+         char buf[64*1024];
+         size_t numBytesRead;
+         while((numBytesRead = fread(buf, 1, sizeof(buf)-1, fpIn)) > 0)
+         {
+            if (_spillFile)
+            {
+               if (fwrite(buf, 1, numBytesRead, _spillFile) != numBytesRead) _launchFailed = true;
+            }
+            else
+            {
+               buf[numBytesRead] = '\0';
+               _output += buf;
+            }
+         }
+         _exitCode = objdump.Close();
+      }
+      else _launchFailed = true;
+   }
+
+private:
+   const Queue<String> _args;
+   const String _spillDirectory;  // if non-empty, our output gets captured to a temporary file in this directory (see --low-memory)
+   String _output;
+   FILE * _spillFile;
+   bool _launchFailed;
+   int _exitCode;
+};
+DECLARE_REFTYPES(ObjdumpShardThread);
+
+/** Chooses up to (numShards-1) split-addresses that divide the .text section into roughly equally-sized
+  * address-ranges.  Every split-address is the start of a function that is not at the start of the section,
+  * so that the concatenated output of the per-range objdump processes matches the output of a single objdump process.
+  * The section and the functions come from the file's ELF headers and symbol table, so no extra objdump process is needed.
+  */
+static void GetObjdumpShardBoundaries(const char * fileName, uint32 numShards, Queue<uint64> & retBoundaries)
+{
+   retBoundaries.Clear();
+   if (numShards < 2) return;
+
+   ElfFile elfFile;
+   if (elfFile.Open(fileName) != B_NO_ERROR) return;
+
+   uint64 textStart = 0, textSize = 0;
+   bool hasSymTab = false;  // objdump only labels functions from the regular symbol table, so a stripped file gets a single objdump process
+   const Queue<ElfSection> & sections = elfFile.GetSections();
+   for (uint32 i=0; i<sections.GetNumItems(); i++)
+   {
+      const ElfSection & sec = sections[i];
+      if (sec._type == SHT_SYMTAB) hasSymTab = true;
+      else if ((textSize == 0)&&(sec._name == ".text"))
+      {
+         textStart = sec._address;
+         textSize  = sec._numBytes;
+      }
+   }
+
+   Queue<ElfSymbol> funcSymbols;
+   if ((textSize == 0)||(hasSymTab == false)||(elfFile.GetSymbols(STT_FUNC, funcSymbols) != B_NO_ERROR)) return;
+
+   Queue<uint64> funcAddrs;
+   for (uint32 i=0; i<funcSymbols.GetNumItems(); i++)
+   {
+      const uint64 addr = funcSymbols[i]._address;
+      if ((addr >= textStart)&&((addr-textStart) < textSize)&&(funcAddrs.AddTail(addr) != B_NO_ERROR)) {WARN_OUT_OF_MEMORY; return;}
+   }
+   if (funcAddrs.IsEmpty()) return;
+   funcAddrs.Sort();
+
+   uint32 funcIdx = 0;
+   for (uint32 i=1; i<numShards; i++)
+   {
+      const uint64 target = textStart+((textSize*i)/numShards);
+      while((funcIdx < funcAddrs.GetNumItems())&&((funcAddrs[funcIdx] < target)||(funcAddrs[funcIdx] <= textStart)||((retBoundaries.HasItems())&&(funcAddrs[funcIdx] <= retBoundaries.Tail())))) funcIdx++;
+      if (funcIdx >= funcAddrs.GetNumItems()) break;
+      (void) retBoundaries.AddTail(funcAddrs[funcIdx]);
+   }
+}
+
+/** Parsing state that carries over from one objdump output stream to the next (see ParseObjdumpStream()) */
+class ObjdumpParseState
+{
+public:
+   ObjdumpParseState(const char * label, const DisassemblyTargets * optTargets, StreamingSanitizer & sanitizer, Hashtable<String, SymbolRecord> & symbols)
+      : _label(label), _optTargets(optTargets), _sanitizer(sanitizer), _symbols(symbols), _curSymbolContents(NULL), _lineNumber(1), _numSymbols(0), _lastPrintAt(GetRunTime64()), _numBytesRead(0)
+   {
+      // empty
+   }
+
+   const char * _label;
+   const DisassemblyTargets * _optTargets;      // if non-NULL, only these functions are parsed (see --prefilter)
+   StreamingSanitizer & _sanitizer;             // each symbol's lines get handed to this as they are parsed
+   Hashtable<String, SymbolRecord> & _symbols;  // each symbol gets added to this as it is parsed
+   SymbolRecord * _curSymbolContents;           // the symbol we are currently parsing the lines of, or NULL if none
+   uint32 _lineNumber;
+   uint32 _numSymbols;
+   uint64 _lastPrintAt;
+   uint64 _numBytesRead;                        // total bytes read from all of the streams so far
+
+private:
+   ObjdumpParseState(const ObjdumpParseState &);  // deliberately unimplemented
+   ObjdumpParseState & operator = (const ObjdumpParseState &);  // deliberately unimplemented
+};
+
+/** Parses one stream of objdump's disassembly output into (state).  Several streams may be parsed in address-order into the same (state);
+  * for all but the first of them, (isFirstStream) must be false, so that the header-lines the first stream already gave us get skipped.
+  */
+static void ParseObjdumpStream(FILE * fpIn, bool isFirstStream, ObjdumpParseState & state)
+{
+   LineReader reader(fpIn);
+   uint32 lineLength;
+   char * line;
+   if (isFirstStream) (void) reader.GetNextLine(lineLength);   // skip the first line, as it is just the name of the executable
+   else
+   {
+      // skip the header-lines that the first shard already gave us, so that the shards' outputs join seamlessly
+      while(((line = reader.GetNextLine(lineLength)) != NULL)&&(LineStartsWith(line, "Disassembly of section") == false)) {/* empty */}
+   }
+
+   while((line = reader.GetNextLine(lineLength)) != NULL)
+   {
+      line = TrimLine(line, lineLength);
+
+      if ((lineLength >= 2)&&(line[lineLength-2] == '>')&&(line[lineLength-1] == ':'))
+      {
+         const uint64 addr = Atoxll(line);
+         if (addr == 0) continue;
+
+         // With the prefilter, we only want the functions it asked for, under the names it gave them.  Any other
+         // labels inside those functions are skipped, and anything outside of them was only disassembled incidentally.
+         const String * targetName = state._optTargets ? state._optTargets->_functions.Get(addr) : NULL;
+         if ((state._optTargets)&&(targetName == NULL)&&(state._curSymbolContents)&&((addr-state._curSymbolContents->_startAddress) < state._curSymbolContents->_length)) continue;
+
+         if (state._curSymbolContents)
+         {
+            if (state._optTargets == NULL) state._curSymbolContents->_length = muscleMax(state._curSymbolContents->_length, (addr-state._curSymbolContents->_startAddress));
+            state._curSymbolContents = NULL;
+            state._sanitizer.EndSymbol();
+         }
+         if ((state._optTargets)&&(targetName == NULL)) continue;
+
+         if (state._optTargets) state._curSymbolContents = state._symbols.PutAndGet(*targetName);
+         else
+         {
+            const char * lastOpenBracket = strrchr(line, '<');
+            const char * symbolName      = lastOpenBracket ? (lastOpenBracket+1) : line;
+            state._curSymbolContents = state._symbols.PutAndGet(GetUniqueSymbolName(String(symbolName, (uint32)(strchr(symbolName, '>')-symbolName)), state._symbols));
+         }
+         if (state._curSymbolContents)
+         {
+             state._curSymbolContents->_startAddress = addr;
+             if (state._optTargets) state._curSymbolContents->_length = state._optTargets->_image->GetFunctions().Get(*targetName)->_length;
+             state._sanitizer.BeginSymbol();
+             state._numSymbols++;
+         }
+         else WARN_OUT_OF_MEMORY;
+      }
+      else if (state._curSymbolContents)
+      {
+         char * firstTab = strchr(line, '\t');
+         if (firstTab)
+         {
+            // With the prefilter, a function's range may have been merged with the next one's (see GetDisassemblyRanges()), so the
+            // padding after it may or may not have been disassembled.  Either way, it isn't part of the function.
+            if ((state._optTargets)&&((Atoxll(line)-state._curSymbolContents->_startAddress) >= state._curSymbolContents->_length)) continue;
+
+            // skip past the address-column (e.g. "  4137ac:\t")
+            lineLength -= (uint32)((firstTab+1)-line);
+            line = TrimLine(firstTab+1, lineLength);
+         }
+
+         const bool neutralize = (strstr(line, "%rip"))||(strstr(line, "%rsp"))||((lineLength > 0)&&(line[lineLength-1] == '>'))||((LineStartsWith(line, "call"))||(LineStartsWith(line, "jmp")));
+         state._sanitizer.AddRawLine(line, lineLength, neutralize);
+      }
+
+      if (OnceEvery(MillisToMicros(100), state._lastPrintAt)) PrintParseStatus(state._label, "objdump", state._lineNumber, state._numSymbols);
+      state._lineNumber++;
+   }
+   state._numBytesRead += reader.GetNumBytesRead();
+}
+
+// Routine for parsing the output of Linux's objdump disassembler utility.  Returns B_ERROR if objdump failed (in which case (retTable) may be incomplete)
+static status_t ParseObjdumpOutput(const char * fileName, const char * label, const ParseSettings & settings, SymbolTable & retTable)
+{
+   const char * otoolPath = GetDisassemblerPath();
+
+   const FilePathInfo fpi(otoolPath);
+   if (fpi.Exists() == false)
+   {
+      String toolName = otoolPath;
+      toolName = toolName.Substring("/");  // only include the executable name itself
+      LogTime(MUSCLE_LOG_CRITICALERROR, "%s not found -- executable_diff needs to be able run %s in order to function.\n", otoolPath, toolName());
+      exit(10);
+   }
+
+   Queue<String> disassembleArgs;
+   (void) disassembleArgs.AddTail(otoolPath);
+   (void) disassembleArgs.AddTail("-d");
+   (void) disassembleArgs.AddTail("--no-show-raw-insn");
+
+   PhaseRecorder disassemblePhase(settings._optStats, "disassemble", label);
+
+   // If we're allowed to, split the disassembly across several concurrent objdump processes.
+   // Their outputs get parsed in address-order below, so the results are the same as for a single process.
+   // When the prefilter is in use, each process instead disassembles one range of the functions that might differ.
+   const DisassemblyTargets * targets = settings._optTargets;
+   Queue<ObjdumpShardThreadRef> shards;
+   {
+      Queue<uint64> starts, stops;  // 0 means "from the start" or "to the end", respectively
+      if (targets) GetDisassemblyRanges(*targets, settings._numDisassemblyJobs*MAX_DISASSEMBLY_RANGES_PER_JOB, starts, stops);
+      else
+      {
+         Queue<uint64> boundaries;
+         GetObjdumpShardBoundaries(fileName, settings._numDisassemblyJobs, boundaries);
+         for (uint32 i=0; ((boundaries.HasItems())&&(i<boundaries.GetNumItems()+1)); i++)
+         {
+            (void) starts.AddTail((i > 0) ? boundaries[i-1] : 0);
+            (void) stops.AddTail((i < boundaries.GetNumItems()) ? boundaries[i] : 0);
+         }
+      }
+
+      for (uint32 i=0; i<starts.GetNumItems(); i++)
+      {
+         char addrBuf[64];
+         Queue<String> args = disassembleArgs;
+         if (starts[i] > 0)
+         {
+            muscleSprintf(addrBuf, "--start-address=0x" XINT64_FORMAT_SPEC, starts[i]);
+            (void) args.AddTail(addrBuf);
+         }
+         if (stops[i] > 0)
+         {
+            muscleSprintf(addrBuf, "--stop-address=0x" XINT64_FORMAT_SPEC, stops[i]);
+            (void) args.AddTail(addrBuf);
+         }
+         (void) args.AddTail(GetFileNameArgument(fileName));
+
+         ObjdumpShardThreadRef shard(newnothrow ObjdumpShardThread(args, settings._spillDirectory));
+         if ((shard() == NULL)||(shards.AddTail(shard) != B_NO_ERROR))
+         {
+            WARN_OUT_OF_MEMORY;
+            exit(10);
+         }
+      }
+   }
+   const bool useSingleProcess = ((shards.IsEmpty())&&(targets == NULL));  // no sharding possible, so we'll just read from a single objdump process below
+   disassemblePhase.GetStats()._numSubprocesses = (useSingleProcess ? 1 : shards.GetNumItems());
+
+   _progressDisplay.LogMessage(MUSCLE_LOG_INFO, String("Opening executable file %1 [%2]%3...").Arg(label).Arg(fileName).Arg(shards.HasItems() ? String(" (using %1 objdump processes)").Arg(shards.GetNumItems()) : GetEmptyString()));
+   Hashtable<String, SymbolRecord> & symbols = retTable._symbols;
+   (void) symbols.EnsureSize(100000);  // try to avoid reallocations as they could be expensive
+
+   // For Linux, we'll also need the contents of the read-only data sections (e.g. .rodata),
+   // since objdump doesn't have the helpful literal-annotations that otool has.
+   // We memory-map the executable and read them directly out of the ELF file.
+   ElfFile elfFile;
+   ReadOnlyData roData;
+   {
+      PhaseRecorder roDataPhase(settings._optStats, "read-only data", label);
+      if (elfFile.Open(fileName) == B_NO_ERROR) elfFile.GetReadOnlyData(roData);
+                                           else _progressDisplay.LogMessage(MUSCLE_LOG_WARNING, String("Unable to read the ELF sections of [%1], string literals won't be expanded.").Arg(fileName));
+   }
+
+   StreamingSanitizer sanitizer(label, &roData, settings._numSanitizerThreads, settings._spillDirectory);  // sanitizes each symbol's text while we parse the rest
+
+   ObjdumpParseState state(label, targets, sanitizer, symbols);
+
+   status_t ret = B_NO_ERROR;
+   ChildProcess singleProcess;
+   uint32 numShardsStarted = 0;
+   for (uint32 shardIdx=0; shardIdx<(useSingleProcess ? 1 : shards.GetNumItems()); shardIdx++)
+   {
+      // Keep up to (_numDisassemblyJobs) objdump processes running at once
+      while((numShardsStarted < shards.GetNumItems())&&(numShardsStarted < shardIdx+settings._numDisassemblyJobs))
+      {
+         if (shards[numShardsStarted++]()->StartInternalThread() != B_NO_ERROR)
+         {
+            LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to start objdump thread for executable [%s]\n", fileName);
+            exit(10);
+         }
+      }
+
+      FILE * fpIn = NULL;
+      if (useSingleProcess)
+      {
+         (void) disassembleArgs.AddTail(GetFileNameArgument(fileName));
+         fpIn = singleProcess.Open(disassembleArgs);
+      }
+      else fpIn = shards[shardIdx]()->OpenOutput();
+
+      if (fpIn) ParseObjdumpStream(fpIn, (shardIdx == 0), state);
+      const int exitCode = useSingleProcess ? singleProcess.Close() : shards[shardIdx]()->GetExitCode();
+      if ((fpIn)&&(useSingleProcess == false)) fclose(fpIn);
+      if (exitCode != 0)
+      {
+         LogTime(MUSCLE_LOG_ERROR, "%s failed (exit code %i) while disassembling executable [%s]\n", otoolPath, exitCode, fileName);
+         ret = B_ERROR;
+      }
+   }
+   disassemblePhase.GetStats()._numBytesRead = state._numBytesRead;
+   disassemblePhase.GetStats()._numLines     = state._lineNumber-1;
+   disassemblePhase.GetStats()._numSymbols   = state._numSymbols;
+   disassemblePhase.Finish();
+
+   PhaseRecorder resolvePhase(settings._optStats, "resolve symbols", label);
+   if (state._curSymbolContents) sanitizer.EndSymbol();
+   sanitizer.Finish(symbols);
+
+   symbols.SortByValue(CompareStartAddressesFunctor());
+
+   // When the prefilter is in use, most functions didn't get disassembled, so the index comes from the symbol table instead
+   AddressIndex index;  // used for quick (O(logN)) address-lookups
+   if (targets == NULL) (void) index.SetSymbols(symbols);
+
+   // Now that we know where every symbol is, we can replace any absolute addresses with symbol-relative representations
+   sanitizer.ResolveSymbols(retTable, targets ? targets->_image->GetAddressIndex() : index, settings);
+
+   symbols.SortByKey();
+   resolvePhase.GetStats()._numSymbols = symbols.GetNumItems();
+   _progressDisplay.LogMessage(MUSCLE_LOG_INFO, String("Parsed %1 unique symbols from %2").Arg(symbols.GetNumItems()).Arg(fileName));
+   return ret;
+}
+#endif
+
+// The symbol-cache file format (all values are in native byte-order; a file written on a machine of
+// the other endianness will fail the magic-number check and simply be regenerated):
+//    SymbolCacheHeader
+//    SymbolCacheRecord[_numSymbols]   (in the symbol table's sorted order)
+//    SymbolCacheLine[_numLines]       (the distinct lines of all of the symbols' texts)
+//    each symbol's text, as an array of uint32 indices into the SymbolCacheLine array
+//    the symbols' names and the lines' texts, referenced by the records' offsets
+// Line IDs are only meaningful within one LineTable, which is why the file has its own line indices.
+enum {
+   SYMBOL_CACHE_MAGIC   = 'EdSc',
+   SYMBOL_CACHE_VERSION = 3, // increment this whenever the file format (or the sanitized text's format) changes
+   DEFAULT_SYMBOL_CACHE_MAX_MB = 2048  // how big the cache directory may get before its least recently used files are deleted, if --cache-max-mb isn't specified
+};
+
+struct SymbolCacheHeader
+{
+   uint32 _magic;
+   uint32 _version;
+   uint32 _numSymbols;
+   uint32 _numLines;
+   uint64 _executableHash;  // content-hash of the executable file the symbols were parsed from
+   uint64 _executableSize;
+   uint64 _disassemblerID;  // which version of the disassembler produced the text (see GetDisassemblerID())
+};
+
+struct SymbolCacheRecord
+{
+   uint64 _startAddress;
+   uint64 _length;
+   uint64 _nameOffset;       // from the start of the cache file
+   uint64 _lineIndexOffset;  // from the start of the cache file
+   uint32 _nameLength;
+   uint32 _numLines;
+};
+
+struct SymbolCacheLine
+{
+   uint64 _textOffset;  // from the start of the cache file
+   uint32 _textLength;
+   uint32 _reserved;
+};
+
+/** Calculates a 64-bit hash of the entire contents of (file) */
+static uint64 CalculateFileContentHash(const MemoryMappedFile & file)
+{
+   const uint32 chunkSize = 64*1024*1024;  // since CalculateHashCode64() can only handle 32-bit lengths
+
+   uint64 ret = file.GetNumBytes();
+   for (uint64 offset=0; offset<file.GetNumBytes(); offset+=chunkSize) ret = (ret*31) + CalculateHashCode64(file.GetData()+offset, (uint32) muscleMin(file.GetNumBytes()-offset, (uint64) chunkSize));
+   return ret;
+}
+
+/** Returns a hash of our disassembler's path, size and modification time.  A cache file written by a different version of the
+  * disassembler doesn't get used, since that version's output (and therefore the sanitized text) might be formatted differently.
+  */
+static uint64 GetDisassemblerID()
+{
+   const char * path = GetDisassemblerPath();
+   uint64 ret = CalculateHashCode64(path, (uint32) strlen(path));
+
+   struct stat st;
+   if (stat(path, &st) == 0) ret = (((ret*31)+(uint64)st.st_size)*31)+(uint64)st.st_mtime;
+   return ret;
+}
+
+/** Returns the path of the symbol-cache file for the given executable contents */
+static String GetSymbolCacheFilePath(const String & cacheDirectory, uint64 executableHash, uint64 executableSize)
+{
+   char buf[64];
+   muscleSprintf(buf, XINT64_FORMAT_SPEC "_" XINT64_FORMAT_SPEC ".symcache", executableHash, executableSize);
+   return cacheDirectory + "/" + buf;
+}
+
+/** Attempts to load (retTable) from the given symbol-cache file.  Returns B_NO_ERROR on success (and sets (retNumBytesRead) to the
+  * size of the cache file), or B_ERROR if the cache file doesn't exist or isn't valid (in which case (retTable) is left empty).
+  */
+static status_t LoadSymbolCacheFile(const String & cacheFilePath, uint64 executableHash, uint64 executableSize, SymbolTable & retTable, uint64 & retNumBytesRead)
+{
+   MemoryMappedFile cacheFile;
+   if ((cacheFile.Map(cacheFilePath()) != B_NO_ERROR)||(cacheFile.GetNumBytes() < sizeof(SymbolCacheHeader))) return B_ERROR;
+
+   const uint8 * data   = cacheFile.GetData();
+   const uint64 numBytes = cacheFile.GetNumBytes();
+   const SymbolCacheHeader * header = (const SymbolCacheHeader *) data;
+   if ((header->_magic != SYMBOL_CACHE_MAGIC)||(header->_version != SYMBOL_CACHE_VERSION)||(header->_executableHash != executableHash)||(header->_executableSize != executableSize)||(header->_disassemblerID != GetDisassemblerID())) return B_ERROR;
+   if (((uint64)header->_numSymbols*sizeof(SymbolCacheRecord))+((uint64)header->_numLines*sizeof(SymbolCacheLine)) > (numBytes-sizeof(SymbolCacheHeader))) return B_ERROR;
+
+   // Look up (or add) each of the file's lines in the LineTable, to find out which line ID each of its line indices stands for
+   const SymbolCacheRecord * records = (const SymbolCacheRecord *) (data+sizeof(SymbolCacheHeader));
+   const SymbolCacheLine * lines     = (const SymbolCacheLine *) (records+header->_numSymbols);
+   Queue<uint32> lineIDs;
+   if (lineIDs.EnsureSize(header->_numLines) != B_NO_ERROR) return B_ERROR;
+   for (uint32 i=0; i<header->_numLines; i++)
+   {
+      const SymbolCacheLine & line = lines[i];
+      if ((line._textOffset > numBytes)||(line._textLength > (numBytes-line._textOffset))) return B_ERROR;
+      (void) lineIDs.AddTail(retTable._lineTable()->GetLineID((const char *) (data+line._textOffset), line._textLength));
+   }
+
+   TextArenaRef arena(newnothrow TextArena);
+   if ((arena() == NULL)||(retTable._textArenas.AddTail(arena) != B_NO_ERROR)) {WARN_OUT_OF_MEMORY; return B_ERROR;}
+
+   Hashtable<String, SymbolRecord> & symbols = retTable._symbols;
+   symbols.Clear();
+   if (symbols.EnsureSize(header->_numSymbols) == B_NO_ERROR)
+   {
+      bool ok = true;
+      for (uint32 i=0; ((ok)&&(i<header->_numSymbols)); i++)
+      {
+         const SymbolCacheRecord & r = records[i];
+         if ((r._nameOffset > numBytes)||(r._nameLength > (numBytes-r._nameOffset))||(r._lineIndexOffset > numBytes)||(((uint64)r._numLines*sizeof(uint32)) > (numBytes-r._lineIndexOffset))) {ok = false; break;}
+
+         const uint32 * lineIndices = (const uint32 *) (data+r._lineIndexOffset);
+         arena()->BeginSpan();
+         for (uint32 j=0; ((ok)&&(j<r._numLines)); j++) ok = (lineIndices[j] < header->_numLines)&&(AppendLineID(lineIDs[lineIndices[j]], *arena()) == B_NO_ERROR);
+
+         SymbolRecord rec;
+         rec._startAddress = r._startAddress;
+         rec._length       = r._length;
+         rec._lines        = LineIDSpan(arena()->EndSpan());
+         rec.UpdateLinesHash();
+         if ((ok)&&(symbols.Put(String((const char *) (data+r._nameOffset), r._nameLength), rec) != B_NO_ERROR)) ok = false;
+      }
+      if (ok)
+      {
+         retNumBytesRead = numBytes;
+         return B_NO_ERROR;
+      }
+   }
+
+   symbols.Clear();
+   retTable._textArenas.Clear();
+   return B_ERROR;
+}
+
+/** Writes (table) out to the given symbol-cache file.  Returns B_NO_ERROR on success. */
+static status_t SaveSymbolCacheFile(const String & cacheFilePath, uint64 executableHash, uint64 executableSize, const SymbolTable & table)
+{
+   const Hashtable<String, SymbolRecord> & symbols = table._symbols;
+
+   // Give each distinct line that the symbols use an index within the file, in order of first use
+   Hashtable<uint32, uint32> lineIndices;  // line ID -> index within the file
+   Queue<uint32> lineIDs;                  // index within the file -> line ID
+   for (HashtableIterator<String, SymbolRecord> iter(symbols); iter.HasData(); iter++)
+   {
+      const LineIDSpan & recLines = iter.GetValue()._lines;
+      for (uint32 i=0; i<recLines._numLines; i++)
+      {
+         const uint32 lineID = recLines._ids[i];
+         if ((lineIndices.ContainsKey(lineID) == false)&&((lineIndices.Put(lineID, lineIDs.GetNumItems()) != B_NO_ERROR)||(lineIDs.AddTail(lineID) != B_NO_ERROR))) {WARN_OUT_OF_MEMORY; return B_ERROR;}
+      }
+   }
+
+   // Write to a uniquely-named temporary file first and then rename it into place, so that a concurrent (or interrupted) run never
+   // sees a partial file, and two threads (or processes) that are saving the same executable's symbols never write to the same file
+   char tempFilePath[2048];
+   muscleSnprintf(tempFilePath, sizeof(tempFilePath), "%s.tmpXXXXXX", cacheFilePath());
+   const int fd = mkstemp(tempFilePath);
+   if (fd < 0) return B_ERROR;
+
+   FILE * fpOut = fdopen(fd, "wb");
+   if (fpOut == NULL)
+   {
+      close(fd);
+      (void) unlink(tempFilePath);
+      return B_ERROR;
+   }
+
+   SymbolCacheHeader header;
+   memset(&header, 0, sizeof(header));
+   header._magic          = SYMBOL_CACHE_MAGIC;
+   header._version        = SYMBOL_CACHE_VERSION;
+   header._numSymbols     = symbols.GetNumItems();
+   header._numLines       = lineIDs.GetNumItems();
+   header._executableHash = executableHash;
+   header._executableSize = executableSize;
+   header._disassemblerID = GetDisassemblerID();
+   bool ok = (fwrite(&header, sizeof(header), 1, fpOut) == 1);
+
+   uint64 nextLineIndexOffset = sizeof(SymbolCacheHeader)+(symbols.GetNumItems()*sizeof(SymbolCacheRecord))+(lineIDs.GetNumItems()*sizeof(SymbolCacheLine));
+   uint64 nextTextOffset      = nextLineIndexOffset;
+   for (HashtableIterator<String, SymbolRecord> iter(symbols); iter.HasData(); iter++) nextTextOffset += iter.GetValue()._lines._numLines*sizeof(uint32);
+
+   for (HashtableIterator<String, SymbolRecord> iter(symbols); ((ok)&&(iter.HasData())); iter++)
+   {
+      const String & name      = iter.GetKey();
+      const SymbolRecord & rec = iter.GetValue();
+
+      SymbolCacheRecord r;
+      memset(&r, 0, sizeof(r));
+      r._startAddress    = rec._startAddress;
+      r._length          = rec._length;
+      r._nameOffset      = nextTextOffset;      nextTextOffset      += name.Length();
+      r._lineIndexOffset = nextLineIndexOffset; nextLineIndexOffset += rec._lines._numLines*sizeof(uint32);
+      r._nameLength      = name.Length();
+      r._numLines        = rec._lines._numLines;
+      ok = (fwrite(&r, sizeof(r), 1, fpOut) == 1);
+   }
+
+   for (uint32 i=0; ((ok)&&(i<lineIDs.GetNumItems())); i++)
+   {
+      const TextSpan text = table._lineTable()->GetLine(lineIDs[i]);
+
+      SymbolCacheLine line;
+      memset(&line, 0, sizeof(line));
+      line._textOffset = nextTextOffset; nextTextOffset += text._length;
+      line._textLength = text._length;
+      ok = (fwrite(&line, sizeof(line), 1, fpOut) == 1);
+   }
+
+   for (HashtableIterator<String, SymbolRecord> iter(symbols); ((ok)&&(iter.HasData())); iter++)
+   {
+      const LineIDSpan & recLines = iter.GetValue()._lines;
+      for (uint32 i=0; ((ok)&&(i<recLines._numLines)); i++)
+      {
+         const uint32 lineIndex = *lineIndices.Get(recLines._ids[i]);
+         ok = (fwrite(&lineIndex, sizeof(lineIndex), 1, fpOut) == 1);
+      }
+   }
+
+   for (HashtableIterator<String, SymbolRecord> iter(symbols); ((ok)&&(iter.HasData())); iter++) ok = (fwrite(iter.GetKey()(), 1, iter.GetKey().Length(), fpOut) == iter.GetKey().Length());
+   for (uint32 i=0; ((ok)&&(i<lineIDs.GetNumItems())); i++)
+   {
+      const TextSpan text = table._lineTable()->GetLine(lineIDs[i]);
+      ok = (fwrite(text._chars, 1, text._length, fpOut) == text._length);
+   }
+
+   if (fclose(fpOut) != 0) ok = false;
+   if ((ok)&&(rename(tempFilePath, cacheFilePath()) == 0)) return B_NO_ERROR;
+
+   (void) unlink(tempFilePath);
+   return B_ERROR;
+}
+
+/** Information about one file in the symbol-cache directory (see PruneSymbolCacheDirectory()) */
+class SymbolCacheFileInfo
+{
+public:
+   SymbolCacheFileInfo() : _numBytes(0), _modTime(0) {/* empty */}
+   SymbolCacheFileInfo(const String & path, uint64 numBytes, uint64 modTime) : _path(path), _numBytes(numBytes), _modTime(modTime) {/* empty */}
+
+   String _path;
+   uint64 _numBytes;
+   uint64 _modTime;  // a cache file's modification time gets updated whenever it is loaded, so this is when it was last used
+};
+
+class CompareSymbolCacheFileAgesFunctor
+{
+public:
+   CompareSymbolCacheFileAgesFunctor() {/* empty */}
+
+   int Compare(const SymbolCacheFileInfo & f1, const SymbolCacheFileInfo & f2, void * /*cookie*/) const {return muscleCompare(f1._modTime, f2._modTime);}  // least recently used first
+};
+
+/** Deletes the least recently used cache files in (cacheDirectory) until the ones that remain add up to no more than (maxBytes).
+  * (keepPath), the cache file that was just written, is never deleted.
+  */
+static void PruneSymbolCacheDirectory(const String & cacheDirectory, uint64 maxBytes, const String & keepPath)
+{
+   static Mutex pruneMutex;  // so that concurrent parses (e.g. of a directory tree) don't all prune at once
+   MutexGuard mg(pruneMutex);
+
+   Queue<SymbolCacheFileInfo> files;
+   uint64 totalBytes = 0;
+   Directory dir(cacheDirectory());
+   for (const char * fileName; (fileName = dir.GetCurrentFileName()) != NULL; dir++)
+   {
+      const String path = cacheDirectory + "/" + fileName;
+      struct stat st;
+      if ((path.EndsWith(".symcache"))&&(path != keepPath)&&(stat(path(), &st) == 0)&&(S_ISREG(st.st_mode)))
+      {
+         if (files.AddTail(SymbolCacheFileInfo(path, st.st_size, st.st_mtime)) != B_NO_ERROR) {WARN_OUT_OF_MEMORY; return;}
+         totalBytes += st.st_size;
+      }
+   }
+
+   struct stat st;
+   if (stat(keepPath(), &st) == 0) totalBytes += st.st_size;
+
+   files.Sort(CompareSymbolCacheFileAgesFunctor());
+   for (uint32 i=0; ((totalBytes > maxBytes)&&(i<files.GetNumItems())); i++)
+   {
+      if (unlink(files[i]._path()) == 0) totalBytes -= files[i]._numBytes;
+   }
+}
+
+/** Parses (fileName)'s symbols into (retTable), loading them from the symbol cache if possible.
+  * Returns B_ERROR if the disassembler failed, in which case (retTable) may be incomplete and doesn't get cached.
+  */
+static status_t ParseExecutableFile(const char * fileName, const char * label, const ParseSettings & settings, SymbolTable & retTable)
+{
+   retTable._lineTable = settings._lineTable() ? settings._lineTable : LineTableRef(newnothrow LineTable);
+   if (retTable._lineTable() == NULL)
+   {
+      WARN_OUT_OF_MEMORY;
+      exit(10);
+   }
+
+   // If we've parsed this exact executable before, we can just load the results from our cache
+   // (a prefiltered parse only contains the functions that might differ from the other executable's, so it doesn't get cached)
+   String cacheFilePath;
+   uint64 executableHash = 0, executableSize = 0;
+   if ((settings._cacheDirectory.HasChars())&&(settings._optTargets == NULL))
+   {
+      PhaseRecorder cachePhase(settings._optStats, "load cache", label);
+      MemoryMappedFile executableFile;
+      if (executableFile.Map(fileName) == B_NO_ERROR)
+      {
+         executableHash = CalculateFileContentHash(executableFile);
+         executableSize = executableFile.GetNumBytes();
+         cacheFilePath  = GetSymbolCacheFilePath(settings._cacheDirectory, executableHash, executableSize);
+         cachePhase.GetStats()._numBytesRead = executableSize;
+         uint64 cacheFileSize = 0;
+         if (LoadSymbolCacheFile(cacheFilePath, executableHash, executableSize, retTable, cacheFileSize) == B_NO_ERROR)
+         {
+            cachePhase.GetStats()._numBytesRead += cacheFileSize;
+            cachePhase.GetStats()._numSymbols    = retTable._symbols.GetNumItems();
+            _progressDisplay.LogMessage(MUSCLE_LOG_INFO, String("Loaded %1 unique symbols for executable file %2 [%3] from cache file [%4]").Arg(retTable._symbols.GetNumItems()).Arg(label).Arg(fileName).Arg(cacheFilePath));
+            (void) utime(cacheFilePath(), NULL);  // mark it as recently used, so that PruneSymbolCacheDirectory() keeps it
+            return B_NO_ERROR;
+         }
+      }
+   }
+
+#ifdef __APPLE__
+   const status_t ret = ParseOtoolOutput(fileName, label, settings, retTable);
+#else
+   const status_t ret = ParseObjdumpOutput(fileName, label, settings, retTable);
+#endif
+
+   // A failed or empty parse isn't worth remembering (the next run should try again)
+   if ((ret == B_NO_ERROR)&&(retTable._symbols.HasItems())&&(cacheFilePath.HasChars()))
+   {
+      PhaseRecorder cachePhase(settings._optStats, "save cache", label);
+      cachePhase.GetStats()._numSymbols = retTable._symbols.GetNumItems();
+      if (SaveSymbolCacheFile(cacheFilePath, executableHash, executableSize, retTable) != B_NO_ERROR) _progressDisplay.LogMessage(MUSCLE_LOG_WARNING, String("Unable to write symbol cache file [%1]").Arg(cacheFilePath));
+      else if (settings._cacheMaxBytes > 0) PruneSymbolCacheDirectory(settings._cacheDirectory, settings._cacheMaxBytes, cacheFilePath);
+   }
+   return ret;
+}
+
+/** Parses an executable file in a separate thread, so that both executables can be parsed concurrently */
+class ParseExecutableThread : public Thread
+{
+public:
+   ParseExecutableThread(const char * fileName, const char * label, const ParseSettings & settings) : _fileName(fileName), _label(label), _settings(settings), _status(B_NO_ERROR) {/* empty */}
+
+   /** Parses our executable file, either in our internal thread or (if the thread couldn't be started) synchronously */
+   void Start()
+   {
+      if (StartInternalThread() != B_NO_ERROR)
+      {
+         LogTime(MUSCLE_LOG_WARNING, "Unable to start parsing thread for [%s], parsing it synchronously instead.\n", _fileName);
+         InternalThreadEntry();
+      }
+   }
+
+   /** Blocks until the parse is complete, then returns the parsed symbols table */
+   SymbolTable & GetResults()
+   {
+      (void) WaitForInternalThreadToExit();
+      return _table;
+   }
+
+   /** Blocks until the parse is complete, then returns B_NO_ERROR if it succeeded, or B_ERROR if the disassembler failed */
+   status_t GetStatus()
+   {
+      (void) WaitForInternalThreadToExit();
+      return _status;
+   }
+
+protected:
+   virtual void InternalThreadEntry() {_status = ParseExecutableFile(_fileName, _label, _settings, _table);}
+
+private:
+   const char * _fileName;
+   const char * _label;
+   const ParseSettings _settings;
+   SymbolTable _table;
+   status_t _status;
+};
+
+static uint32 RemoveMatchingSymbolsAux(Hashtable<String, SymbolRecord> & tableA, Hashtable<String, SymbolRecord> & tableB)
+{
+   uint32 ret = 0;
+   for (HashtableIterator<String, SymbolRecord> iter(tableA); iter.HasData(); iter++)
+   {
+      const String & symbolName = iter.GetKey();
+      const SymbolRecord & valA = iter.GetValue();
+      const SymbolRecord * valB = tableB.Get(symbolName);
+      if ((valB)&&(valB->HasSameTextAs(valA)))
+      {
+         (void) tableB.Remove(symbolName);
+         (void) tableA.Remove(symbolName);  // gotta do this last, as it invalidates (symbolName)
+         ret++;
+      }
+   }
+   return ret;
+}
+
+/** Like RemoveMatchingSymbolsAux(), except that (tableA) and (tableB) are left untouched, so that they can be compared again later
+  * (see --server).  Instead, the symbols that don't match get copied into (retTableA) and (retTableB), in table order.
+  * Returns the number of symbols that matched.
+  */
+static uint32 CopyNonMatchingSymbols(const Hashtable<String, SymbolRecord> & tableA, const Hashtable<String, SymbolRecord> & tableB, Hashtable<String, SymbolRecord> & retTableA, Hashtable<String, SymbolRecord> & retTableB)
+{
+   uint32 ret = 0;
+   for (HashtableIterator<String, SymbolRecord> iter(tableA); iter.HasData(); iter++)
+   {
+      const SymbolRecord * valB = tableB.Get(iter.GetKey());
+      if ((valB)&&(valB->HasSameTextAs(iter.GetValue()))) ret++;
+      else if (retTableA.Put(iter.GetKey(), iter.GetValue()) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+   }
+   for (HashtableIterator<String, SymbolRecord> iter(tableB); iter.HasData(); iter++)
+   {
+      const SymbolRecord * valA = tableA.Get(iter.GetKey());
+      if (((valA == NULL)||(valA->HasSameTextAs(iter.GetValue()) == false))&&(retTableB.Put(iter.GetKey(), iter.GetValue()) != B_NO_ERROR)) WARN_OUT_OF_MEMORY;
+   }
+   return ret;
+}
+
+enum {
+   MINHASH_NUM_BANDS        = 16,  // LSH:  two symbols become candidates if any band of their signatures matches...
+   MINHASH_ROWS_PER_BAND    = 3,   // ...in all of its rows.  More rows per band means fewer (but more similar) candidates.
+   MINHASH_SIGNATURE_SIZE   = MINHASH_NUM_BANDS*MINHASH_ROWS_PER_BAND,
+   MINHASH_SHINGLE_LINES    = 3,   // each shingle (i.e. set-element) is a run of this many consecutive instructions
+   MINHASH_MIN_LINES        = 4,   // symbols shorter than this are too generic (e.g. stubs) to be matched by similarity
+   MINHASH_MAX_BUCKET_SIZE  = 64,  // a band shared by more symbols than this is too common to tell us anything
+   MIN_RENAME_SIMILARITY    = 50   // percentage of matching signature-values needed before two symbols are considered a rename
+};
+
+/** The finalizer of splitmix64:  scrambles the bits of (x), so that similar inputs give unrelated outputs */
+static inline uint64 MixBits64(uint64 x)
+{
+   x ^= (x >> 30); x *= 0xbf58476d1ce4e5b9ULL;
+   x ^= (x >> 27); x *= 0x94d049bb133111ebULL;
+   return x ^ (x >> 31);
+}
+
+/** A symbol that is present in only one executable, paired with a similar symbol that is present only in the other one */
+class RenamedSymbol
+{
+public:
+   RenamedSymbol() : _similarity(0) {/* empty */}
+   RenamedSymbol(const String & nameA, const String & nameB, uint32 similarity) : _nameA(nameA), _nameB(nameB), _similarity(similarity) {/* empty */}
+
+   String _nameA;
+   String _nameB;
+   uint32 _similarity;  // estimated percentage of instruction n-grams the two symbols have in common
+};
+
+/** The MinHash signature of one symbol's text (see ComputeMinHashSignature()) */
+class MinHashSignature
+{
+public:
+   MinHashSignature() {/* empty */}
+
+   /** Returns the number of values that this signature has in common with (rhs) */
+   uint32 GetNumMatches(const MinHashSignature & rhs) const
+   {
+      uint32 ret = 0;
+      for (uint32 i=0; i<MINHASH_SIGNATURE_SIZE; i++) if (_values[i] == rhs._values[i]) ret++;
+      return ret;
+   }
+
+   /** Returns the LSH-bucket key for band number (bandIdx) of this signature */
+   uint64 GetBandKey(uint32 bandIdx) const
+   {
+      uint64 key = bandIdx;
+      for (uint32 i=0; i<MINHASH_ROWS_PER_BAND; i++) key = MixBits64(key ^ _values[(bandIdx*MINHASH_ROWS_PER_BAND)+i]);
+      return key;
+   }
+
+   uint32 _values[MINHASH_SIGNATURE_SIZE];
+};
+
+/** One of the LSH-buckets that an unmatched symbol was put into by FindRenamedSymbols() */
+class BandEntry
+{
+public:
+   BandEntry() : _key(0), _idxA(0) {/* empty */}
+   BandEntry(uint64 key, uint32 idxA) : _key(key), _idxA(idxA) {/* empty */}
+
+   uint64 _key;   // the bucket's key (see MinHashSignature::GetBandKey())
+   uint32 _idxA;  // index of the symbol that is in the bucket
+};
+
+class CompareBandEntriesFunctor
+{
+public:
+   CompareBandEntriesFunctor() {/* empty */}
+
+   int Compare(const BandEntry & e1, const BandEntry & e2, void *) const {return muscleCompare(e1._key, e2._key);}
+};
+
+/** A pair of unmatched symbols (as indices into FindRenamedSymbols()'s lists) whose signatures had (_numMatches) values in common */
+class RenameCandidate
+{
+public:
+   RenameCandidate() : _idxA(0), _idxB(0), _numMatches(0) {/* empty */}
+   RenameCandidate(uint32 idxA, uint32 idxB, uint32 numMatches) : _idxA(idxA), _idxB(idxB), _numMatches(numMatches) {/* empty */}
+
+   uint32 _idxA;
+   uint32 _idxB;
+   uint32 _numMatches;
+};
+
+class CompareRenameCandidatesFunctor
+{
+public:
+   CompareRenameCandidatesFunctor() {/* empty */}
+
+   int Compare(const RenameCandidate & c1, const RenameCandidate & c2, void *) const {return muscleCompare(c2._numMatches, c1._numMatches);}  // most similar first
+};
+
+/** Returns (symbolName) without the "#N" suffix that GetUniqueSymbolName() added to it, i.e. the name as it appears in disassembly text */
+static String GetBaseSymbolName(const String & symbolName)
+{
+   const int32 hashIdx = symbolName.LastIndexOf('#');
+   return (hashIdx > 0) ? symbolName.Substring(0, hashIdx) : symbolName;
+}
+
+/** Returns true iff (c) can be part of a symbol name, as objdump and otool print them (e.g. "_ZN3foo3barEv", "foo.cold" or "foo@plt") */
+static inline bool IsSymbolNameChar(char c) {return ((isalnum((unsigned char)c))||(c == '_')||(c == '$')||(c == '.')||(c == '@'));}
+
+/** Returns a hash of the (lineLength) chars at (line), ignoring any occurrences of (name) in it.  That way a symbol's
+  * references to itself (e.g. "jne foo#0+0x6c <foo>") hash the same no matter what the symbol is called.  Only whole
+  * names count, so e.g. for a symbol named "add", neither the "add" in "addq" nor the one in "add_helper" is ignored.
+  */
+static uint64 CalculateLineHashWithoutName(const char * line, uint32 lineLength, const String & name)
+{
+   const char * p   = line;
+   const char * end = line+lineLength;
+   uint64 ret = 0;
+   if (name.HasChars())
+   {
+      for (const char * q=p; (q=(const char *)memchr(q, name[0], end-q)) != NULL; q++)
+      {
+         if ((((uint32)(end-q)) >= name.Length())&&(memcmp(q, name(), name.Length()) == 0)&&((q == line)||(IsSymbolNameChar(q[-1]) == false))&&((q+name.Length() == end)||(IsSymbolNameChar(q[name.Length()]) == false)))
+         {
+            ret = MixBits64(ret ^ CalculateHashCode64(p, (uint32)(q-p)));
+            p = q+name.Length();
+            q = p-1;
+         }
+      }
+   }
+   return MixBits64(ret ^ CalculateHashCode64(p, (uint32)(end-p)));
+}
+
+/** Computes the MinHash signature of (lines) (the text of the symbol named (name), as IDs in (lineTable)), treating it as the set of all runs of
+  * MINHASH_SHINGLE_LINES consecutive lines, and writes it into (retSignature).  The fraction of values that two symbols' signatures have in common estimates the Jaccard similarity of their sets.
+  * Returns false (and writes nothing) if (lines) is too short to be worth matching.
+  */
+static bool ComputeMinHashSignature(const String & name, const LineIDSpan & lines, const LineTable & lineTable, MinHashSignature & retSignature)
+{
+   const String baseName = GetBaseSymbolName(name);
+
+   uint32 mins[MINHASH_SIGNATURE_SIZE];
+   for (uint32 i=0; i<MINHASH_SIGNATURE_SIZE; i++) mins[i] = MUSCLE_NO_LIMIT;
+
+   uint64 lineHashes[MINHASH_SHINGLE_LINES];
+   uint32 numLines = 0;
+   for (uint32 lineIdx=0; lineIdx<lines._numLines; lineIdx++)
+   {
+      const TextSpan line = lineTable.GetLine(lines._ids[lineIdx]);
+      lineHashes[numLines%MINHASH_SHINGLE_LINES] = CalculateLineHashWithoutName(line._chars, line._length, baseName);
+      if (++numLines >= MINHASH_SHINGLE_LINES)
+      {
+         uint64 shingle = 0;
+         for (uint32 i=MINHASH_SHINGLE_LINES; i>0; i--) shingle = MixBits64(shingle ^ lineHashes[(numLines-i)%MINHASH_SHINGLE_LINES]);
+         for (uint32 i=0; i<MINHASH_SIGNATURE_SIZE; i++)
+         {
+            const uint32 h = (uint32) MixBits64(shingle + ((i+1)*0x9e3779b97f4a7c15ULL));  // one hash function per signature value
+            if (h < mins[i]) mins[i] = h;
+         }
+      }
+   }
+   if (numLines < MINHASH_MIN_LINES) return false;
+
+   memcpy(retSignature._values, mins, sizeof(mins));
+   return true;
+}
+
+/** Computes the signature of each symbol in (table) that isn't in (otherTable), appending its name to (retNames) and its signature to (retSignatures) */
+static void ComputeUnmatchedSignatures(const Hashtable<String, SymbolRecord> & table, const Hashtable<String, SymbolRecord> & otherTable, const LineTable & lineTable, Queue<const String *> & retNames, Queue<MinHashSignature> & retSignatures)
+{
+   MinHashSignature signature;
+   for (HashtableIterator<String, SymbolRecord> iter(table); iter.HasData(); iter++)
+   {
+      if ((otherTable.ContainsKey(iter.GetKey()) == false)&&(ComputeMinHashSignature(iter.GetKey(), iter.GetValue()._lines, lineTable, signature)))
+      {
+         if ((retNames.AddTail(&iter.GetKey()) != B_NO_ERROR)||(retSignatures.AddTail(signature) != B_NO_ERROR)) {WARN_OUT_OF_MEMORY; return;}
+      }
+   }
+}
+
+/** Finds the symbols that are present only in (tableA) and have a similar counterpart that is present only in (tableB)
+  * (e.g. functions that were renamed, or lambdas whose mangled names changed), and adds each such pair to (retRenames),
+  * most similar first.  Each symbol is paired at most once.  Candidate pairs are found via locality-sensitive hashing of
+  * the symbols' MinHash signatures, so the symbols don't all have to be compared against each other.  (lineTable) is the
+  * dictionary that both tables' line IDs refer to.
+  */
+static void FindRenamedSymbols(const Hashtable<String, SymbolRecord> & tableA, const Hashtable<String, SymbolRecord> & tableB, const LineTable & lineTable, Queue<RenamedSymbol> & retRenames)
+{
+   Queue<const String *> namesA, namesB;
+   Queue<MinHashSignature> signaturesA, signaturesB;  // one per name
+   ComputeUnmatchedSignatures(tableA, tableB, lineTable, namesA, signaturesA);
+   ComputeUnmatchedSignatures(tableB, tableA, lineTable, namesB, signaturesB);
+   if ((namesA.GetNumItems() != signaturesA.GetNumItems())||(namesB.GetNumItems() != signaturesB.GetNumItems())) return;  // out of memory
+   if ((namesA.IsEmpty())||(namesB.IsEmpty())) return;
+
+   // Put each of A's symbols into one bucket per band of its signature.  The buckets are kept as a single
+   // array sorted by key (rather than as one Queue per bucket), since there can be millions of them.
+   Queue<BandEntry> buckets;
+   if (buckets.EnsureSize(namesA.GetNumItems()*MINHASH_NUM_BANDS) != B_NO_ERROR) {WARN_OUT_OF_MEMORY; return;}
+   for (uint32 a=0; a<namesA.GetNumItems(); a++) for (uint32 band=0; band<MINHASH_NUM_BANDS; band++) (void) buckets.AddTail(BandEntry(signaturesA[a].GetBandKey(band), a));
+   buckets.Sort(CompareBandEntriesFunctor());
+
+   // Each of B's symbols only needs to be compared against the A-symbols that share at least one bucket with it
+   Queue<RenameCandidate> candidates;
+   Queue<uint32> lastCheckedBy;  // for each of A's symbols, (1+the index of the B-symbol) that was last compared against it
+   if (lastCheckedBy.EnsureSize(namesA.GetNumItems(), true) != B_NO_ERROR) {WARN_OUT_OF_MEMORY; return;}
+   for (uint32 b=0; b<namesB.GetNumItems(); b++)
+   {
+      const MinHashSignature & sigB = signaturesB[b];
+      for (uint32 band=0; band<MINHASH_NUM_BANDS; band++)
+      {
+         // Binary-search for the start of this band's bucket
+         const uint64 key = sigB.GetBandKey(band);
+         uint32 lo = 0, hi = buckets.GetNumItems();
+         while(lo < hi)
+         {
+            const uint32 mid = (lo+hi)/2;
+            if (buckets[mid]._key < key) lo = mid+1;
+                                    else hi = mid;
+         }
+
+         uint32 bucketEnd = lo;
+         while((bucketEnd < buckets.GetNumItems())&&(buckets[bucketEnd]._key == key)) bucketEnd++;
+         if ((bucketEnd-lo) > MINHASH_MAX_BUCKET_SIZE) continue;
+
+         for (uint32 i=lo; i<bucketEnd; i++)
+         {
+            const uint32 a = buckets[i]._idxA;
+            if (lastCheckedBy[a] == b+1) continue;
+            lastCheckedBy[a] = b+1;
+
+            const uint32 numMatches = signaturesA[a].GetNumMatches(sigB);
+            if (((numMatches*100) >= (MIN_RENAME_SIMILARITY*MINHASH_SIGNATURE_SIZE))&&(candidates.AddTail(RenameCandidate(a, b, numMatches)) != B_NO_ERROR)) WARN_OUT_OF_MEMORY;
+         }
+      }
+   }
+
+   // Greedily pair up the most similar candidates first (the sort is stable, so ties are resolved in parse-order)
+   candidates.Sort(CompareRenameCandidatesFunctor());
+   Queue<bool> pairedA, pairedB;
+   if ((pairedA.EnsureSize(namesA.GetNumItems(), true) != B_NO_ERROR)||(pairedB.EnsureSize(namesB.GetNumItems(), true) != B_NO_ERROR)) {WARN_OUT_OF_MEMORY; return;}
+   for (uint32 i=0; i<candidates.GetNumItems(); i++)
+   {
+      const RenameCandidate & c = candidates[i];
+      if ((pairedA[c._idxA] == false)&&(pairedB[c._idxB] == false))
+      {
+         pairedA[c._idxA] = pairedB[c._idxB] = true;
+         if (retRenames.AddTail(RenamedSymbol(*namesA[c._idxA], *namesB[c._idxB], (c._numMatches*100)/MINHASH_SIGNATURE_SIZE)) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+      }
+   }
+}
+
+/** Returns true iff (linesA) and (linesB) are the same, except for any references that the symbols make to their own names */
+static bool HasSameTextExceptNames(const String & nameA, const LineIDSpan & linesA, const String & nameB, const LineIDSpan & linesB, const LineTable & lineTable)
+{
+   if (linesA._numLines != linesB._numLines) return false;
+
+   const String baseNameA = GetBaseSymbolName(nameA);
+   const String baseNameB = GetBaseSymbolName(nameB);
+   for (uint32 i=0; i<linesA._numLines; i++)
+   {
+      const TextSpan lineA = lineTable.GetLine(linesA._ids[i]);
+      const TextSpan lineB = lineTable.GetLine(linesB._ids[i]);
+      if (CalculateLineHashWithoutName(lineA._chars, lineA._length, baseNameA) != CalculateLineHashWithoutName(lineB._chars, lineB._length, baseNameB)) return false;
+   }
+   return true;
+}
+
+enum {
+   REPORT_ENTRY_DIFFERS = 0,  // the symbol is present in both executables, but its text differs
+   REPORT_ENTRY_RENAMED,      // the symbol is present only in A, and a similar symbol (see FindRenamedSymbols()) is present only in B
+   REPORT_ENTRY_ONLY_IN_A,    // the symbol is present in A but not in B
+   REPORT_ENTRY_ONLY_IN_B     // the symbol is present in B but not in A
+};
+
+/** One item of a diffs report, as found by CollectReportEntries() */
+class ReportEntry
+{
+public:
+   ReportEntry() : _type(REPORT_ENTRY_DIFFERS), _recA(NULL), _recB(NULL), _similarity(0) {/* empty */}
+   ReportEntry(uint32 type, const String & nameA, const SymbolRecord * recA, const String & nameB, const SymbolRecord * recB, uint32 similarity = 0) : _type(type), _nameA(nameA), _recA(recA), _nameB(nameB), _recB(recB), _similarity(similarity) {/* empty */}
+
+   uint32 _type;                // REPORT_ENTRY_*
+   String _nameA;               // the symbol's name in A (empty for REPORT_ENTRY_ONLY_IN_B)
+   const SymbolRecord * _recA;  // the symbol's record in A (NULL for REPORT_ENTRY_ONLY_IN_B)
+   String _nameB;               // the symbol's name in B (empty for REPORT_ENTRY_ONLY_IN_A)
+   const SymbolRecord * _recB;  // the symbol's record in B (NULL for REPORT_ENTRY_ONLY_IN_A)
+   uint32 _similarity;          // for REPORT_ENTRY_RENAMED, the estimated percentage of instructions the two symbols have in common
+};
+
+static void CollectDifferingSymbolsAux(const Hashtable<String, SymbolRecord> & tableA, const Hashtable<String, SymbolRecord> & tableB, bool isTableA, Hashtable<String, Void> & reported, Queue<ReportEntry> & retEntries)
+{
+   for (HashtableIterator<String, SymbolRecord> iter(tableA); iter.HasData(); iter++)
+   {
+      const String & symbolName = iter.GetKey();
+      if (reported.ContainsKey(symbolName) == false)
+      {
+         (void) reported.PutWithDefault(symbolName);
+
+         const SymbolRecord & valA = iter.GetValue();
+         const SymbolRecord * valB = tableB.Get(symbolName);
+         status_t ret;
+         if (valB) ret = isTableA ? retEntries.AddTail(ReportEntry(REPORT_ENTRY_DIFFERS, symbolName, &valA, symbolName, valB)) : retEntries.AddTail(ReportEntry(REPORT_ENTRY_DIFFERS, symbolName, valB, symbolName, &valA));
+              else ret = isTableA ? retEntries.AddTail(ReportEntry(REPORT_ENTRY_ONLY_IN_A, symbolName, &valA, GetEmptyString(), NULL)) : retEntries.AddTail(ReportEntry(REPORT_ENTRY_ONLY_IN_B, GetEmptyString(), NULL, symbolName, &valA));
+         if (ret != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+      }
+   }
+}
+
+/** Decides what goes into the diffs report for (tableA) and (tableB) (which should contain only the symbols that didn't match),
+  * adding each item to (retEntries), in report order:  first (renames), then the symbols of (tableA) in table order, then the
+  * symbols that are only in (tableB), in table order.
+  */
+static void CollectReportEntries(const Hashtable<String, SymbolRecord> & tableA, const Hashtable<String, SymbolRecord> & tableB, const Queue<RenamedSymbol> & renames, Queue<ReportEntry> & retEntries)
+{
+   Hashtable<String, Void> reported;
+   for (uint32 i=0; i<renames.GetNumItems(); i++)
+   {
+      const RenamedSymbol & r = renames[i];
+      const SymbolRecord * valA = tableA.Get(r._nameA);
+      const SymbolRecord * valB = tableB.Get(r._nameB);
+      if ((valA == NULL)||(valB == NULL)) continue;  // paranoia
+
+      // Both names are marked as reported, so that neither one gets reported as being present in only one of the executables
+      (void) reported.PutWithDefault(r._nameA);
+      (void) reported.PutWithDefault(r._nameB);
+
+      if (retEntries.AddTail(ReportEntry(REPORT_ENTRY_RENAMED, r._nameA, valA, r._nameB, valB, r._similarity)) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+   }
+
+   CollectDifferingSymbolsAux(tableA, tableB, true,  reported, retEntries);
+   CollectDifferingSymbolsAux(tableB, tableA, false, reported, retEntries);
+}
+
+/** Prints one line to stdout for each of (entries), saying how that symbol differs between (fileA) and (fileB) */
+static void LogReportEntries(const char * fileA, const char * fileB, const Queue<ReportEntry> & entries)
+{
+   for (uint32 i=0; i<entries.GetNumItems(); i++)
+   {
+      const ReportEntry & e = entries[i];
+      switch(e._type)
+      {
+         case REPORT_ENTRY_DIFFERS:
+            LogTime(MUSCLE_LOG_WARNING, "Diffs detected in symbol [%s]\n", e._nameA());
+         break;
+
+         case REPORT_ENTRY_RENAMED:
+            LogTime(MUSCLE_LOG_WARNING, "Symbol [%s] in [%s] appears to have been renamed to [%s] in [%s] (" UINT32_FORMAT_SPEC "%% similar)\n", e._nameA(), fileA, e._nameB(), fileB, e._similarity);
+         break;
+
+         case REPORT_ENTRY_ONLY_IN_A:
+            LogTime(MUSCLE_LOG_WARNING, "Symbol [%s] exists in [%s] but is not present in [%s]\n", e._nameA(), fileA, fileB);
+         break;
+
+         case REPORT_ENTRY_ONLY_IN_B:
+            LogTime(MUSCLE_LOG_WARNING, "Symbol [%s] exists in [%s] but is not present in [%s]\n", e._nameB(), fileB, fileA);
+         break;
+      }
+   }
+}
+
+/** Prints the summary line(s) that precede the per-symbol lines of a two-way comparison */
+static void LogComparisonSummary(uint32 numMatching, uint32 numNonMatching, uint32 numRenames)
+{
+   LogTime(MUSCLE_LOG_INFO, "Found " UINT32_FORMAT_SPEC " matching symbols and " UINT32_FORMAT_SPEC " non-matching symbols.\n", numMatching, numNonMatching);
+   if (numRenames > 0) LogTime(MUSCLE_LOG_INFO, "Of the non-matching symbols, " UINT32_FORMAT_SPEC " pairs appear to have been renamed.\n", numRenames);
+}
+
+/** Appends (s) to (out) as a quoted JSON string */
+static void AppendJSONString(const String & s, TextArena & out) {AppendJSONString(s(), s.Length(), out);}
+
+/** Appends (entry)'s part of the text report to (out).  (optDiffs) must be the diffs between its two symbols, if it has two. */
+static void AppendTextReportEntry(const ReportEntry & entry, const LineDiffs * optDiffs, TextArena & out)
+{
+   switch(entry._type)
+   {
+      case REPORT_ENTRY_DIFFERS:
+         if (optDiffs) AppendSymbolDiffs(entry._nameA, *optDiffs, out);
+      break;
+
+      case REPORT_ENTRY_RENAMED:
+         if (optDiffs) AppendSymbolDiffs(String("%1 (renamed to %2)").Arg(entry._nameA).Arg(entry._nameB), *optDiffs, out);
+         else
+         {
+            AppendCString("\n\n===================== [", out);
+            AppendString(entry._nameA, out);
+            AppendCString("] was renamed to [", out);
+            AppendString(entry._nameB, out);
+            AppendCString("], without any other changes\n", out);
+         }
+      break;
+
+      default:
+         // symbols that are present in only one executable are only logged, not written to the text report
+      break;
+   }
+}
+
+/** Appends (entry) to (out) as one line of JSON (see the README for its format).  (optDiffs) must be the diffs between its two symbols, if it has two. */
+static void AppendJSONReportEntry(const ReportEntry & entry, const LineDiffs * optDiffs, TextArena & out)
+{
+   char buf[128];
+   switch(entry._type)
+   {
+      case REPORT_ENTRY_DIFFERS:   AppendCString("{\"type\":\"differs\",\"symbol\":",  out); AppendJSONString(entry._nameA, out); break;
+      case REPORT_ENTRY_ONLY_IN_A: AppendCString("{\"type\":\"removed\",\"symbol\":",  out); AppendJSONString(entry._nameA, out); break;
+      case REPORT_ENTRY_ONLY_IN_B: AppendCString("{\"type\":\"added\",\"symbol\":",    out); AppendJSONString(entry._nameB, out); break;
+      case REPORT_ENTRY_RENAMED:
+         AppendCString("{\"type\":\"renamed\",\"symbol\":", out);
+         AppendJSONString(entry._nameA, out);
+         AppendCString(",\"renamed_to\":", out);
+         AppendJSONString(entry._nameB, out);
+         muscleSprintf(buf, ",\"similarity\":" UINT32_FORMAT_SPEC, entry._similarity);
+         AppendCString(buf, out);
+      break;
+   }
+
+   if ((entry._type == REPORT_ENTRY_DIFFERS)||(entry._type == REPORT_ENTRY_RENAMED))
+   {
+      AppendCString(",\"hunks\":[", out);
+      const uint32 numHunks = optDiffs ? optDiffs->_hunks.GetNumItems() : 0;
+      for (uint32 i=0; i<numHunks; i++)
+      {
+         const DiffHunk & h = optDiffs->_hunks[i];
+         muscleSprintf(buf, "%s{\"a_line\":" UINT32_FORMAT_SPEC ",\"a_count\":" UINT32_FORMAT_SPEC ",\"b_line\":" UINT32_FORMAT_SPEC ",\"b_count\":" UINT32_FORMAT_SPEC ",\"removed\":[", (i > 0) ? "," : "", h._aFrom+1, h._aTo-h._aFrom, h._bFrom+1, h._bTo-h._bFrom);
+         AppendCString(buf, out);
+         for (uint32 j=h._aFrom; j<h._aTo; j++)
+         {
+            if (j > h._aFrom) (void) out.Append(',');
+            AppendJSONString(optDiffs->_linesA[j]._chars, optDiffs->_linesA[j]._length, out);
+         }
+         AppendCString("],\"added\":[", out);
+         for (uint32 j=h._bFrom; j<h._bTo; j++)
+         {
+            if (j > h._bFrom) (void) out.Append(',');
+            AppendJSONString(optDiffs->_linesB[j]._chars, optDiffs->_linesB[j]._length, out);
+         }
+         AppendCString("]}", out);
+      }
+      (void) out.Append(']');
+   }
+   AppendCString("}\n", out);
+}
+
+/** Writes chunks of text to a file in the order of their indices, no matter what order (or from which threads) they are
+  * submitted in.  Chunks that arrive early are held until all of the chunks before them have been written, and the
+  * text is gathered into large blocks before being handed to fwrite().
+  */
+class OrderedChunkWriter
+{
+public:
+   OrderedChunkWriter(FILE * fpOut, uint32 maxPendingChunks = 64, uint32 bufferSize = 1024*1024) : _fpOut(fpOut), _nextChunkIdx(0), _maxPendingChunks(muscleMax(maxPendingChunks, (uint32)1)), _buffer(newnothrow_array(char, bufferSize)), _bufferSize(_buffer ? bufferSize : 0), _numBuffered(0), _hadError(false) {/* empty */}
+   ~OrderedChunkWriter() {(void) Flush(); delete [] _buffer;}
+
+   /** Submits chunk number (chunkIdx), whose text is (span).  (span) must point into (arena), which we keep a reference to until the chunk has been written.
+     * So that one slow chunk can't leave all of the chunks after it waiting in memory, this blocks while (chunkIdx) is (maxPendingChunks) or more
+     * chunks ahead of the next chunk to be written.  That means the chunks must be handed out in order (see WorkStealingExecutor's inOrder argument),
+     * so that the chunk everyone is waiting for is always being worked on.
+     */
+   void SubmitChunk(uint32 chunkIdx, const TextArenaRef & arena, const TextSpan & span)
+   {
+      MutexGuard mg(_mutex);
+      while((chunkIdx-_nextChunkIdx) >= _maxPendingChunks) _chunkWritten.Wait(_mutex);
+
+      if (chunkIdx != _nextChunkIdx)
+      {
+         if (_pendingChunks.Put(chunkIdx, PendingChunk(arena, span)) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+         return;
+      }
+
+      WriteChunk(span);
+      PendingChunk next;
+      while(_pendingChunks.Remove(++_nextChunkIdx, next) == B_NO_ERROR) WriteChunk(next._span);
+      _chunkWritten.NotifyAll();
+   }
+
+   /** Writes out any buffered text.  Returns B_NO_ERROR on success, or B_ERROR if any of our text couldn't be written. */
+   status_t Flush()
+   {
+      MutexGuard mg(_mutex);
+      FlushBuffer();
+      return ((_hadError)||(_pendingChunks.HasItems())) ? B_ERROR : B_NO_ERROR;
+   }
+
+private:
+   OrderedChunkWriter(const OrderedChunkWriter &);  // deliberately unimplemented
+   OrderedChunkWriter & operator = (const OrderedChunkWriter &);  // deliberately unimplemented
+
+   class PendingChunk
+   {
+   public:
+      PendingChunk() {/* empty */}
+      PendingChunk(const TextArenaRef & arena, const TextSpan & span) : _arena(arena), _span(span) {/* empty */}
+
+      TextArenaRef _arena;
+      TextSpan _span;
+   };
+
+   void WriteChunk(const TextSpan & span)
+   {
+      if (span._length == 0) return;  // (empty spans may have NULL pointers)
+      if ((_numBuffered+span._length) > _bufferSize) FlushBuffer();
+      if (span._length > _bufferSize) WriteBytes(span._chars, span._length);  // too big to buffer, so just write it directly
+      else
+      {
+         memcpy(_buffer+_numBuffered, span._chars, span._length);
+         _numBuffered += span._length;
+      }
+   }
+
+   void FlushBuffer()
+   {
+      WriteBytes(_buffer, _numBuffered);
+      _numBuffered = 0;
+   }
+
+   void WriteBytes(const char * bytes, uint32 numBytes) {if ((numBytes > 0)&&(fwrite(bytes, 1, numBytes, _fpOut) != numBytes)) _hadError = true;}
+
+   Mutex _mutex;
+   MutexConditionVariable _chunkWritten;           // signalled whenever _nextChunkIdx advances
+   FILE * _fpOut;
+   uint32 _nextChunkIdx;                           // the index of the next chunk to be written
+   const uint32 _maxPendingChunks;
+   Hashtable<uint32, PendingChunk> _pendingChunks; // chunks that were submitted before their predecessors were (at most _maxPendingChunks of them)
+   char * _buffer;
+   const uint32 _bufferSize;
+   uint32 _numBuffered;
+   bool _hadError;
+};
+
+/** Renders each ReportEntry's part of the text report (and/or the JSON report) as its own task, and hands the results to the writers */
+class ReportRenderTasks : public AbstractParallelTasks
+{
+public:
+   ReportRenderTasks(const Queue<ReportEntry> & entries, const LineTable & lineTable, OrderedChunkWriter * optTextWriter, OrderedChunkWriter * optJSONWriter) : _entries(entries), _lineTable(lineTable), _optTextWriter(optTextWriter), _optJSONWriter(optJSONWriter) {/* empty */}
+
+   virtual void ExecuteTask(uint32 taskIdx, uint32 /*workerIdx*/)
+   {
+      const ReportEntry & entry = _entries[taskIdx];
+
+      // Renamed symbols whose only differences are their references to their own names get no diffs
+      const LineDiffs * optDiffs = NULL;
+      LineDiffs * diffs = NULL;
+      if ((entry._recA)&&(entry._recB)&&((entry._type != REPORT_ENTRY_RENAMED)||(HasSameTextExceptNames(entry._nameA, entry._recA->_lines, entry._nameB, entry._recB->_lines, _lineTable) == false)))
+      {
+         diffs = newnothrow LineDiffs(entry._recA->_lines, entry._recB->_lines, _lineTable);
+         if (diffs == NULL) WARN_OUT_OF_MEMORY;
+         optDiffs = diffs;
+      }
+
+      // Every chunk must be submitted (even if it's empty), or the writers would wait for it forever
+      TextArenaRef arena(newnothrow TextArena(64*1024));
+      TextSpan textSpan, jsonSpan;
+      if (arena())
+      {
+         if (_optTextWriter)
+         {
+            arena()->BeginSpan();
+            AppendTextReportEntry(entry, optDiffs, *arena());
+            textSpan = arena()->EndSpan();
+         }
+         if (_optJSONWriter)
+         {
+            arena()->BeginSpan();
+            AppendJSONReportEntry(entry, optDiffs, *arena());
+            jsonSpan = arena()->EndSpan();
+         }
+      }
+      else WARN_OUT_OF_MEMORY;
+      delete diffs;
+
+      if (_optTextWriter) _optTextWriter->SubmitChunk(taskIdx, arena, textSpan);
+      if (_optJSONWriter) _optJSONWriter->SubmitChunk(taskIdx, arena, jsonSpan);
+   }
+
+private:
+   const Queue<ReportEntry> & _entries;
+   const LineTable & _lineTable;
+   OrderedChunkWriter * _optTextWriter;
+   OrderedChunkWriter * _optJSONWriter;
+};
+
+/** Writes the diffs report for (entries) (whose symbols' line IDs refer to (lineTable)) to (optTextOut) and/or the JSON report to
+  * (optJSONOut), using (numThreads) threads to compute the diffs.  The output is the same no matter how many threads are used.
+  * Returns B_NO_ERROR on success, or B_ERROR if there was an error writing either file.
+  */
+static status_t WriteReportFiles(const char * fileA, const char * fileB, const Queue<ReportEntry> & entries, const LineTable & lineTable, FILE * optTextOut, FILE * optJSONOut, uint32 numThreads)
+{
+   if ((optTextOut == NULL)&&(optJSONOut == NULL)) return B_NO_ERROR;
+
+   if (optJSONOut)
+   {
+      // The first line of the JSON report says which executables were compared
+      TextArena header(1024);
+      header.BeginSpan();
+      AppendCString("{\"type\":\"files\",\"a\":", header);
+      AppendJSONString(fileA, (uint32) strlen(fileA), header);
+      AppendCString(",\"b\":", header);
+      AppendJSONString(fileB, (uint32) strlen(fileB), header);
+      AppendCString("}\n", header);
+      const TextSpan headerSpan = header.EndSpan();
+      if (fwrite(headerSpan._chars, 1, headerSpan._length, optJSONOut) != headerSpan._length) return B_ERROR;
+   }
+
+   OrderedChunkWriter textWriter(optTextOut);
+   OrderedChunkWriter jsonWriter(optJSONOut);
+   ReportRenderTasks tasks(entries, lineTable, optTextOut ? &textWriter : NULL, optJSONOut ? &jsonWriter : NULL);
+
+   Queue<uint32> taskIndices;  // in report order, and started strictly in that order, as the writers require
+   for (uint32 i=0; i<entries.GetNumItems(); i++) (void) taskIndices.AddTail(i);
+   WorkStealingExecutor(tasks).ExecuteTasks(taskIndices, numThreads, true);
+
+   const bool textOK = ((optTextOut == NULL)||(textWriter.Flush() == B_NO_ERROR));
+   const bool jsonOK = ((optJSONOut == NULL)||(jsonWriter.Flush() == B_NO_ERROR));
+   return ((textOK)&&(jsonOK)) ? B_NO_ERROR : B_ERROR;
+}
+
+/** Returns the current date and time as a String that can be used as part of a file name */
+static String GetFileNameTimestamp()
+{
+   String ret = GetHumanReadableTimeString(GetCurrentTime64());
+   ret.Replace('/', '_');
+   ret.Replace(':', '_');
+   ret.Replace(' ', '_');
+   return ret;
+}
+
+enum {
+   SYMBOL_CHANGE_DIFFERS = 'D',  // the symbol is present in both executables, but its text differs
+   SYMBOL_CHANGE_REMOVED = '-',  // the symbol is present in the baseline but not in the build
+   SYMBOL_CHANGE_ADDED   = '+',  // the symbol is present in the build but not in the baseline
+   SYMBOL_CHANGE_RENAMED = 'R'   // the symbol is present in only one of the executables, but appears to have been renamed
+};
+
+/** The outcome of comparing one build against the baseline, in N-way mode */
+class BuildComparisonResult
+{
+public:
+   BuildComparisonResult() : _parseFailed(false), _numMatchingSymbols(0) {/* empty */}
+
+   bool _parseFailed;  // true iff the build couldn't be disassembled, in which case it wasn't compared
+   uint32 _numMatchingSymbols;
+   Hashtable<String, char> _changedSymbols;  // symbol name -> SYMBOL_CHANGE_*, for each symbol that didn't match
+   String _reportFileName;
+};
+
+/** Compares each of several builds against an already-parsed baseline executable; there is one task per build.
+  * Each build is parsed, compared, reported on and then freed by whichever worker executes its task, so only as
+  * many builds as there are workers need to be held in memory at once.
+  */
+class BuildComparisonTasks : public AbstractParallelTasks
+{
+public:
+   BuildComparisonTasks(const char * baselineFile, const SymbolTable & baseline, const Queue<String> & buildFiles, const ParseSettings & settings, const String & timestamp, bool detectRenames, bool writeJSON)
+      : _baselineFile(baselineFile), _baseline(baseline), _buildFiles(buildFiles), _settings(settings), _timestamp(timestamp), _detectRenames(detectRenames), _writeJSON(writeJSON)
+   {
+      (void) _results.EnsureSize(buildFiles.GetNumItems(), true);
+      for (uint32 i=0; i<buildFiles.GetNumItems(); i++) (void) _labels.AddTail(String("%1").Arg(i+1));
+   }
+
+   virtual void ExecuteTask(uint32 taskIdx, uint32 /*workerIdx*/)
+   {
+      const char * buildFile = _buildFiles[taskIdx]();
+
+      // The build's lines that the baseline doesn't have go into an overlay of the baseline's dictionary, which gets freed along with the build
+      ParseSettings settings = _settings;
+      settings._lineTable = LineTableRef(newnothrow LineTable(_baseline._lineTable));
+      if (settings._lineTable() == NULL) {WARN_OUT_OF_MEMORY; return;}
+
+      BuildComparisonResult & result = _results[taskIdx];
+      SymbolTable build;
+      if (ParseExecutableFile(buildFile, _labels[taskIdx](), settings, build) != B_NO_ERROR)
+      {
+         _progressDisplay.LogMessage(MUSCLE_LOG_ERROR, String("Build %1 [%2]:  unable to disassemble it, so it wasn't compared.").Arg(_labels[taskIdx]).Arg(buildFile));
+         result._parseFailed = true;
+         return;
+      }
+      const LineTable & lineTable = *build._lineTable();
+
+      // RemoveMatchingSymbolsAux() removes entries from the tables it is given, and the baseline is shared by all of the builds
+      Hashtable<String, SymbolRecord> baselineSymbols = _baseline._symbols;
+      Hashtable<String, SymbolRecord> & buildSymbols  = build._symbols;
+
+      PhaseRecorder comparePhase(_settings._optStats, "compare", _labels[taskIdx]());
+      comparePhase.GetStats()._numSymbols = baselineSymbols.GetNumItems()+buildSymbols.GetNumItems();
+      result._numMatchingSymbols = RemoveMatchingSymbolsAux(baselineSymbols, buildSymbols);
+      for (HashtableIterator<String, SymbolRecord> iter(baselineSymbols); iter.HasData(); iter++) (void) result._changedSymbols.Put(iter.GetKey(), buildSymbols.ContainsKey(iter.GetKey()) ? SYMBOL_CHANGE_DIFFERS : SYMBOL_CHANGE_REMOVED);
+      for (HashtableIterator<String, SymbolRecord> iter(buildSymbols); iter.HasData(); iter++) if (baselineSymbols.ContainsKey(iter.GetKey()) == false) (void) result._changedSymbols.Put(iter.GetKey(), SYMBOL_CHANGE_ADDED);
+
+      Queue<RenamedSymbol> renames;
+      if (_detectRenames) FindRenamedSymbols(baselineSymbols, buildSymbols, lineTable, renames);
+      for (uint32 i=0; i<renames.GetNumItems(); i++)
+      {
+         (void) result._changedSymbols.Put(renames[i]._nameA, SYMBOL_CHANGE_RENAMED);
+         (void) result._changedSymbols.Put(renames[i]._nameB, SYMBOL_CHANGE_RENAMED);
+      }
+      comparePhase.Finish();
+
+      PhaseRecorder reportPhase(_settings._optStats, "report", _labels[taskIdx]());
+      result._reportFileName = String("executable_diffs_report_%1_build%2.txt").Arg(_timestamp).Arg(_labels[taskIdx]);
+      FILE * fpOut = fopen(result._reportFileName(), "w");
+      if (fpOut)
+      {
+         const String jsonFileName = String("executable_diffs_report_%1_build%2.jsonl").Arg(_timestamp).Arg(_labels[taskIdx]);
+         FILE * fpJSON = _writeJSON ? fopen(jsonFileName(), "w") : NULL;
+         if ((_writeJSON)&&(fpJSON == NULL)) _progressDisplay.LogMessage(MUSCLE_LOG_ERROR, String("Unable to write JSON report file [%1]").Arg(jsonFileName));
+
+         // Each build is already being compared by its own worker, so the report doesn't need any more threads
+         Queue<ReportEntry> entries;
+         CollectReportEntries(baselineSymbols, buildSymbols, renames, entries);
+         if (WriteReportFiles(_baselineFile, buildFile, entries, lineTable, fpOut, fpJSON, 1) != B_NO_ERROR) _progressDisplay.LogMessage(MUSCLE_LOG_ERROR, String("Error writing the diffs report for build %1").Arg(_labels[taskIdx]));
+         fclose(fpOut);
+         if (fpJSON) fclose(fpJSON);
+         reportPhase.GetStats()._numSymbols = entries.GetNumItems();
+      }
+      else result._reportFileName.Clear();
+      reportPhase.Finish();
+
+      _progressDisplay.LogMessage(MUSCLE_LOG_INFO, String("Build %1 [%2]:  found %3 matching symbols and %4 non-matching symbols.%5").Arg(_labels[taskIdx]).Arg(buildFile).Arg(result._numMatchingSymbols).Arg(result._changedSymbols.GetNumItems()).Arg(result._reportFileName.HasChars() ? String("  Diffs report written to file [%1]").Arg(result._reportFileName) : GetEmptyString()));
+   }
+
+   const Queue<BuildComparisonResult> & GetResults() const {return _results;}
+
+private:
+   const char * _baselineFile;
+   const SymbolTable & _baseline;
+   const Queue<String> & _buildFiles;
+   const ParseSettings _settings;
+   const String _timestamp;
+   const bool _detectRenames;
+   const bool _writeJSON;
+   Queue<String> _labels;                    // "1", "2", etc, used to identify each build's progress-line
+   Queue<BuildComparisonResult> _results;    // one per build, written by whichever worker compared that build
+};
+
+/** Writes a matrix showing which symbols changed in which builds, relative to the baseline */
+static void WriteSummaryMatrix(const char * baselineFile, const Queue<String> & buildFiles, const Queue<BuildComparisonResult> & results, FILE * fpOut)
+{
+   fprintf(fpOut, "Baseline:  %s\n", baselineFile);
+   for (uint32 i=0; i<buildFiles.GetNumItems(); i++)
+   {
+      const BuildComparisonResult & r = results[i];
+      if (r._parseFailed) fprintf(fpOut, "Build %3u: %s  (unable to disassemble it)\n", (unsigned int) (i+1), buildFiles[i]());
+                     else fprintf(fpOut, "Build %3u: %s  (" UINT32_FORMAT_SPEC " matching, " UINT32_FORMAT_SPEC " non-matching symbols; %s%s)\n", (unsigned int) (i+1), buildFiles[i](), r._numMatchingSymbols, r._changedSymbols.GetNumItems(), r._reportFileName.HasChars() ? "diffs in " : "no report written", r._reportFileName());
+   }
+   fprintf(fpOut, "\nD = differs from the baseline, - = not present in the build, + = only present in the build, R = renamed, . = same as the baseline, ? = not compared\n\n");
+
+   Hashtable<String, Void> allChangedSymbols;
+   for (uint32 i=0; i<results.GetNumItems(); i++) for (HashtableIterator<String, char> iter(results[i]._changedSymbols); iter.HasData(); iter++) (void) allChangedSymbols.PutWithDefault(iter.GetKey());
+   allChangedSymbols.SortByKey();
+
+   for (uint32 i=0; i<buildFiles.GetNumItems(); i++) fprintf(fpOut, "%4u", (unsigned int) (i+1));
+   fprintf(fpOut, "\n");
+   for (HashtableIterator<String, Void> iter(allChangedSymbols); iter.HasData(); iter++)
+   {
+      for (uint32 i=0; i<results.GetNumItems(); i++) fprintf(fpOut, "%4c", results[i]._parseFailed ? '?' : results[i]._changedSymbols.GetWithDefault(iter.GetKey(), '.'));
+      fprintf(fpOut, "   %s\n", iter.GetKey()());
+   }
+}
+
+/** Writes (stats) to a JSON file whose name matches the diffs report(s) written at (timestamp) */
+static void WriteStatsFile(const RunStats & stats, const String & timestamp, const Queue<String> & executables)
+{
+   const String statsFileName = String("executable_diffs_stats_%1.json").Arg(timestamp);
+   if (stats.WriteJSONFile(statsFileName, executables) == B_NO_ERROR) LogTime(MUSCLE_LOG_INFO, "Performance statistics written to file [%s]\n", statsFileName());
+                                                                  else LogTime(MUSCLE_LOG_ERROR, "Unable to write performance statistics file [%s]\n", statsFileName());
+}
+
+/** N-way mode:  compares each of (buildFiles) against (baselineFile), parsing the baseline only once.
+  * (totalPhase) is finished just before the stats file (if any) is written.
+  */
+static int CompareBuildsAgainstBaseline(const char * baselineFile, const Queue<String> & buildFiles, const ParseSettings & settings, uint32 numJobs, bool detectRenames, bool writeJSON, PhaseRecorder & totalPhase)
+{
+   // The baseline gets parsed by itself, so it can use all of the jobs
+   ParseSettings baselineSettings = settings;
+   baselineSettings._numDisassemblyJobs  = muscleMax(numJobs, (uint32)1);
+   baselineSettings._numSanitizerThreads = baselineSettings._numDisassemblyJobs;
+
+   SymbolTable baseline;
+   if (ParseExecutableFile(baselineFile, "baseline", baselineSettings, baseline) != B_NO_ERROR)
+   {
+      LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to disassemble baseline executable [%s], so no builds can be compared against it.\n", baselineFile);
+      return 10;
+   }
+
+   // Several builds get parsed at once, and they share the jobs between them
+   const uint32 numConcurrentBuilds = muscleMax(muscleMin(numJobs, buildFiles.GetNumItems()), (uint32)1);
+   ParseSettings buildSettings = settings;
+   buildSettings._numDisassemblyJobs  = muscleMax(numJobs/numConcurrentBuilds, (uint32)1);
+   buildSettings._numSanitizerThreads = buildSettings._numDisassemblyJobs;
+   if (settings._spillDirectory.HasChars()) buildSettings._optBaseline = &baseline._symbols;  // so that each build only keeps the text of its symbols that differ
+
+   const String timestamp = GetFileNameTimestamp();
+   BuildComparisonTasks tasks(baselineFile, baseline, buildFiles, buildSettings, timestamp, detectRenames, writeJSON);
+   Queue<uint32> taskIndices;
+   for (uint32 i=0; i<buildFiles.GetNumItems(); i++) (void) taskIndices.AddTail(i);
+   WorkStealingExecutor(tasks).ExecuteTasks(taskIndices, numConcurrentBuilds);
+
+   printf("\n");
+   printf("-------------------------------------------------------------\n");
+   printf("\n");
+
+   const String summaryFileName = String("executable_diffs_summary_%1.txt").Arg(timestamp);
+   FILE * fpOut = fopen(summaryFileName(), "w");
+   if (fpOut)
+   {
+      WriteSummaryMatrix(baselineFile, buildFiles, tasks.GetResults(), fpOut);
+      fclose(fpOut);
+      LogTime(MUSCLE_LOG_INFO, "Summary of changes in all " UINT32_FORMAT_SPEC " builds written to file [%s]\n", buildFiles.GetNumItems(), summaryFileName());
+   }
+   else LogTime(MUSCLE_LOG_ERROR, "Unable to write summary file [%s]\n", summaryFileName());
+
+   if (settings._optStats)
+   {
+      totalPhase.Finish();
+
+      Queue<String> executables = buildFiles;
+      (void) executables.AddHead(baselineFile);
+      WriteStatsFile(*settings._optStats, timestamp, executables);
+   }
+
+   for (uint32 i=0; i<tasks.GetResults().GetNumItems(); i++) if (tasks.GetResults()[i]._parseFailed) return 10;
+   return 0;
+}
+
+/** A fixed number of job slots (disassembler processes and worker threads) that several concurrent tasks share.  Slots are
+  * granted in the order in which they were asked for, so that a task that needs many of them can't be starved by a stream
+  * of tasks that each need only one.
+  */
+class JobSlots
+{
+public:
+   JobSlots(uint32 numSlots) : _numFreeSlots(numSlots), _nextTicket(0), _nowServing(0) {/* empty */}
+
+   /** Blocks until (numSlots) slots have been granted to the caller.  The caller must call Release(numSlots) when it is done with them. */
+   void Acquire(uint32 numSlots)
+   {
+      MutexGuard mg(_mutex);
+      const uint32 ticket = _nextTicket++;
+      while((ticket != _nowServing)||(_numFreeSlots < numSlots)) _changed.Wait(_mutex);
+
+      _numFreeSlots -= numSlots;
+      _nowServing++;
+      _changed.NotifyAll();  // the next ticket-holder in line may be able to go ahead too
+   }
+
+   /** Gives back (numSlots) slots that were granted by Acquire() */
+   void Release(uint32 numSlots)
+   {
+      MutexGuard mg(_mutex);
+      _numFreeSlots += numSlots;
+      _changed.NotifyAll();
+   }
+
+private:
+   Mutex _mutex;
+   MutexConditionVariable _changed;  // signalled whenever _numFreeSlots or _nowServing changes
+   uint32 _numFreeSlots;
+   uint32 _nextTicket;  // the ticket that the next caller of Acquire() will get
+   uint32 _nowServing;  // the ticket whose holder is next in line for slots
+};
+
+/** Returns true iff the file at (path) is an executable (or shared library, or object file) that we know how to disassemble */
+static bool IsExecutableFile(const char * path)
+{
+   uint8 magic[4];
+   FILE * fpIn = fopen(path, "rb");
+   if (fpIn == NULL) return false;
+   const bool gotMagic = (fread(magic, 1, sizeof(magic), fpIn) == sizeof(magic));
+   fclose(fpIn);
+   if (gotMagic == false) return false;
+
+#ifdef __APPLE__
+   const uint32 bigEndianMagic = (((uint32)magic[0])<<24)|(((uint32)magic[1])<<16)|(((uint32)magic[2])<<8)|((uint32)magic[3]);
+   switch(bigEndianMagic)
+   {
+      case 0xFEEDFACE: case 0xFEEDFACF: case 0xCEFAEDFE: case 0xCFFAEDFE: case 0xCAFEBABE: return true;  // Mach-O (32-bit, 64-bit, either byte-order) or universal binary
+      default:                                                                            return false;
+   }
+#else
+   return (memcmp(magic, ELFMAG, SELFMAG) == 0);
+#endif
+}
+
+/** Adds to (retFiles) the path (relative to (rootDir)) and size of each regular file in the (relDir) subdirectory of (rootDir), and
+  * in its subdirectories.  Symbolic links are skipped, so that e.g. libfoo.so -> libfoo.so.1 is only compared once.  The files aren't
+  * checked for being executables yet, so that a file whose version in one tree is broken (e.g. truncated) still gets paired up.
+  */
+static void CollectRegularFiles(const String & rootDir, const String & relDir, Hashtable<String, uint64> & retFiles)
+{
+   const String dirPath = relDir.HasChars() ? (rootDir + "/" + relDir) : rootDir;
+   Directory dir(dirPath());
+   if (dir.IsValid() == false)
+   {
+      LogTime(MUSCLE_LOG_WARNING, "Unable to read directory [%s], skipping it.\n", dirPath());
+      return;
+   }
+
+   for (const char * fileName; (fileName = dir.GetCurrentFileName()) != NULL; dir++)
+   {
+      if ((strcmp(fileName, ".") == 0)||(strcmp(fileName, "..") == 0)) continue;
+
+      const String relPath  = relDir.HasChars() ? (relDir + "/" + fileName) : String(fileName);
+      const String fullPath = rootDir + "/" + relPath;
+      struct stat st;
+      if (lstat(fullPath(), &st) != 0) continue;
+           if (S_ISDIR(st.st_mode)) CollectRegularFiles(rootDir, relPath, retFiles);
+      else if ((S_ISREG(st.st_mode))&&(retFiles.Put(relPath, st.st_size) != B_NO_ERROR)) WARN_OUT_OF_MEMORY;
+   }
+}
+
+/** Returns true iff the files at (pathA) and (pathB) have exactly the same contents, in which case there's no need to parse them */
+static bool AreFilesIdentical(const char * pathA, const char * pathB)
+{
+   MemoryMappedFile fileA, fileB;
+   if ((fileA.Map(pathA) != B_NO_ERROR)||(fileB.Map(pathB) != B_NO_ERROR)) return false;
+   return (fileA.GetNumBytes() == fileB.GetNumBytes())&&(memcmp(fileA.GetData(), fileB.GetData(), (size_t) fileA.GetNumBytes()) == 0);
+}
+
+enum {
+   TREE_FILE_IDENTICAL = 0,  // the two files have the same contents, so they didn't need to be parsed
+   TREE_FILE_UNCHANGED,      // the two files differ, but all of their symbols matched
+   TREE_FILE_CHANGED,        // some of the files' symbols differ
+   TREE_FILE_ONLY_IN_A,      // the file is only present in the first tree
+   TREE_FILE_ONLY_IN_B,      // the file is only present in the second tree
+   TREE_FILE_INVALID_IN_A,   // the file is present in both trees, but only its version in the second tree is an executable (see IsExecutableFile())
+   TREE_FILE_INVALID_IN_B,   // the file is present in both trees, but only its version in the first tree is an executable
+   TREE_FILE_PARSE_FAILED    // the disassembler failed on one of the file's two versions, so they couldn't be compared
+};
+
+/** One executable file of a tree comparison, and (once it has been compared) the outcome */
+class TreeFileComparison
+{
+public:
+   TreeFileComparison() : _numBytesA(0), _numBytesB(0), _status(TREE_FILE_IDENTICAL), _numMatchingSymbols(0), _numNonMatchingSymbols(0), _numRenames(0), _reportFile(NULL), _jsonFile(NULL) {/* empty */}
+
+   String _relativePath;
+   uint64 _numBytesA;  // the file's size in tree A (or 0 if it's only in tree B)
+   uint64 _numBytesB;  // the file's size in tree B (or 0 if it's only in tree A)
+
+   uint32 _status;     // TREE_FILE_*
+   uint32 _numMatchingSymbols;
+   uint32 _numNonMatchingSymbols;
+   uint32 _numRenames;
+   FILE * _reportFile; // for TREE_FILE_CHANGED, a temporary file holding this file's part of the text report
+   FILE * _jsonFile;   // for TREE_FILE_CHANGED with --json, a temporary file holding this file's part of the JSON report
+};
+
+/** Compares the executables that are present in both trees; there is one task per file.  Each task parses the file's
+  * two versions one after the other, using however many job slots it was granted, so that the total number of
+  * disassembler processes never exceeds the number of job slots, no matter how many tasks are running at once.
+  */
+class TreeComparisonTasks : public AbstractParallelTasks
+{
+public:
+   TreeComparisonTasks(const String & dirA, const String & dirB, Queue<TreeFileComparison> & files, const ParseSettings & settings, uint32 numJobs, bool detectRenames, bool writeJSON)
+      : _dirA(dirA), _dirB(dirB), _files(files), _settings(settings), _numJobs(numJobs), _jobSlots(numJobs), _detectRenames(detectRenames), _writeJSON(writeJSON), _totalBytes(0)
+   {
+      for (uint32 i=0; i<files.GetNumItems(); i++) _totalBytes += files[i]._numBytesA+files[i]._numBytesB;
+   }
+
+   virtual void ExecuteTask(uint32 taskIdx, uint32 /*workerIdx*/)
+   {
+      TreeFileComparison & file = _files[taskIdx];
+      const String pathA = _dirA + "/" + file._relativePath;
+      const String pathB = _dirB + "/" + file._relativePath;
+      if (AreFilesIdentical(pathA(), pathB()))
+      {
+         file._status = TREE_FILE_IDENTICAL;
+         return;
+      }
+
+      // Each file gets a share of the jobs that is proportional to its size, so that the biggest files (which get
+      // started first) don't end up being parsed by a single job while every other file has already been compared
+      const uint64 numFileBytes = file._numBytesA+file._numBytesB;
+      const uint32 numJobs = muscleMin(_numJobs, muscleMax((uint32)1, (uint32)(((_numJobs*numFileBytes)+_totalBytes-1)/muscleMax(_totalBytes, (uint64)1))));
+      _jobSlots.Acquire(numJobs);
+
+      ParseSettings settings = _settings;
+      settings._numDisassemblyJobs  = numJobs;
+      settings._numSanitizerThreads = numJobs;
+      settings._lineTable = LineTableRef(newnothrow LineTable);  // shared by just this file's two versions, so that it gets freed along with them
+      if (settings._lineTable() == NULL) WARN_OUT_OF_MEMORY;
+
+      const String labelA = file._relativePath + " (A)";
+      const String labelB = file._relativePath + " (B)";
+      SymbolTable tableA, tableB;
+      status_t parseRet = ParseExecutableFile(pathA(), labelA(), settings, tableA);
+      if (settings._spillDirectory.HasChars()) settings._optBaseline = &tableA._symbols;  // so that B only keeps the text of its symbols that differ
+      if (parseRet == B_NO_ERROR) parseRet = ParseExecutableFile(pathB(), labelB(), settings, tableB);
+      if (parseRet != B_NO_ERROR)
+      {
+         _jobSlots.Release(numJobs);
+         _progressDisplay.LogMessage(MUSCLE_LOG_ERROR, String("[%1]:  unable to disassemble it, so it can't be compared.").Arg(file._relativePath));
+         file._status = TREE_FILE_PARSE_FAILED;
+         return;
+      }
+
+      PhaseRecorder comparePhase(_settings._optStats, "compare", file._relativePath());
+      comparePhase.GetStats()._numSymbols = tableA._symbols.GetNumItems()+tableB._symbols.GetNumItems();
+      file._numMatchingSymbols    = RemoveMatchingSymbolsAux(tableA._symbols, tableB._symbols);
+      file._numNonMatchingSymbols = tableA._symbols.GetNumItems();
+
+      Queue<RenamedSymbol> renames;
+      if (_detectRenames) FindRenamedSymbols(tableA._symbols, tableB._symbols, *tableB._lineTable(), renames);
+      file._numRenames = renames.GetNumItems();
+      comparePhase.Finish();
+
+      Queue<ReportEntry> entries;
+      CollectReportEntries(tableA._symbols, tableB._symbols, renames, entries);
+      file._status = entries.HasItems() ? TREE_FILE_CHANGED : TREE_FILE_UNCHANGED;
+      if (entries.HasItems())
+      {
+         // Each file's report goes to a temporary file, so that they can all be concatenated (in path order) at the end
+         PhaseRecorder reportPhase(_settings._optStats, "report", file._relativePath());
+         reportPhase.GetStats()._numSymbols = entries.GetNumItems();
+         file._reportFile = tmpfile();
+         file._jsonFile   = _writeJSON ? tmpfile() : NULL;
+         if ((file._reportFile == NULL)||((_writeJSON)&&(file._jsonFile == NULL))||(WriteReportFiles(pathA(), pathB(), entries, *tableB._lineTable(), file._reportFile, file._jsonFile, numJobs) != B_NO_ERROR)) _progressDisplay.LogMessage(MUSCLE_LOG_ERROR, String("Error writing the diffs report for [%1]").Arg(file._relativePath));
+      }
+      _jobSlots.Release(numJobs);
+
+      _progressDisplay.LogMessage(file._numNonMatchingSymbols ? MUSCLE_LOG_WARNING : MUSCLE_LOG_INFO, String("[%1]:  found %2 matching symbols and %3 non-matching symbols.").Arg(file._relativePath).Arg(file._numMatchingSymbols).Arg(file._numNonMatchingSymbols));
+   }
+
+private:
+   const String _dirA;
+   const String _dirB;
+   Queue<TreeFileComparison> & _files;
+   const ParseSettings _settings;
+   const uint32 _numJobs;
+   JobSlots _jobSlots;
+   const bool _detectRenames;
+   const bool _writeJSON;
+   uint64 _totalBytes;  // the total size of all of the files that may need to be parsed
+};
+
+/** Orders task indices so that the biggest files come first (see TreeComparisonTasks) */
+class CompareTreeFileSizesFunctor
+{
+public:
+   int Compare(const uint32 & idx1, const uint32 & idx2, void * cookie) const
+   {
+      const Queue<TreeFileComparison> & files = *static_cast<const Queue<TreeFileComparison> *>(cookie);
+      return -muscleCompare(files[idx1]._numBytesA+files[idx1]._numBytesB, files[idx2]._numBytesA+files[idx2]._numBytesB);
+   }
+};
+
+/** Copies the rest of (fpIn)'s contents (from the start) to (fpOut).  Returns B_NO_ERROR on success, or B_ERROR on failure. */
+static status_t CopyFileContents(FILE * fpIn, FILE * fpOut)
+{
+   rewind(fpIn);
+   char buf[64*1024];
+   size_t numBytesRead;
+   while((numBytesRead = fread(buf, 1, sizeof(buf), fpIn)) > 0) if (fwrite(buf, 1, numBytesRead, fpOut) != numBytesRead) return B_ERROR;
+   return ferror(fpIn) ? B_ERROR : B_NO_ERROR;
+}
+
+/** Returns a one-line description of how many of (files) changed, e.g. "12 executable files:  3 changed, 9 identical, ..." */
+static String GetTreeSummaryLine(const Queue<TreeFileComparison> & files)
+{
+   uint32 counts[TREE_FILE_PARSE_FAILED+1];
+   memset(counts, 0, sizeof(counts));
+   for (uint32 i=0; i<files.GetNumItems(); i++) counts[files[i]._status]++;
+
+   String ret = String("%1 executable files:  %2 changed, %3 unchanged, %4 identical, %5 only in A, %6 only in B").Arg(files.GetNumItems()).Arg(counts[TREE_FILE_CHANGED]).Arg(counts[TREE_FILE_UNCHANGED]).Arg(counts[TREE_FILE_IDENTICAL]).Arg(counts[TREE_FILE_ONLY_IN_A]).Arg(counts[TREE_FILE_ONLY_IN_B]);
+   if (counts[TREE_FILE_INVALID_IN_A]+counts[TREE_FILE_INVALID_IN_B] > 0) ret += String(", %1 not an executable in A, %2 not an executable in B").Arg(counts[TREE_FILE_INVALID_IN_A]).Arg(counts[TREE_FILE_INVALID_IN_B]);
+   if (counts[TREE_FILE_PARSE_FAILED] > 0) ret += String(", %1 couldn't be disassembled").Arg(counts[TREE_FILE_PARSE_FAILED]);
+   return ret;
+}
+
+/** Writes one line per file of a tree comparison, saying how (or whether) that file changed */
+static void WriteTreeSummary(const char * dirA, const char * dirB, const Queue<TreeFileComparison> & files, FILE * fpOut)
+{
+   fprintf(fpOut, "Tree A:  %s\nTree B:  %s\n", dirA, dirB);
+   fprintf(fpOut, "%s\n\n", GetTreeSummaryLine(files)());
+
+   for (uint32 i=0; i<files.GetNumItems(); i++)
+   {
+      const TreeFileComparison & f = files[i];
+      switch(f._status)
+      {
+         case TREE_FILE_IDENTICAL: fprintf(fpOut, "identical  %s\n", f._relativePath()); break;
+         case TREE_FILE_ONLY_IN_A: fprintf(fpOut, "only in A  %s\n", f._relativePath()); break;
+         case TREE_FILE_ONLY_IN_B: fprintf(fpOut, "only in B  %s\n", f._relativePath()); break;
+         case TREE_FILE_INVALID_IN_A: fprintf(fpOut, "changed    %s  (not an executable in A)\n", f._relativePath()); break;
+         case TREE_FILE_INVALID_IN_B: fprintf(fpOut, "changed    %s  (not an executable in B)\n", f._relativePath()); break;
+         case TREE_FILE_PARSE_FAILED: fprintf(fpOut, "error      %s  (unable to disassemble it)\n", f._relativePath()); break;
+
+         default:
+            fprintf(fpOut, "%s  %s  (" UINT32_FORMAT_SPEC " matching, " UINT32_FORMAT_SPEC " non-matching symbols", (f._status == TREE_FILE_CHANGED) ? "changed  " : "unchanged", f._relativePath(), f._numMatchingSymbols, f._numNonMatchingSymbols);
+            if (f._numRenames > 0) fprintf(fpOut, ", " UINT32_FORMAT_SPEC " renamed", f._numRenames);
+            fprintf(fpOut, ")\n");
+         break;
+      }
+   }
+}
+
+/** Tree mode:  compares each executable file under (dirA) against the file with the same relative path under (dirB), several at once,
+  * then writes one combined diffs report and a summary of every file.  (totalPhase) is finished just before the stats file (if any) is written.
+  */
+static int CompareTrees(const String & dirA, const String & dirB, const ParseSettings & settings, uint32 numJobs, bool detectRenames, bool writeJSON, PhaseRecorder & totalPhase)
+{
+   Hashtable<String, uint64> filesA, filesB;
+   CollectRegularFiles(dirA, GetEmptyString(), filesA);
+   CollectRegularFiles(dirB, GetEmptyString(), filesB);
+
+   Hashtable<String, Void> allPaths;
+   for (HashtableIterator<String, uint64> iter(filesA); iter.HasData(); iter++) (void) allPaths.PutWithDefault(iter.GetKey());
+   for (HashtableIterator<String, uint64> iter(filesB); iter.HasData(); iter++) (void) allPaths.PutWithDefault(iter.GetKey());
+   allPaths.SortByKey();
+
+   // The files are paired up by path first, and only then classified, so that e.g. a truncated executable shows up as
+   // a change rather than as an executable that is only present in the other tree
+   Queue<TreeFileComparison> files;
+   Queue<uint32> taskIndices;
+   uint32 numExecutablesA = 0, numExecutablesB = 0;
+   for (HashtableIterator<String, Void> iter(allPaths); iter.HasData(); iter++)
+   {
+      TreeFileComparison f;
+      f._relativePath = iter.GetKey();
+      const uint64 * sizeA = filesA.Get(f._relativePath);
+      const uint64 * sizeB = filesB.Get(f._relativePath);
+      const bool isExecutableA = ((sizeA)&&(IsExecutableFile((dirA + "/" + f._relativePath)())));
+      const bool isExecutableB = ((sizeB)&&(IsExecutableFile((dirB + "/" + f._relativePath)())));
+      if ((isExecutableA == false)&&(isExecutableB == false)) continue;  // not an executable in either tree, so not our concern
+
+      if (isExecutableA) numExecutablesA++;
+      if (isExecutableB) numExecutablesB++;
+      if (sizeA) f._numBytesA = *sizeA;
+      if (sizeB) f._numBytesB = *sizeB;
+           if (sizeA == NULL)            f._status = TREE_FILE_ONLY_IN_B;
+      else if (sizeB == NULL)            f._status = TREE_FILE_ONLY_IN_A;
+      else if (isExecutableA == false)   f._status = TREE_FILE_INVALID_IN_A;
+      else if (isExecutableB == false)   f._status = TREE_FILE_INVALID_IN_B;
+      else
+      {
+         f._status = TREE_FILE_UNCHANGED;
+         if (taskIndices.AddTail(files.GetNumItems()) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+      }
+      if ((f._status == TREE_FILE_INVALID_IN_A)||(f._status == TREE_FILE_INVALID_IN_B)) LogTime(MUSCLE_LOG_WARNING, "[%s] is not an executable file in tree %c, so it can't be compared.\n", f._relativePath(), (f._status == TREE_FILE_INVALID_IN_A) ? 'A' : 'B');
+      if (files.AddTail(f) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+   }
+   LogTime(MUSCLE_LOG_INFO, "Found " UINT32_FORMAT_SPEC " executable files in [%s] and " UINT32_FORMAT_SPEC " in [%s]; comparing the " UINT32_FORMAT_SPEC " that are in both.\n", numExecutablesA, dirA(), numExecutablesB, dirB(), taskIndices.GetNumItems());
+
+   // Largest files first, so that the smaller ones can fill in around them at the end
+   taskIndices.Sort(CompareTreeFileSizesFunctor(), 0, MUSCLE_NO_LIMIT, &files);
+   TreeComparisonTasks tasks(dirA, dirB, files, settings, muscleMax(numJobs, (uint32)1), detectRenames, writeJSON);
+   WorkStealingExecutor(tasks).ExecuteTasks(taskIndices, numJobs);
+
+   printf("\n");
+   printf("-------------------------------------------------------------\n");
+   printf("\n");
+
+   LogTime(MUSCLE_LOG_INFO, "%s\n", GetTreeSummaryLine(files)());
+
+   const String timestamp = GetFileNameTimestamp();
+   const String reportFileName = String("executable_diffs_report_") + timestamp + ".txt";
+   const String jsonFileName   = String("executable_diffs_report_") + timestamp + ".jsonl";
+   FILE * fpOut  = fopen(reportFileName(), "w");
+   FILE * fpJSON = writeJSON ? fopen(jsonFileName(), "w") : NULL;
+   if (fpOut == NULL) LogTime(MUSCLE_LOG_ERROR, "Unable to write diffs report file [%s]\n", reportFileName());
+   if ((writeJSON)&&(fpJSON == NULL)) LogTime(MUSCLE_LOG_ERROR, "Unable to write JSON report file [%s]\n", jsonFileName());
+
+   bool reportOK = true;
+   for (uint32 i=0; i<files.GetNumItems(); i++)
+   {
+      TreeFileComparison & f = files[i];
+      if (f._status != TREE_FILE_CHANGED) continue;
+
+      if ((fpOut)&&(f._reportFile))
+      {
+         fprintf(fpOut, "\n\n##################### [%s]\n", f._relativePath());
+         if (CopyFileContents(f._reportFile, fpOut) != B_NO_ERROR) reportOK = false;
+      }
+      if ((fpJSON)&&(f._jsonFile)&&(CopyFileContents(f._jsonFile, fpJSON) != B_NO_ERROR)) reportOK = false;
+      if (f._reportFile) fclose(f._reportFile);
+      if (f._jsonFile)   fclose(f._jsonFile);
+      f._reportFile = f._jsonFile = NULL;
+   }
+   if (reportOK == false) LogTime(MUSCLE_LOG_ERROR, "Error writing the diffs report!\n");
+   if (fpOut)
+   {
+      fclose(fpOut);
+      LogTime(MUSCLE_LOG_INFO, "Diffs report written to file [%s]\n", reportFileName());
+   }
+   if (fpJSON)
+   {
+      fclose(fpJSON);
+      LogTime(MUSCLE_LOG_INFO, "JSON diffs report written to file [%s]\n", jsonFileName());
+   }
+
+   const String summaryFileName = String("executable_diffs_summary_%1.txt").Arg(timestamp);
+   FILE * fpSummary = fopen(summaryFileName(), "w");
+   if (fpSummary)
+   {
+      WriteTreeSummary(dirA(), dirB(), files, fpSummary);
+      fclose(fpSummary);
+      LogTime(MUSCLE_LOG_INFO, "Summary of all " UINT32_FORMAT_SPEC " executable files written to file [%s]\n", files.GetNumItems(), summaryFileName());
+   }
+   else LogTime(MUSCLE_LOG_ERROR, "Unable to write summary file [%s]\n", summaryFileName());
+
+   if (settings._optStats)
+   {
+      totalPhase.Finish();
+
+      Queue<String> trees;
+      (void) trees.AddTail(dirA);
+      (void) trees.AddTail(dirB);
+      WriteStatsFile(*settings._optStats, timestamp, trees);
+   }
+
+   for (uint32 i=0; i<files.GetNumItems(); i++) if (files[i]._status == TREE_FILE_PARSE_FAILED) return 10;
+   return 0;
+}
+
+enum {
+   QUICK_EXIT_EQUIVALENT = 0,  // --quick's exit status when the executables are equivalent
+   QUICK_EXIT_DIFFERENT  = 1,  // --quick's exit status when they differ (any error exits with 10, as usual)
+   QUICK_FIRST_BATCH_SIZE = 16 // how many functions --quick disassembles first; each batch after that is four times bigger than the last
+};
+
+/** Returns true iff (tableA) and (tableB) contain the same symbols with the same text.  Stops at the first symbol that
+  * doesn't match, and sets (retSymbolName) to its name.
+  */
+static bool AreSymbolTablesEquivalent(const Hashtable<String, SymbolRecord> & tableA, const Hashtable<String, SymbolRecord> & tableB, String & retSymbolName)
+{
+   for (HashtableIterator<String, SymbolRecord> iter(tableA); iter.HasData(); iter++)
+   {
+      const SymbolRecord * valB = tableB.Get(iter.GetKey());
+      if ((valB == NULL)||(valB->HasSameTextAs(iter.GetValue()) == false))
+      {
+         retSymbolName = iter.GetKey();
+         return false;
+      }
+   }
+   for (HashtableIterator<String, SymbolRecord> iter(tableB); iter.HasData(); iter++)
+   {
+      if (tableA.ContainsKey(iter.GetKey()) == false)
+      {
+         retSymbolName = iter.GetKey();
+         return false;
+      }
+   }
+   return true;
+}
+
+/** Parses (fileA) and (fileB) at once (into a new LineTable that they share), and then compares their symbol tables (see AreSymbolTablesEquivalent()).
+  * Returns QUICK_EXIT_EQUIVALENT, QUICK_EXIT_DIFFERENT, or 10 if either executable couldn't be disassembled (or yielded no symbols at all).
+  */
+static int ParseAndCheckEquivalence(const char * fileA, ParseSettings settingsA, const char * fileB, ParseSettings settingsB, String & retSymbolName)
+{
+   settingsA._lineTable = settingsB._lineTable = LineTableRef(newnothrow LineTable);
+   if (settingsA._lineTable() == NULL) WARN_OUT_OF_MEMORY;
+
+   ParseExecutableThread parseA(fileA, "A", settingsA);
+   parseA.Start();
+   ParseExecutableThread parseB(fileB, "B", settingsB);
+   parseB.Start();
+   const Hashtable<String, SymbolRecord> & tableA = parseA.GetResults()._symbols;
+   const Hashtable<String, SymbolRecord> & tableB = parseB.GetResults()._symbols;
+   for (uint32 i=0; i<2; i++)
+   {
+      ParseExecutableThread & parse = (i == 0) ? parseA : parseB;
+      if ((parse.GetStatus() != B_NO_ERROR)||(parse.GetResults()._symbols.IsEmpty()))
+      {
+         LogTime(MUSCLE_LOG_ERROR, "Unable to disassemble [%s], so its equivalence can't be checked.\n", (i == 0) ? fileA : fileB);
+         return 10;
+      }
+   }
+
+   PhaseRecorder comparePhase(settingsA._optStats, "compare");
+   comparePhase.GetStats()._numSymbols = tableA.GetNumItems()+tableB.GetNumItems();
+   return AreSymbolTablesEquivalent(tableA, tableB, retSymbolName) ? QUICK_EXIT_EQUIVALENT : QUICK_EXIT_DIFFERENT;
+}
+
+#ifndef __APPLE__
+/** Returns true iff (section)'s contents can affect the sanitized disassembly.  Notes (e.g. .note.gnu.build-id, which changes
+  * with every build) and the sections that don't get loaded (e.g. .debug_info and .comment) can't, except for the symbol
+  * tables, string tables and relocations.
+  */
+static bool CanSectionAffectDisassembly(const ElfSection & section)
+{
+   if (section._type == SHT_NOTE) return false;
+   if (section._flags & SHF_ALLOC) return true;
+   return ((section._type == SHT_SYMTAB)||(section._type == SHT_STRTAB)||(section._type == SHT_REL)||(section._type == SHT_RELA));
+}
+
+/** Returns true iff every section of (fileA) that can affect its sanitized disassembly has the same name, type, flags,
+  * address, size and contents as the corresponding section of (fileB), in which case their disassemblies are identical too.
+  */
+static bool AreRelevantSectionsIdentical(const ElfFile & fileA, const ElfFile & fileB)
+{
+   Queue<const ElfSection *> sectionsA, sectionsB;
+   for (uint32 i=0; i<fileA.GetSections().GetNumItems(); i++) if (CanSectionAffectDisassembly(fileA.GetSections()[i])) (void) sectionsA.AddTail(&fileA.GetSections()[i]);
+   for (uint32 i=0; i<fileB.GetSections().GetNumItems(); i++) if (CanSectionAffectDisassembly(fileB.GetSections()[i])) (void) sectionsB.AddTail(&fileB.GetSections()[i]);
+   if ((fileA.GetMachine() != fileB.GetMachine())||(sectionsA.GetNumItems() != sectionsB.GetNumItems())) return false;
+
+   for (uint32 i=0; i<sectionsA.GetNumItems(); i++)
+   {
+      const ElfSection & a = *sectionsA[i];
+      const ElfSection & b = *sectionsB[i];
+      if ((a._name != b._name)||(a._type != b._type)||(a._flags != b._flags)||(a._address != b._address)||(a._numBytes != b._numBytes)) return false;
+
+      const uint8 * dataA = fileA.GetSectionData(a);
+      const uint8 * dataB = fileB.GetSectionData(b);
+      if ((dataA == NULL) != (dataB == NULL)) return false;
+      if ((dataA)&&(memcmp(dataA, dataB, (size_t) a._numBytes) != 0)) return false;
+   }
+   return true;
+}
+
+/** Returns true iff the x86 instruction (insn) at (p) is padding:  a nop (possibly a multi-byte one, e.g. the "data16 cs nopw" that
+  * compilers use to align the next function), an int3, or a zero byte.
+  */
+static bool IsPaddingInstruction(const uint8 * p, const X86Instruction & insn)
+{
+   if ((p[0] == 0x00)||(p[0] == 0xCC)) return true;
+
+   uint32 i = 0;
+   while((i < insn._length)&&((p[i] == 0x66)||(p[i] == 0x2E))) i++;  // operand-size and CS-segment prefixes
+   if ((i < insn._length)&&(p[i] == 0x90)) return true;
+   return (((i+1) < insn._length)&&(p[i] == 0x0F)&&(p[i+1] == 0x1F));
+}
+
+/** Returns a SymbolRecord that covers the (numBytes) bytes of code starting at (startAddress), e.g. for AreFunctionsEquivalent() */
+static SymbolRecord GetCodeRange(uint64 startAddress, uint64 numBytes)
+{
+   SymbolRecord ret;
+   ret._startAddress = startAddress;
+   ret._length       = numBytes;
+   return ret;
+}
+
+/** Adds to (retRuns) each run of code in (image)'s executable sections that isn't covered by any of its function-symbols (e.g.
+  * .init, the PLT stubs, or the code of symbols that have no size), in address order, minus any padding at either end of the
+  * run.  Runs that are nothing but padding (e.g. the gaps that align each function) are skipped.  If a run can't be decoded,
+  * it is added in full.
+  */
+static void GetUncoveredCodeRuns(const PrefilterImage & image, Queue<SymbolRecord> & retRuns)
+{
+   const ElfFile & elfFile = image.GetElfFile();
+   const Queue<ElfSection> & sections = elfFile.GetSections();
+   for (uint32 i=0; i<sections.GetNumItems(); i++)
+   {
+      const ElfSection & s = sections[i];
+      if (((s._flags & (SHF_ALLOC|SHF_EXECINSTR)) != (SHF_ALLOC|SHF_EXECINSTR))||(s._numBytes == 0)) continue;
+
+      const uint64 sectionEnd = s._address+s._numBytes;
+      Queue<SymbolRecord> gaps;
+      uint64 coveredUpTo = s._address;
+      for (HashtableIterator<String, SymbolRecord> iter(image.GetFunctions()); iter.HasData(); iter++)  // (sorted by address)
+      {
+         const SymbolRecord & func = iter.GetValue();
+         if ((func._startAddress+func._length <= coveredUpTo)||(func._startAddress >= sectionEnd)) continue;
+         if (func._startAddress > coveredUpTo) (void) gaps.AddTail(GetCodeRange(coveredUpTo, func._startAddress-coveredUpTo));
+         coveredUpTo = muscleMin(func._startAddress+func._length, sectionEnd);
+      }
+      if (coveredUpTo < sectionEnd) (void) gaps.AddTail(GetCodeRange(coveredUpTo, sectionEnd-coveredUpTo));
+
+      for (uint32 j=0; j<gaps.GetNumItems(); j++)
+      {
+         const SymbolRecord & gap = gaps[j];
+         const uint8 * bytes = elfFile.GetCodeBytes(gap._startAddress, gap._length);
+         if (bytes == NULL) continue;  // (e.g. a section with no bytes in the file)
+
+         uint64 codeStart = gap._length, codeEnd = 0;
+         X86Instruction insn;
+         uint64 offset = 0;
+         for (; offset<gap._length; offset+=insn._length)
+         {
+            if (DecodeX86Instruction(bytes+offset, gap._length-offset, elfFile.Is64Bit(), insn) != B_NO_ERROR)
+            {
+               if ((bytes[offset] != 0x00)&&(bytes[offset] != 0xCC)) break;
+               insn._length = 1;  // zero-fill or int3s that don't form whole instructions
+            }
+            else if (IsPaddingInstruction(bytes+offset, insn)) continue;
+
+            codeStart = muscleMin(codeStart, offset);
+            codeEnd   = offset+insn._length;
+         }
+         if (offset < gap._length) {codeStart = 0; codeEnd = gap._length;}  // undecodable, so it all gets compared
+
+         if ((codeStart < codeEnd)&&(retRuns.AddTail(GetCodeRange(gap._startAddress+codeStart, codeEnd-codeStart)) != B_NO_ERROR)) WARN_OUT_OF_MEMORY;
+      }
+   }
+}
+
+/** Returns true iff the code in (imageA)'s executable sections that isn't covered by any function-symbol is equivalent to the
+  * uncovered code in (imageB)'s (see GetUncoveredCodeRuns() and AreFunctionsEquivalent()).  The prefilter only compares
+  * functions, so without this, a change to e.g. .init or to a hand-written assembly routine would go unnoticed by --quick.
+  */
+static bool IsUncoveredCodeEquivalent(const PrefilterImage & imageA, const PrefilterImage & imageB)
+{
+   Queue<SymbolRecord> runsA, runsB;
+   GetUncoveredCodeRuns(imageA, runsA);
+   GetUncoveredCodeRuns(imageB, runsB);
+   if (runsA.GetNumItems() != runsB.GetNumItems()) return false;
+
+   const Queue<ElfSection> & sectionsA = imageA.GetElfFile().GetSections();
+   const Queue<ElfSection> & sectionsB = imageB.GetElfFile().GetSections();
+   for (uint32 i=0; i<runsA.GetNumItems(); i++)
+   {
+      const int32 sectionIdxA = imageA.GetElfFile().GetExecutableSectionIndex(runsA[i]._startAddress);
+      const int32 sectionIdxB = imageB.GetElfFile().GetExecutableSectionIndex(runsB[i]._startAddress);
+      if ((sectionIdxA < 0)||(sectionIdxB < 0)||(sectionsA[sectionIdxA]._name != sectionsB[sectionIdxB]._name)) return false;
+      if (AreFunctionsEquivalent(imageA, runsA[i], imageB, runsB[i]) == false) return false;
+   }
+   return true;
+}
+
+/** Disassembles and compares the functions in (targetsA) and (targetsB) (which mustn't include any functions that are present in only one
+  * of the executables) a batch at a time, smallest batch first, so that a difference near the start can be reported without
+  * disassembling the rest.  Returns QUICK_EXIT_EQUIVALENT, QUICK_EXIT_DIFFERENT, or 10 if either side of a batch couldn't be disassembled,
+  * like ParseAndCheckEquivalence().
+  */
+static int CheckTargetsEquivalence(const char * fileA, const DisassemblyTargets & targetsA, const char * fileB, const DisassemblyTargets & targetsB, const ParseSettings & settings, String & retSymbolName)
+{
+   Queue<const String *> names;
+   for (HashtableIterator<uint64, String> iter(targetsA._functions); iter.HasData(); iter++) (void) names.AddTail(&iter.GetValue());
+
+   uint32 batchSize = QUICK_FIRST_BATCH_SIZE;
+   for (uint32 batchStart=0; batchStart<names.GetNumItems(); batchStart+=batchSize, batchSize*=4)
+   {
+      DisassemblyTargets batchA, batchB;
+      batchA._image = targetsA._image;
+      batchB._image = targetsB._image;
+
+      const uint32 batchEnd = muscleMin(batchStart+batchSize, names.GetNumItems());
+      for (uint32 i=batchStart; i<batchEnd; i++)
+      {
+         const String & name = *names[i];
+         const SymbolRecord * funcB = targetsB._image->GetFunctions().Get(name);
+         (void) batchA._functions.Put(targetsA._image->GetFunctions().Get(name)->_startAddress, name);
+         if (funcB) (void) batchB._functions.Put(funcB->_startAddress, name);
+      }
+      batchA._functions.SortByKey();
+      batchB._functions.SortByKey();
+      _progressDisplay.LogMessage(MUSCLE_LOG_INFO, String("Disassembling functions %1-%2 of %3...").Arg(batchStart+1).Arg(batchEnd).Arg(names.GetNumItems()));
+
+      ParseSettings settingsA = settings;
+      ParseSettings settingsB = settings;
+      settingsA._optTargets = &batchA;
+      settingsB._optTargets = &batchB;
+      const int ret = ParseAndCheckEquivalence(fileA, settingsA, fileB, settingsB, retSymbolName);
+      if (ret != QUICK_EXIT_EQUIVALENT) return ret;
+   }
+   return QUICK_EXIT_EQUIVALENT;
+}
+#endif
+
+/** Decides whether (fileA) and (fileB) are equivalent (see --quick), doing as little work as possible:  files with identical
+  * contents (or, for ELF files, identical code, data and symbol table sections) are equivalent without any disassembly.
+  * Otherwise the prefilter compares each pair of same-named functions' machine code; a function that is present in only one
+  * of the executables is a difference, and only the functions whose machine code differs get disassembled and sanitized.
+  * Returns QUICK_EXIT_EQUIVALENT, QUICK_EXIT_DIFFERENT, or 10 on error.
+  */
+static int CheckEquivalence(const char * fileA, const char * fileB, const ParseSettings & settings, uint32 numJobs, PhaseRecorder & totalPhase)
+{
+   if ((FilePathInfo(fileA).IsRegularFile() == false)||(FilePathInfo(fileB).IsRegularFile() == false))
+   {
+      LogTime(MUSCLE_LOG_ERROR, "Unable to read executable [%s] or [%s]\n", fileA, fileB);
+      return 10;
+   }
+
+   String reason;
+   int ret = 10;  // i.e. not decided yet
+   bool disassemblyFailed = false;
+   if (AreFilesIdentical(fileA, fileB))
+   {
+      ret    = QUICK_EXIT_EQUIVALENT;
+      reason = "their contents are identical";
+   }
+
+#ifndef __APPLE__
+   if (ret == 10)
+   {
+      ElfFile elfA, elfB;
+      if ((elfA.Open(fileA) == B_NO_ERROR)&&(elfB.Open(fileB) == B_NO_ERROR)&&(AreRelevantSectionsIdentical(elfA, elfB)))
+      {
+         ret    = QUICK_EXIT_EQUIVALENT;
+         reason = "their code, data and symbol table sections are identical";
+      }
+   }
+
+   PrefilterImage imageA, imageB;
+   if ((ret == 10)&&(OpenPrefilterImages(fileA, imageA, fileB, imageB) == B_NO_ERROR))
+   {
+      String unpairedName;
+      const char * unpairedFile = NULL;
+      for (HashtableIterator<String, SymbolRecord> iter(imageA.GetFunctions()); (unpairedFile == NULL)&&(iter.HasData()); iter++) if (imageB.GetFunctions().ContainsKey(iter.GetKey()) == false) {unpairedName = iter.GetKey(); unpairedFile = fileA;}
+      for (HashtableIterator<String, SymbolRecord> iter(imageB.GetFunctions()); (unpairedFile == NULL)&&(iter.HasData()); iter++) if (imageA.GetFunctions().ContainsKey(iter.GetKey()) == false) {unpairedName = iter.GetKey(); unpairedFile = fileB;}
+      if (unpairedFile)
+      {
+         ret    = QUICK_EXIT_DIFFERENT;
+         reason = String("function [%1] is present only in [%2]").Arg(unpairedName).Arg(unpairedFile);
+      }
+      else
+      {
+         DisassemblyTargets targetsA, targetsB;
+         uint32 numMatches = 0;
+         {
+            PhaseRecorder prefilterPhase(settings._optStats, "prefilter");
+            prefilterPhase.GetStats()._numSymbols = imageA.GetFunctions().GetNumItems()+imageB.GetFunctions().GetNumItems();
+            PrefilterExecutables(imageA, targetsA, imageB, targetsB, muscleMax(numJobs, (uint32)1), numMatches);
+         }
+
+         String symbolName;
+         ret = CheckTargetsEquivalence(fileA, targetsA, fileB, targetsB, settings, symbolName);
+         if (ret == QUICK_EXIT_DIFFERENT) reason = String("symbol [%1] differs").Arg(symbolName);
+         else if (ret != QUICK_EXIT_EQUIVALENT) disassemblyFailed = true;
+         else if (IsUncoveredCodeEquivalent(imageA, imageB) == false)
+         {
+            // Something outside of the functions (e.g. .init, or an assembly routine with no symbol size) differs, and only the full disassembly can tell whether it matters
+            LogTime(MUSCLE_LOG_INFO, "Some of the machine code that isn't part of any function differs, so everything needs to be disassembled after all.\n");
+            ret = 10;
+         }
+         else if (targetsA._functions.IsEmpty()) reason = String("the machine code of all %1 of their functions (and of the code outside of them) is equivalent").Arg(numMatches);
+         else reason = String("the machine code of %1 of their %2 functions (and of the code outside of them) is equivalent, and the other %3 are equivalent once sanitized").Arg(numMatches).Arg(numMatches+targetsA._functions.GetNumItems()).Arg(targetsA._functions.GetNumItems());
+      }
+   }
+   else if (ret == 10) LogTime(MUSCLE_LOG_WARNING, "Unable to compare the machine code of [%s] and [%s] directly, disassembling everything instead.\n", fileA, fileB);
+#endif
+
+   if ((ret == 10)&&(disassemblyFailed == false))
+   {
+      String symbolName;
+      ret = ParseAndCheckEquivalence(fileA, settings, fileB, settings, symbolName);
+      if (ret == QUICK_EXIT_EQUIVALENT) reason = "their sanitized disassemblies are identical";
+      else if (ret == QUICK_EXIT_DIFFERENT) reason = String("symbol [%1] differs").Arg(symbolName);
+   }
+
+   printf("\n");
+   switch(ret)
+   {
+      case QUICK_EXIT_EQUIVALENT: LogTime(MUSCLE_LOG_INFO,  "Executables [%s] and [%s] are equivalent:  %s.\n", fileA, fileB, reason()); break;
+      case QUICK_EXIT_DIFFERENT:  LogTime(MUSCLE_LOG_INFO,  "Executables [%s] and [%s] differ:  %s.\n",         fileA, fileB, reason()); break;
+      default:                    LogTime(MUSCLE_LOG_ERROR, "Unable to disassemble [%s] or [%s]\n",              fileA, fileB);           break;
+   }
+
+   if (settings._optStats)
+   {
+      totalPhase.Finish();
+
+      Queue<String> executables;
+      (void) executables.AddTail(fileA);
+      (void) executables.AddTail(fileB);
+      WriteStatsFile(*settings._optStats, GetFileNameTimestamp(), executables);
+   }
+
+   return ret;
+}
+
+enum {
+   DEFAULT_DIFF_SERVER_MEMORY_MB = 4096    // how much memory --server may use to keep symbol tables warm, if --server-memory isn't specified
+};
+
+/** What-codes of the Messages that --client sends to --server, and vice versa.
+  *
+  * A DIFF_SERVER_COMMAND_COMPARE Message contains:
+  *    "a", "b"            (String) the absolute paths of the two executables to compare
+  *    "a_name", "b_name"  (String) the executables' names as the user gave them, for use in the reports
+  *    "renames"           (bool)   true iff renamed symbols should be detected (see --no-renames)
+  *    "json"              (bool)   true iff a JSON report should be generated too (see --json)
+  *
+  * The DIFF_SERVER_REPLY_COMPARE Message that comes back contains either an "error" String, or:
+  *    "matching", "nonmatching", "renames"  (int32) the counts that the summary line reports
+  *    "entry_type", "entry_a", "entry_b", "entry_similarity"  (int32, String, String, int32) one value each per ReportEntry, in report order
+  *    "report", "json"    (B_RAW_TYPE) the contents of the text and JSON report files ("json" only if it was requested)
+  */
+enum {
+   DIFF_SERVER_COMMAND_COMPARE = 'edCm',
+   DIFF_SERVER_REPLY_COMPARE   = 'edRc'
+};
+
+/** Sets (retID) to a String that identifies the current version of the file at (path), based on its device, inode, size and
+  * modification time, so that a rebuilt executable gets a new ID without our having to read its contents.
+  * Returns B_NO_ERROR on success, or B_ERROR if the file couldn't be stat()'d.
+  */
+static status_t GetExecutableFileID(const char * path, String & retID)
+{
+   struct stat st;
+   if (stat(path, &st) != 0) return B_ERROR;
+#ifdef __APPLE__
+   const uint64 modTimeNanos = (((uint64)st.st_mtimespec.tv_sec)*1000000000)+st.st_mtimespec.tv_nsec;
+#else
+   const uint64 modTimeNanos = (((uint64)st.st_mtim.tv_sec)*1000000000)+st.st_mtim.tv_nsec;
+#endif
+   retID = String("%1:%2:%3:%4").Arg((uint64)st.st_dev).Arg((uint64)st.st_ino).Arg((uint64)st.st_size).Arg(modTimeNanos);
+   return B_NO_ERROR;
+}
+
+/** Returns a rough estimate of how many bytes of memory (table) is using, including its line dictionary (see LineTable) */
+static uint64 EstimateSymbolTableMemoryUsage(const SymbolTable & table)
+{
+   uint64 ret = table._lineTable() ? table._lineTable()->GetNumBytesAllocated() : 0;
+   for (HashtableIterator<String, SymbolRecord> iter(table._symbols); iter.HasData(); iter++) ret += sizeof(String)+sizeof(SymbolRecord)+32+iter.GetKey().Length();  // 32 for the hashtable's own per-entry overhead
+   for (uint32 i=0; i<table._textArenas.GetNumItems(); i++) if (table._textArenas[i]()) ret += table._textArenas[i]()->GetNumBytesAllocated();
+   return ret;
+}
+
+/** Sets (retTable) to a copy of (table) whose line IDs refer to (lineTable) instead, adding (table)'s lines to (lineTable) as necessary.
+  * This lets two executables that were parsed into separate LineTables (e.g. two warm tables; see DiffServer) be compared, by making
+  * (lineTable) an overlay of one's LineTable and copying the other into it.  Returns B_NO_ERROR on success, or B_ERROR if out of memory.
+  */
+static status_t CopySymbolTableIntoLineTable(const SymbolTable & table, const LineTableRef & lineTable, SymbolTable & retTable)
+{
+   TextArenaRef arena(newnothrow TextArena);
+   if ((lineTable() == NULL)||(arena() == NULL)||(retTable._textArenas.AddTail(arena) != B_NO_ERROR)||(retTable._symbols.EnsureSize(table._symbols.GetNumItems()) != B_NO_ERROR)) return B_ERROR;
+   retTable._lineTable = lineTable;
+
+   Hashtable<uint32, uint32> newLineIDs;  // (table)'s line ID -> (lineTable)'s line ID, so that each distinct line only has to be looked up once
+   LineIDCache * lineIDCache = newnothrow LineIDCache;  // (too big to go on the stack)
+   if (lineIDCache == NULL) return B_ERROR;
+
+   status_t ret = B_NO_ERROR;
+   for (HashtableIterator<String, SymbolRecord> iter(table._symbols); ((ret == B_NO_ERROR)&&(iter.HasData())); iter++)
+   {
+      const SymbolRecord & rec = iter.GetValue();
+      arena()->BeginSpan();
+      for (uint32 i=0; ((ret == B_NO_ERROR)&&(i<rec._lines._numLines)); i++)
+      {
+         const uint32 oldID = rec._lines._ids[i];
+         const uint32 * newID = newLineIDs.Get(oldID);
+         if (newID == NULL)
+         {
+            const TextSpan line = table._lineTable()->GetLine(oldID);
+            newID = newLineIDs.PutAndGet(oldID, lineTable()->GetLineID(line._chars, line._length, lineIDCache));
+         }
+         ret = newID ? AppendLineID(*newID, *arena()) : B_ERROR;
+      }
+
+      SymbolRecord newRec = rec;
+      newRec._lines = LineIDSpan(arena()->EndSpan());
+      newRec.UpdateLinesHash();
+      if ((ret == B_NO_ERROR)&&(retTable._symbols.Put(iter.GetKey(), newRec) != B_NO_ERROR)) ret = B_ERROR;
+   }
+   delete lineIDCache;
+   return ret;
+}
+
+/** A parsed executable that the diff server is keeping in memory, so that it doesn't have to be parsed again */
+class WarmSymbolTable : public RefCountable
+{
+public:
+   WarmSymbolTable(const String & fileID) : _fileID(fileID), _numBytes(0), _parseStatus(B_NO_ERROR) {/* empty */}
+
+   const String _fileID;  // which version of the executable (_table) was parsed from (see GetExecutableFileID())
+   SymbolTable _table;
+   uint64 _numBytes;      // estimated memory usage of (_table)
+   status_t _parseStatus; // B_ERROR if the disassembler failed, in which case (_table) may be incomplete
+};
+DECLARE_REFTYPES(WarmSymbolTable);
+
+/** Keeps the symbol tables of the most recently used executables in memory, dropping the least recently used ones whenever
+  * the tables' total estimated size exceeds the memory budget.  It is thread-safe, since each client's requests are handled
+  * in a thread of its own (see DiffServerConnectionThread).
+  */
+class WarmSymbolTableCache
+{
+public:
+   WarmSymbolTableCache(uint64 maxBytes) : _maxBytes(maxBytes), _numBytes(0) {/* empty */}
+
+   /** Returns the warm symbol table of the executable at (path) and marks it as the most recently used one, or returns a NULL
+     * reference if there isn't one for (fileID), i.e. for the executable's current version.
+     */
+   WarmSymbolTableRef Get(const String & path, const String & fileID)
+   {
+      MutexGuard mg(_mutex);
+      const WarmSymbolTableRef * t = _tables.Get(path);
+      if (t == NULL) return WarmSymbolTableRef();
+
+      const WarmSymbolTableRef ret = *t;
+      if (ret()->_fileID != fileID)
+      {
+         Remove(path);  // the executable has been rebuilt since we parsed it
+         return WarmSymbolTableRef();
+      }
+      (void) _tables.MoveToBack(path);
+      return ret;
+   }
+
+   /** Adds (table) as the most recently used table, replacing any table that (path) had before */
+   void Put(const String & path, const WarmSymbolTableRef & table)
+   {
+      MutexGuard mg(_mutex);
+      Remove(path);
+      if (_tables.Put(path, table) == B_NO_ERROR) _numBytes += table()->_numBytes;
+                                             else WARN_OUT_OF_MEMORY;
+   }
+
+   /** Drops the least recently used tables until the remaining ones fit into our memory budget.  (Anyone still holding a reference to a dropped table can keep using it, of course) */
+   void EvictAsNecessary()
+   {
+      MutexGuard mg(_mutex);
+      while((_numBytes > _maxBytes)&&(_tables.HasItems()))
+      {
+         const String path = *_tables.GetFirstKey();
+         const uint64 numBytes = (*_tables.GetFirstValue())()->_numBytes;
+         Remove(path);
+         LogTime(MUSCLE_LOG_INFO, "Evicted the symbol table of [%s] (" UINT64_FORMAT_SPEC " MB) to stay within the memory budget.\n", path(), numBytes/(1024*1024));
+      }
+   }
+
+   uint32 GetNumTables() const {MutexGuard mg(_mutex); return _tables.GetNumItems();}
+   uint64 GetNumBytes()  const {MutexGuard mg(_mutex); return _numBytes;}
+
+private:
+   void Remove(const String & path)
+   {
+      WarmSymbolTableRef t;
+      if (_tables.Remove(path, t) == B_NO_ERROR) _numBytes -= t()->_numBytes;
+   }
+
+   Mutex _mutex;
+   const uint64 _maxBytes;
+   uint64 _numBytes;
+   Hashtable<String, WarmSymbolTableRef> _tables;  // path -> table, in least-recently-used-first order
+};
+
+/** Parses each of several executables into its own WarmSymbolTable; there is one task per executable */
+class ParseWarmTablesTasks : public AbstractParallelTasks
+{
+public:
+   ParseWarmTablesTasks(const Queue<String> & paths, const Queue<String> & labels, const Queue<WarmSymbolTableRef> & tables, const ParseSettings & settings, JobSlots & jobSlots) : _paths(paths), _labels(labels), _tables(tables), _settings(settings), _jobSlots(jobSlots) {/* empty */}
+
+   virtual void ExecuteTask(uint32 taskIdx, uint32 /*workerIdx*/)
+   {
+      WarmSymbolTable * t = _tables[taskIdx]();
+      _jobSlots.Acquire(_settings._numDisassemblyJobs);
+      t->_parseStatus = ParseExecutableFile(_paths[taskIdx](), _labels[taskIdx](), _settings, t->_table);
+      _jobSlots.Release(_settings._numDisassemblyJobs);
+      t->_numBytes = EstimateSymbolTableMemoryUsage(t->_table);
+   }
+
+private:
+   const Queue<String> & _paths;
+   const Queue<String> & _labels;
+   const Queue<WarmSymbolTableRef> & _tables;
+   const ParseSettings & _settings;
+   JobSlots & _jobSlots;
+};
+
+/** The state that all of the diff server's connections share:  the warm symbol tables, and how to parse the executables that aren't warm yet */
+class DiffServer
+{
+public:
+   DiffServer(const ParseSettings & settings, uint32 numJobs, uint64 maxBytes) : _settings(settings), _numJobs(muscleMax(numJobs, (uint32)1)), _jobSlots(_numJobs), _tables(maxBytes) {/* empty */}
+
+   /** Adds to (retTables) the symbol table of each of (paths), parsing whichever of them aren't warm (all at once, sharing our jobs).
+     * A file that another request is already parsing isn't parsed again; instead we wait for that request's parse to finish and
+     * share its result.  (labels) are the names to show in the parsing progress lines.  A table that comes out empty is still returned,
+     * but isn't kept warm, so that the next request tries again.  Returns B_NO_ERROR on success, or B_ERROR (and sets (retError)) if
+     * one of the files couldn't be accessed or disassembled.
+     */
+   status_t GetSymbolTables(const Queue<String> & paths, const Queue<String> & labels, Queue<WarmSymbolTableRef> & retTables, String & retError)
+   {
+      Queue<String> fileIDs;
+      if (fileIDs.EnsureSize(paths.GetNumItems(), true) != B_NO_ERROR) {WARN_OUT_OF_MEMORY; retError = "Out of memory"; return B_ERROR;}
+      for (uint32 i=0; i<paths.GetNumItems(); i++)
+      {
+         if (GetExecutableFileID(paths[i](), fileIDs[i]) != B_NO_ERROR)
+         {
+            retError = String("Unable to access executable file [%1]").Arg(paths[i]);
+            return B_ERROR;
+         }
+      }
+
+      Queue<uint32> parseIndices;  // the tables that this request will parse itself
+      Queue<uint32> waitIndices;   // the tables that another request is already parsing
+      {
+         MutexGuard mg(_parsesMutex);
+         for (uint32 i=0; i<paths.GetNumItems(); i++)
+         {
+            WarmSymbolTableRef t = _tables.Get(paths[i], fileIDs[i]);
+            if (t() == NULL)
+            {
+               const WarmSymbolTableRef * inProgress = _parsesInProgress.Get(paths[i]);
+               if ((inProgress)&&((*inProgress)()->_fileID == fileIDs[i]))
+               {
+                  t = *inProgress;
+                  if (waitIndices.AddTail(i) != B_NO_ERROR) t.Reset();
+               }
+               else
+               {
+                  t = WarmSymbolTableRef(newnothrow WarmSymbolTable(fileIDs[i]));
+                  if ((t())&&(parseIndices.AddTail(i) != B_NO_ERROR)) t.Reset();
+                  if (t()) (void) _parsesInProgress.Put(paths[i], t);  // if this fails, other requests will just parse the file themselves
+               }
+            }
+            if ((t() == NULL)||(retTables.AddTail(t) != B_NO_ERROR))
+            {
+               WARN_OUT_OF_MEMORY;
+               for (uint32 j=0; j<parseIndices.GetNumItems(); j++) retTables[parseIndices[j]]()->_parseStatus = B_ERROR;  // they'll never get parsed
+               FinishParses(paths, retTables, parseIndices);
+               retError = "Out of memory";
+               return B_ERROR;
+            }
+         }
+      }
+
+      status_t ret = B_NO_ERROR;
+      if (parseIndices.HasItems())
+      {
+         ParseSettings settings = _settings;
+         settings._numDisassemblyJobs  = muscleMax(_numJobs/parseIndices.GetNumItems(), (uint32)1);
+         settings._numSanitizerThreads = settings._numDisassemblyJobs;
+
+         ParseWarmTablesTasks tasks(paths, labels, retTables, settings, _jobSlots);
+         WorkStealingExecutor(tasks).ExecuteTasks(parseIndices, parseIndices.GetNumItems());
+
+         MutexGuard mg(_parsesMutex);
+         FinishParses(paths, retTables, parseIndices);
+         _tables.EvictAsNecessary();
+      }
+
+      MutexGuard mg(_parsesMutex);
+      for (uint32 i=0; i<waitIndices.GetNumItems(); i++)
+      {
+         const uint32 idx = waitIndices[i];
+         if (IsParseInProgress(paths[idx], retTables[idx])) LogTime(MUSCLE_LOG_INFO, "Waiting for another request's parse of [%s] to finish...\n", paths[idx]());
+         while(IsParseInProgress(paths[idx], retTables[idx])) _parseFinished.Wait(_parsesMutex);
+      }
+      for (uint32 i=0; i<retTables.GetNumItems(); i++)
+      {
+         if (retTables[i]()->_parseStatus != B_NO_ERROR)
+         {
+            retError = String("Unable to disassemble executable file [%1]").Arg(paths[i]);
+            ret = B_ERROR;
+         }
+      }
+      return ret;
+   }
+
+   /** Compares the two executables specified by (request), and returns a DIFF_SERVER_REPLY_COMPARE Message describing the outcome */
+   MessageRef HandleCompareRequest(const Message & request)
+   {
+      const uint64 startTime = GetRunTime64();
+
+      MessageRef reply = GetMessageFromPool(DIFF_SERVER_REPLY_COMPARE);
+      if (reply() == NULL) {WARN_OUT_OF_MEMORY; return MessageRef();}
+
+      Queue<String> paths, labels;
+      String nameA, nameB;
+      (void) paths.EnsureSize(2, true);
+      if ((request.FindString("a", paths[0]) != B_NO_ERROR)||(request.FindString("b", paths[1]) != B_NO_ERROR))
+      {
+         (void) reply()->AddString("error", "Comparison request didn't specify both executables");
+         return reply;
+      }
+      if (request.FindString("a_name", nameA) != B_NO_ERROR) nameA = paths[0];
+      if (request.FindString("b_name", nameB) != B_NO_ERROR) nameB = paths[1];
+      bool detectRenames = true, writeJSON = false;
+      (void) request.FindBool("renames", detectRenames);
+      (void) request.FindBool("json", writeJSON);
+      (void) labels.AddTail("A");
+      (void) labels.AddTail("B");
+
+      LogTime(MUSCLE_LOG_INFO, "Comparing [%s] against [%s]...\n", paths[0](), paths[1]());
+      Queue<WarmSymbolTableRef> tables;
+      String errorStr;
+      if (GetSymbolTables(paths, labels, tables, errorStr) != B_NO_ERROR)
+      {
+         LogTime(MUSCLE_LOG_ERROR, "%s\n", errorStr());
+         (void) reply()->AddString("error", errorStr);
+         return reply;
+      }
+
+      // Each warm table has a LineTable of its own, so that it takes its lines with it when it gets evicted.  To be compared
+      // against A, B's symbols get copied into an overlay of A's LineTable, which goes away again after this request.
+      const SymbolTable & warmA = tables[0]()->_table;
+      SymbolTable copyOfB;
+      const SymbolTable * warmB = &tables[1]()->_table;
+      if (warmB->_lineTable != warmA._lineTable)
+      {
+         if (CopySymbolTableIntoLineTable(*warmB, LineTableRef(newnothrow LineTable(warmA._lineTable)), copyOfB) != B_NO_ERROR)
+         {
+            WARN_OUT_OF_MEMORY;
+            (void) reply()->AddString("error", "Out of memory");
+            return reply;
+         }
+         warmB = &copyOfB;
+      }
+      const LineTable & lineTable = *warmB->_lineTable();
+
+      // The warm tables have to stay intact for the next request, so only the symbols that didn't match get copied out of them
+      Hashtable<String, SymbolRecord> tableA, tableB;
+      const uint32 numMatching = CopyNonMatchingSymbols(warmA._symbols, warmB->_symbols, tableA, tableB);
+
+      Queue<RenamedSymbol> renames;
+      if (detectRenames) FindRenamedSymbols(tableA, tableB, lineTable, renames);
+
+      Queue<ReportEntry> entries;
+      CollectReportEntries(tableA, tableB, renames, entries);
+
+      // The reports are rendered by the same code as always, into temporary files whose contents then get sent back to the client
+      FILE * fpText = tmpfile();
+      FILE * fpJSON = writeJSON ? tmpfile() : NULL;
+      status_t ret = B_ERROR;
+      if ((fpText)&&((writeJSON == false)||(fpJSON)))
+      {
+         _jobSlots.Acquire(_numJobs);  // the report's worker threads count against the same limit as the parses do
+         ret = WriteReportFiles(nameA(), nameB(), entries, lineTable, fpText, fpJSON, _numJobs);
+         _jobSlots.Release(_numJobs);
+      }
+      if (ret == B_NO_ERROR) ret = AddFileContentsToMessage(fpText, "report", *reply());
+      if ((ret == B_NO_ERROR)&&(fpJSON)) ret = AddFileContentsToMessage(fpJSON, "json", *reply());
+      if (fpText) fclose(fpText);
+      if (fpJSON) fclose(fpJSON);
+
+      if (ret == B_NO_ERROR) ret = reply()->AddInt32("matching", numMatching);
+      if (ret == B_NO_ERROR) ret = reply()->AddInt32("nonmatching", tableA.GetNumItems());
+      if (ret == B_NO_ERROR) ret = reply()->AddInt32("renames", renames.GetNumItems());
+      for (uint32 i=0; ((ret == B_NO_ERROR)&&(i<entries.GetNumItems())); i++)
+      {
+         const ReportEntry & e = entries[i];
+         if (ret == B_NO_ERROR) ret = reply()->AddInt32("entry_type", e._type);
+         if (ret == B_NO_ERROR) ret = reply()->AddString("entry_a", e._nameA);
+         if (ret == B_NO_ERROR) ret = reply()->AddString("entry_b", e._nameB);
+         if (ret == B_NO_ERROR) ret = reply()->AddInt32("entry_similarity", e._similarity);
+      }
+      if (ret != B_NO_ERROR)
+      {
+         LogTime(MUSCLE_LOG_ERROR, "Error generating the diffs report for [%s] and [%s]!\n", paths[0](), paths[1]());
+         reply()->Clear();
+         (void) reply()->AddString("error", "Error generating the diffs report");
+      }
+
+      LogTime(MUSCLE_LOG_INFO, "Found " UINT32_FORMAT_SPEC " matching symbols and " UINT32_FORMAT_SPEC " non-matching symbols in " UINT64_FORMAT_SPEC " ms; " UINT32_FORMAT_SPEC " symbol tables (" UINT64_FORMAT_SPEC " MB) are now warm.\n", numMatching, tableA.GetNumItems(), MicrosToMillis(GetRunTime64()-startTime), _tables.GetNumTables(), _tables.GetNumBytes()/(1024*1024));
+      return reply;
+   }
+
+private:
+   /** Adds the contents of (fp) (e.g. a report that was written to a tmpfile()) to (msg), as a B_RAW_TYPE field named (fieldName) */
+   static status_t AddFileContentsToMessage(FILE * fp, const char * fieldName, Message & msg)
+   {
+      if (fseek(fp, 0, SEEK_END) != 0) return B_ERROR;
+      const long numBytes = ftell(fp);
+      if ((numBytes < 0)||(fseek(fp, 0, SEEK_SET) != 0)) return B_ERROR;
+
+      ByteBuffer buf;
+      if (buf.SetNumBytes((uint32) numBytes, false) != B_NO_ERROR) return B_ERROR;
+      if ((numBytes > 0)&&(fread(buf.GetBuffer(), 1, numBytes, fp) != (size_t) numBytes)) return B_ERROR;
+      return msg.AddData(fieldName, B_RAW_TYPE, buf.GetBuffer(), buf.GetNumBytes());
+   }
+
+   /** Returns true iff (t) is the table whose parse of (path) is still in progress.  Must be called with (_parsesMutex) locked. */
+   bool IsParseInProgress(const String & path, const WarmSymbolTableRef & t) const
+   {
+      const WarmSymbolTableRef * inProgress = _parsesInProgress.Get(path);
+      return ((inProgress)&&((*inProgress)() == t()));
+   }
+
+   /** Called (with (_parsesMutex) locked) when the parses of the tables at (parseIndices) are done:  keeps the ones that succeeded
+     * warm, and wakes up any other requests that were waiting for them.
+     */
+   void FinishParses(const Queue<String> & paths, const Queue<WarmSymbolTableRef> & tables, const Queue<uint32> & parseIndices)
+   {
+      for (uint32 i=0; i<parseIndices.GetNumItems(); i++)
+      {
+         const uint32 idx = parseIndices[i];
+         const WarmSymbolTableRef & t = tables[idx];
+         if (IsParseInProgress(paths[idx], t)) (void) _parsesInProgress.Remove(paths[idx]);
+         if (t()->_parseStatus != B_NO_ERROR) continue;
+         if (t()->_table._symbols.HasItems()) _tables.Put(paths[idx], t);
+                                         else LogTime(MUSCLE_LOG_WARNING, "No symbols were found in [%s], so its symbol table won't be kept warm.\n", paths[idx]());
+      }
+      _parseFinished.NotifyAll();
+   }
+
+   const ParseSettings _settings;
+   const uint32 _numJobs;
+   JobSlots _jobSlots;  // shared by all requests' parses, so that concurrent requests can't run more than (_numJobs) jobs in total
+   WarmSymbolTableCache _tables;
+
+   Mutex _parsesMutex;                                       // guards (_parsesInProgress)
+   MutexConditionVariable _parseFinished;                    // signalled whenever parses get removed from (_parsesInProgress)
+   Hashtable<String, WarmSymbolTableRef> _parsesInProgress;  // path -> the table that some request is currently parsing it into
+};
+
+/** One client's connection to the diff server.  Its requests are handled in a thread of its own, so that the server can go on
+  * accepting (and working on) other clients' requests in the meantime.
+  */
+class DiffServerConnectionThread : public Thread, private AbstractGatewayMessageReceiver
+{
+public:
+   DiffServerConnectionThread(DiffServer & server, const ConstSocketRef & sock) : _server(server), _sock(sock), _isFinished(false) {/* empty */}
+
+   /** Returns true once the client has disconnected, i.e. once our internal thread is about to exit */
+   bool IsFinished() const {MutexGuard mg(_mutex); return _isFinished;}
+
+protected:
+   virtual void InternalThreadEntry()
+   {
+      _gateway.SetDataIO(DataIORef(newnothrow TCPSocketDataIO(_sock, true)));  // (TCPSocketDataIO works with any stream socket)
+      while(_gateway.DoInput(*this) >= 0) {/* empty */}
+
+      MutexGuard mg(_mutex);
+      _isFinished = true;
+   }
+
+   virtual void MessageReceivedFromGateway(const MessageRef & msg, void * /*userData*/)
+   {
+      if ((msg())&&(msg()->what == DIFF_SERVER_COMMAND_COMPARE))
+      {
+         const MessageRef reply = _server.HandleCompareRequest(*msg());
+         if ((reply())&&(_gateway.AddOutgoingMessage(reply) != B_NO_ERROR)) WARN_OUT_OF_MEMORY;
+         while(_gateway.HasBytesToOutput())
+         {
+            if (_gateway.DoOutput() < 0) {LogTime(MUSCLE_LOG_ERROR, "Unable to send the comparison results back to the client!\n"); break;}
+         }
+      }
+      else LogTime(MUSCLE_LOG_WARNING, "DiffServerConnectionThread:  ignoring unknown Message from client\n");
+   }
+
+private:
+   DiffServer & _server;
+   const ConstSocketRef _sock;
+   MessageIOGateway _gateway;
+
+   Mutex _mutex;
+   bool _isFinished;
+};
+DECLARE_REFTYPES(DiffServerConnectionThread);
+
+/** Sets (retAddress) to the address of the Unix-domain socket at (path).  Returns B_NO_ERROR on success, or B_ERROR if (path) is too long. */
+static status_t GetUnixSocketAddress(const String & path, struct sockaddr_un & retAddress)
+{
+   memset(&retAddress, 0, sizeof(retAddress));
+   retAddress.sun_family = AF_UNIX;
+   if (path.Length() >= sizeof(retAddress.sun_path)) return B_ERROR;
+   memcpy(retAddress.sun_path, path(), path.Length()+1);
+   return B_NO_ERROR;
+}
+
+/** Returns a new Unix-domain stream socket, or a NULL reference on failure.  Like our pipes (see ChildProcess), it is close-on-exec,
+  * so that the disassembler processes don't inherit it.
+  */
+static ConstSocketRef CreateUnixSocket()
+{
+#ifdef __APPLE__
+   const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (fd >= 0) (void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+#else
+   const int fd = socket(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0);
+#endif
+   return GetConstSocketRefFromPool(fd);
+}
+
+/** Returns true iff the process at the other end of the connected Unix-domain socket (fd) is running as the same user as we are */
+static bool IsPeerOurUser(int fd)
+{
+#ifdef __APPLE__
+   uid_t peerUID;
+   gid_t peerGID;
+   if (getpeereid(fd, &peerUID, &peerGID) != 0) return false;
+#else
+   struct ucred cred;
+   socklen_t credLength = sizeof(cred);
+   if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &credLength) != 0) return false;
+   const uid_t peerUID = cred.uid;
+#endif
+   return (peerUID == geteuid());
+}
 
-         while(IsHexChar(*q)) q++;
-         const uint64 addr = Atoxll(&p[offset]);
+/** Connects to the diff server whose socket is at (path).  Returns the connected socket, or a NULL reference if no server (or one
+  * that is being run by some other user) is listening there.
+  */
+static ConstSocketRef ConnectToDiffServer(const String & path)
+{
+   struct sockaddr_un address;
+   if (GetUnixSocketAddress(path, address) != B_NO_ERROR) return ConstSocketRef();
 
-         const String sas = GetSymbolicAddressString(addr, index, optROData, roStart);
-         if (sas.HasChars())
-         {
-            ret += sas; // insert our expanded (symbol-relative) representation
-            p = q;
-         }
-         else ret += *p++;  // lookup failed?  Then leave it as-is (it's probably a numeric constant)
-      }
-      else ret += *p++;
-   }
+   const ConstSocketRef ret = CreateUnixSocket();
+   if ((ret() == NULL)||(connect(ret()->GetFileDescriptor(), (const struct sockaddr *) &address, sizeof(address)) != 0)) return ConstSocketRef();
+   return IsPeerOurUser(ret()->GetFileDescriptor()) ? ret : ConstSocketRef();
+}
 
-   ret.Replace("\n", "\\n");  // newlines mess with the diff output, otherwise
+/** Creates the diff server's listening socket at (path).  The socket file is only accessible by our own user (and the server
+  * checks each client's user as well, since not every OS honors a socket file's permissions).  A socket file that nobody is
+  * listening on any more (e.g. because a server crashed) gets replaced.  Returns the listening socket, or a NULL reference on failure.
+  */
+static ConstSocketRef CreateDiffServerSocket(const String & path)
+{
+   struct sockaddr_un address;
+   if (GetUnixSocketAddress(path, address) != B_NO_ERROR)
+   {
+      LogTime(MUSCLE_LOG_CRITICALERROR, "The diff server's socket path [%s] is too long!\n", path());
+      return ConstSocketRef();
+   }
 
-   if (ret.EndsWith('>'))
+   struct stat st;
+   if (lstat(path(), &st) == 0)
    {
-      // Neutralize any address indicators like "<main+0x9b6>" down to just "<main>"
-      const int32 ob = ret.LastIndexOf('<');
-      const int32 pb = (ob >= 0) ? ret.LastIndexOf('+') : -1;
-      if (pb > ob) ret = ret.Substring(0, pb) + ">";  // remove the "+09b6" part
+      if ((S_ISSOCK(st.st_mode) == false)||(ConnectToDiffServer(path)()))
+      {
+         LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to listen for diff requests at [%s]; another diff server is already using it, or it isn't a socket.\n", path());
+         return ConstSocketRef();
+      }
+      (void) unlink(path());  // a stale socket file
    }
-}
 
-// Replaces any obvious addresses with a fixed dummy-string, to avoid false-positive diffs
-static void SanitizeAddresses(String & text, const Queue<NameAndSymbolRecord> & index, const ByteBuffer * optROData, uint64 roStart)
-{
-   String outStr;
+   const ConstSocketRef ret = CreateUnixSocket();
+   if (ret() == NULL) return ConstSocketRef();
 
-   String scratchStr;
-   StringTokenizer tok(text(), "\n");
-   const char * t;
-   while((t=tok()) != NULL)
+   const int fd = ret()->GetFileDescriptor();
+   const mode_t oldUmask = umask(0077);  // so that the socket file gets created with 0600 permissions (there are no other threads yet that this could affect)
+   const bool bound = (bind(fd, (const struct sockaddr *) &address, sizeof(address)) == 0);
+   (void) umask(oldUmask);
+   if ((bound == false)||(listen(fd, 16) != 0))
    {
-      SanitizeLine(t, scratchStr, index, optROData, roStart);
-      outStr += scratchStr;
-      outStr += '\n';
+      LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to listen for diff requests at [%s]:  %s\n", path(), strerror(errno));
+      if (bound) (void) unlink(path());
+      return ConstSocketRef();
    }
-
-   text = outStr;
+   return ret;
 }
 
-static uint32 GetHexLength(const char * p)
-{
-   uint32 count = 0;
-   while(IsHexChar(*p)) {count++; p++;}
-   return count;
-}
+static String _diffServerSocketPath;  // so that DiffServerSignalHandler() knows which socket file to remove
 
-static bool IsPointerOrOffset(const char * s)
+/** Removes the diff server's socket file when the server is interrupted or terminated, then exits */
+static void DiffServerSignalHandler(int /*sigNum*/)
 {
-   const uint32 hexLength = GetHexLength(s);
-   return ((hexLength >= 4)||(strncmp(&s[hexLength], "(%r", 3) == 0));
+   (void) unlink(_diffServerSocketPath());
+   _exit(0);
 }
 
-// Replaces any obvious addresses with a fixed dummy-string, to avoid false-positive diffs
-static String GetWithNeutralizedAddresses(const String & s)
+/** Server mode:  parses (preloadPaths) (e.g. the baselines that most requests will use), then handles the DIFF_SERVER_COMMAND_COMPARE
+  * Messages that clients send to the Unix-domain socket at (socketPath), until the process is interrupted.  Each client connection
+  * is handled by a DiffServerConnectionThread, so several clients' requests can be worked on at once.
+  */
+static int RunDiffServer(const String & socketPath, const Queue<String> & preloadPaths, const ParseSettings & settings, uint32 numJobs, uint64 maxBytes)
 {
-   // Find any hex values starting with 0x, and replace the hex-number with "?", to avoid pointless diffs
-   const char * x = strstr(s(), "0x");
-   if (x)
-   {
-      char outBuf[2048];
+   // The socket gets created first, so that a second server fails right away instead of after the preload; clients that connect
+   // before the preload is done just wait for it
+   const ConstSocketRef listenSock = CreateDiffServerSocket(socketPath);
+   if (listenSock() == NULL) return 10;
 
-      const char * in = s();
-      char * out = outBuf;
+   _diffServerSocketPath = socketPath;
+   (void) signal(SIGINT,  DiffServerSignalHandler);
+   (void) signal(SIGTERM, DiffServerSignalHandler);
+   (void) signal(SIGHUP,  DiffServerSignalHandler);
+   (void) signal(SIGPIPE, SIG_IGN);  // a client that disconnects before its reply is sent shouldn't take the server down with it
 
-      bool inHex = false;
-      while(*in)
+   DiffServer diffServer(settings, numJobs, maxBytes);
+   if (preloadPaths.HasItems())
+   {
+      Queue<String> absPaths, labels;
+      for (uint32 i=0; i<preloadPaths.GetNumItems(); i++)
       {
-         if (inHex)
-         {
-            inHex = IsHexChar(*in);
-            if (inHex == false) *out++ = *in;
-         }
+         char absPath[PATH_MAX];
+         (void) absPaths.AddTail(realpath(preloadPaths[i](), absPath) ? String(absPath) : preloadPaths[i]);
+         (void) labels.AddTail(String("%1").Arg(i+1));
+      }
+
+      Queue<WarmSymbolTableRef> tables;
+      String errorStr;
+      if (diffServer.GetSymbolTables(absPaths, labels, tables, errorStr) != B_NO_ERROR) LogTime(MUSCLE_LOG_WARNING, "%s\n", errorStr());
+   }
+
+   LogTime(MUSCLE_LOG_INFO, "executable_diff server is listening at [%s]; run \"executable_diff --client=%s a b\" to compare executables a and b.\n", socketPath(), socketPath());
+
+   Queue<DiffServerConnectionThreadRef> connections;
+   while(true)
+   {
 #ifdef __APPLE__
-         else if ((in[0] == '0')&&(in[1] == 'x')&&(IsPointerOrOffset(&in[2])))
+      const int fd = accept(listenSock()->GetFileDescriptor(), NULL, NULL);
+      if (fd >= 0) (void) fcntl(fd, F_SETFD, FD_CLOEXEC);
 #else
-         else if (((in[0] == '0')&&(in[1] == 'x')&&(IsPointerOrOffset(&in[2]))) ||
-                  ((in[0] == '#')&&(in[1] == ' ')&&(IsPointerOrOffset(&in[2]))))
+      const int fd = accept4(listenSock()->GetFileDescriptor(), NULL, NULL, SOCK_CLOEXEC);
 #endif
+      if (fd < 0)
+      {
+         if ((errno == EINTR)||(errno == ECONNABORTED)) continue;
+         LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to accept connections at [%s]:  %s\n", socketPath(), strerror(errno));
+         break;
+      }
+
+      const ConstSocketRef sock = GetConstSocketRefFromPool(fd);
+      if (sock() == NULL) {WARN_OUT_OF_MEMORY; continue;}
+      if (IsPeerOurUser(fd) == false)
+      {
+         LogTime(MUSCLE_LOG_WARNING, "Rejected a connection from another user's process.\n");
+         continue;
+      }
+
+      // Clean up after the clients that have disconnected since last time
+      for (int32 i=connections.GetNumItems()-1; i>=0; i--)
+      {
+         if (connections[i]()->IsFinished())
          {
-            inHex = true;
-            *out++ = '0';
-            *out++ = 'x';
-            *out++ = '?';
-            in++;  // pass the '0'
+            (void) connections[i]()->WaitForInternalThreadToExit();
+            (void) connections.RemoveItemAt(i);
          }
-         else *out++ = *in;
-
-         in++;
       }
-      *out = '\0';
 
-      return outBuf;
+      DiffServerConnectionThreadRef t(newnothrow DiffServerConnectionThread(diffServer, sock));
+      if ((t() == NULL)||(connections.AddTail(t) != B_NO_ERROR)) {WARN_OUT_OF_MEMORY; continue;}
+      if (t()->StartInternalThread() != B_NO_ERROR)
+      {
+         LogTime(MUSCLE_LOG_ERROR, "Unable to start a thread to handle a client's requests!\n");
+         (void) connections.RemoveTail();
+      }
    }
-   else return s;
-}
 
-static String GetUniqueSymbolName(const String & symbolName, const Hashtable<String, SymbolRecord> & symbols)
-{
-   String s = symbolName + "#0";
-   while(symbols.ContainsKey(s))
-   {
-      uint32 suffix = 0;
-      s = s.WithoutNumericSuffix(&suffix);
-      s += String("%1").Arg(suffix+1);
-   }
-   return s;
+   (void) unlink(socketPath());
+   for (uint32 i=0; i<connections.GetNumItems(); i++) (void) connections[i]()->WaitForInternalThreadToExit();
+   return 10;
 }
 
-class CompareStartAddressesFunctor 
+/** Holds on to the diff server's reply, as it is received by RunDiffClient() */
+class DiffClientReplyReceiver : public AbstractGatewayMessageReceiver
 {
 public:
-   CompareStartAddressesFunctor() {/* empty */}
+   DiffClientReplyReceiver() {/* empty */}
 
-   int Compare(const SymbolRecord & r1, const SymbolRecord & r2, void *) const
-   {
-      const int addrDiff = muscleCompare(r1._startAddress, r2._startAddress);
-      return addrDiff ? addrDiff : muscleCompare(r1._text, r2._text);  // paranoia
-   }
+   const MessageRef & GetReply() const {return _reply;}
+
+protected:
+   virtual void MessageReceivedFromGateway(const MessageRef & msg, void * /*userData*/) {if ((msg())&&(msg()->what == DIFF_SERVER_REPLY_COMPARE)) _reply = msg;}
+
+private:
+   MessageRef _reply;
 };
 
-static void PrintSanitizerStatus(uint32 count, uint32 total)
+/** Writes the contents of (msg)'s B_RAW_TYPE field (fieldName) to a file named (fileName).  Returns B_NO_ERROR on success, or B_ERROR on failure. */
+static status_t WriteMessageDataToFile(const Message & msg, const char * fieldName, const String & fileName)
 {
-   LogTime(MUSCLE_LOG_INFO, "Reconstructing symbol addresses: " UINT32_FORMAT_SPEC "/" UINT32_FORMAT_SPEC " (%.0f%%)...\r", count, total, (100.0f*count)/total);
-}
+   const void * data = NULL;
+   uint32 numBytes = 0;
+   if (msg.FindData(fieldName, B_RAW_TYPE, &data, &numBytes) != B_NO_ERROR) return B_ERROR;
 
-#ifdef __APPLE__
+   FILE * fpOut = fopen(fileName(), "w");
+   if (fpOut == NULL) return B_ERROR;
+   const bool ok = (fwrite(data, 1, numBytes, fpOut) == numBytes);
+   return ((fclose(fpOut) == 0)&&(ok)) ? B_NO_ERROR : B_ERROR;
+}
 
-// Routine for parsing the output of Apple's otool disassembler utility
-static Hashtable<String, SymbolRecord> ParseOtoolOutput(const char * fileName)
+/** Client mode:  asks the diff server listening at (socketPath) to compare (fileA) and (fileB), then prints the results and writes
+  * the report files, just as a normal two-way comparison would.
+  */
+static int RunDiffClient(const String & socketPath, const char * fileA, const char * fileB, bool detectRenames, bool writeJSON)
 {
-   const char * otoolPath = "/usr/bin/otool";
+   // The server has its own working directory, so it has to be given absolute paths
+   char absPathA[PATH_MAX], absPathB[PATH_MAX];
+   if (realpath(fileA, absPathA) == NULL) {LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to find executable file [%s]\n", fileA); return 10;}
+   if (realpath(fileB, absPathB) == NULL) {LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to find executable file [%s]\n", fileB); return 10;}
 
-   const FilePathInfo fpi(otoolPath);
-   if (fpi.Exists() == false)
+   MessageRef request = GetMessageFromPool(DIFF_SERVER_COMMAND_COMPARE);
+   if ((request() == NULL)||(request()->AddString("a", absPathA) != B_NO_ERROR)||(request()->AddString("b", absPathB) != B_NO_ERROR)
+     ||(request()->AddString("a_name", fileA) != B_NO_ERROR)||(request()->AddString("b_name", fileB) != B_NO_ERROR)
+     ||(request()->AddBool("renames", detectRenames) != B_NO_ERROR)||(request()->AddBool("json", writeJSON) != B_NO_ERROR)) {WARN_OUT_OF_MEMORY; return 10;}
+
+   const uint64 startTime = GetRunTime64();
+   const ConstSocketRef sock = ConnectToDiffServer(socketPath);
+   if (sock() == NULL)
    {
-      String toolName = otoolPath;
-      toolName = toolName.Substring("/");  // only include the executable name itself
-      LogTime(MUSCLE_LOG_CRITICALERROR, "%s not found -- executable_diff needs to be able run %s in order to function.\n", otoolPath, toolName());
-      LogTime(MUSCLE_LOG_CRITICALERROR, "To install %s, install XCode (and its command line tools)\n", otoolPath, toolName(), toolName());
-      exit(10);
+      LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to connect to the diff server at [%s].  Is \"executable_diff --server=%s\" running?\n", socketPath(), socketPath());
+      return 10;
    }
 
-   FILE * fpIn = popen(String("%1 -tV '%2'").Arg(otoolPath).Arg(fileName)(), "r");
-   if (fpIn == NULL)
+   MessageIOGateway gateway;
+   gateway.SetDataIO(DataIORef(newnothrow TCPSocketDataIO(sock, true)));
+   if (gateway.AddOutgoingMessage(request) != B_NO_ERROR) {WARN_OUT_OF_MEMORY; return 10;}
+   while(gateway.HasBytesToOutput())
    {
-      LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to open executable [%s] for reading\n", fileName);
-      exit(10);
+      if (gateway.DoOutput() < 0) {LogTime(MUSCLE_LOG_CRITICALERROR, "Error sending the comparison request to the diff server!\n"); return 10;}
    }
 
-   LogTime(MUSCLE_LOG_INFO, "Opening executable file [%s]...\n", fileName);
-   Hashtable<String, SymbolRecord> symbols;
-   (void) symbols.EnsureSize(100000);  // try to avoid reallocations as they could be expensive
-
-   SymbolRecord * curSymbolContents  = NULL;
+   DiffClientReplyReceiver receiver;
+   while(receiver.GetReply()() == NULL)
+   {
+      if (gateway.DoInput(receiver) < 0) {LogTime(MUSCLE_LOG_CRITICALERROR, "Lost the connection to the diff server before it replied!\n"); return 10;}
+   }
+   const Message & reply = *receiver.GetReply()();
 
-   uint32 lineNumber  = 1;
-   uint32 numSymbols  = 0;
-   uint64 lastPrintAt = GetRunTime64();
+   String errorStr;
+   if (reply.FindString("error", errorStr) == B_NO_ERROR)
+   {
+      LogTime(MUSCLE_LOG_CRITICALERROR, "The diff server was unable to compare the executables:  %s\n", errorStr());
+      return 10;
+   }
 
-   const String ripStr = "(%rip)";  // indicates instruction-pointer-relative addressing!
-   const String rspStr = "(%rip)";  // stack-frame-pointer
+   int32 numMatching = 0, numNonMatching = 0, numRenames = 0, type, similarity;
+   (void) reply.FindInt32("matching",    numMatching);
+   (void) reply.FindInt32("nonmatching", numNonMatching);
+   (void) reply.FindInt32("renames",     numRenames);
 
-   char buf[2048];
-   (void) fgets(buf, sizeof(buf), fpIn);   // skip the first line, as it is just the name of the executable
-   while(fgets(buf, sizeof(buf), fpIn))
+   Queue<ReportEntry> entries;
+   String nameA, nameB;
+   for (uint32 i=0; ((reply.FindInt32("entry_type", i, type) == B_NO_ERROR)&&(reply.FindString("entry_a", i, nameA) == B_NO_ERROR)&&(reply.FindString("entry_b", i, nameB) == B_NO_ERROR)&&(reply.FindInt32("entry_similarity", i, similarity) == B_NO_ERROR)); i++)
    {
-      String line = buf;
-      line = line.Trim();
+      if (entries.AddTail(ReportEntry(type, nameA, NULL, nameB, NULL, similarity)) != B_NO_ERROR) WARN_OUT_OF_MEMORY;
+   }
 
-      if (line.EndsWith(':'))
-      {
-         line--;
-         curSymbolContents = symbols.PutAndGet(GetUniqueSymbolName(line, symbols));
-         if (curSymbolContents) numSymbols++;
-                           else WARN_OUT_OF_MEMORY;
-      }
-      else if (curSymbolContents)
-      {
-         const int32 firstTabIdx = line.IndexOf('\t');
-         if (firstTabIdx >= 0) 
-         {
-            const uint64 addr = Atoxll(line.Substring(0, firstTabIdx).Trim()());
-            if (curSymbolContents->_startAddress == 0) curSymbolContents->_startAddress = addr;
-            curSymbolContents->_length = muscleMax(curSymbolContents->_length, (addr-curSymbolContents->_startAddress)+4);
-            line = line.Substring(firstTabIdx+1);
-         }
+   printf("\n");
+   printf("-------------------------------------------------------------\n");
+   printf("\n");
 
-         String & text = curSymbolContents->_text;
+   LogComparisonSummary(numMatching, numNonMatching, numRenames);
+   LogReportEntries(fileA, fileB, entries);
 
-         const int32 commentStartIdx = line.IndexOf(" ## ");
-         const String beforeComment  = (commentStartIdx>=0) ? line.Substring(0, commentStartIdx) : line;
-         const String comment        = (commentStartIdx>=0) ? line.Substring(commentStartIdx)    : GetEmptyString();
-         const bool neutralize = ((line.Contains("(%rip)"))||(comment.Contains(" for: "))||(comment.Contains(" symbol address:"))) || (((line.StartsWith("call"))||(line.StartsWith("jmp")))&&(commentStartIdx < 0));
-         const bool keepComment = comment.Contains("literal");
+   const String timestamp = GetFileNameTimestamp();
+   const String reportFileName = String("executable_diffs_report_") + timestamp + ".txt";
+   if (WriteMessageDataToFile(reply, "report", reportFileName) == B_NO_ERROR) LogTime(MUSCLE_LOG_INFO, "Diffs report written to file [%s]\n", reportFileName());
+                                                                         else LogTime(MUSCLE_LOG_ERROR, "Error writing the diffs report!\n");
+   if (writeJSON)
+   {
+      const String jsonFileName = String("executable_diffs_report_") + timestamp + ".jsonl";
+      if (WriteMessageDataToFile(reply, "json", jsonFileName) == B_NO_ERROR) LogTime(MUSCLE_LOG_INFO, "JSON diffs report written to file [%s]\n", jsonFileName());
+                                                                        else LogTime(MUSCLE_LOG_ERROR, "Unable to write JSON report file [%s]\n", jsonFileName());
+   }
 
-         String l = neutralize ? GetWithNeutralizedAddresses(beforeComment) : beforeComment;
-         if (keepComment) l += comment;
+   LogTime(MUSCLE_LOG_INFO, "The diff server replied in " UINT64_FORMAT_SPEC " ms.\n", MicrosToMillis(GetRunTime64()-startTime));
+   return 0;
+}
 
-         text += l;
-         text += '\n';
+/** Splits the command line arguments into options (e.g. "--jobs=4" becomes jobs -> 4) and file paths */
+static void ParseCommandLine(int argc, char ** argv, Hashtable<String, String> & retOptions, Queue<String> & retPaths)
+{
+   for (int i=1; i<argc; i++)
+   {
+      const String arg = argv[i];
+      if (arg.StartsWith("--"))
+      {
+         const int32 equalsIdx = arg.IndexOf('=');
+         if (equalsIdx >= 0) (void) retOptions.Put(arg.Substring(2, equalsIdx), arg.Substring(equalsIdx+1));
+                        else (void) retOptions.Put(arg.Substring(2), GetEmptyString());
       }
-
-      if (OnceEvery(MillisToMicros(100), lastPrintAt)) LogTime(MUSCLE_LOG_INFO, "Parsing otool output: " UINT32_FORMAT_SPEC " lines (" UINT32_FORMAT_SPEC " symbols) ...\r", lineNumber, numSymbols);
-      lineNumber++;
+      else (void) retPaths.AddTail(arg);
    }
-   pclose(fpIn);
+}
 
-   symbols.SortByValue(CompareStartAddressesFunctor());
+/** Returns the directory where parsed symbol tables should be cached by default, or an empty String if there isn't one */
+static String GetDefaultSymbolCacheDirectory()
+{
+   const char * xdgCacheHome = getenv("XDG_CACHE_HOME");
+   if ((xdgCacheHome)&&(*xdgCacheHome)) return String(xdgCacheHome) + "/executable_diff";
 
-   Queue<NameAndSymbolRecord> index;  // used for quick (O(logN)) address-lookups
-   (void) index.EnsureSize(symbols.GetNumItems());
-   for (HashtableIterator<String, SymbolRecord> iter(symbols); iter.HasData(); iter++) (void) index.AddTail(NameAndSymbolRecord(&iter.GetKey(), iter.GetValue()));
+   const char * home = getenv("HOME");
+   if ((home == NULL)||(*home == '\0')) return GetEmptyString();
+#ifdef __APPLE__
+   return String(home) + "/Library/Caches/executable_diff";
+#else
+   return String(home) + "/.cache/executable_diff";
+#endif
+}
 
-   // Now go through and replace any absolute addresses with symbol-relative representations
-   // (necessary since the addresses of the symbols may be different)
-   uint32 count = 0;
-   for (HashtableIterator<String, SymbolRecord> iter(symbols); iter.HasData(); iter++,count++)
-   {
-      SanitizeAddresses(iter.GetValue()._text, index, NULL, 0);
-      if (OnceEvery(MillisToMicros(100), lastPrintAt)) PrintSanitizerStatus(count, symbols.GetNumItems());
-   }
-   PrintSanitizerStatus(count, symbols.GetNumItems());
-   printf("\n");
+/** Returns the path of the Unix-domain socket that --server listens at (and --client connects to) by default:  one in
+  * $XDG_RUNTIME_DIR (which only our own user can access) if it is set, or else one in the default cache directory.
+  */
+static String GetDefaultDiffServerSocketPath()
+{
+   const char * xdgRuntimeDir = getenv("XDG_RUNTIME_DIR");
+   if ((xdgRuntimeDir)&&(*xdgRuntimeDir)) return String(xdgRuntimeDir) + "/executable_diff.sock";
 
-   symbols.SortByKey();
-   LogTime(MUSCLE_LOG_INFO, "Parsed " UINT32_FORMAT_SPEC " unique symbols from %s\n", symbols.GetNumItems(), fileName);
-   return symbols;
+   const String cacheDir = GetDefaultSymbolCacheDirectory();
+   return cacheDir.HasChars() ? (cacheDir + "/server.sock") : GetEmptyString();
 }
 
-#else
+/** Creates the specified directory (and any missing parent directories).  Returns B_NO_ERROR on success, or if the directory already existed. */
+static status_t CreateDirectoryIfNecessary(const String & dirPath)
+{
+   if ((mkdir(dirPath(), 0755) == 0)||(errno == EEXIST)) return B_NO_ERROR;
+   if (errno != ENOENT) return B_ERROR;
+
+   const int32 lastSlashIdx = dirPath.LastIndexOf('/');
+   if ((lastSlashIdx <= 0)||(CreateDirectoryIfNecessary(dirPath.Substring(0, lastSlashIdx)) != B_NO_ERROR)) return B_ERROR;
+   return ((mkdir(dirPath(), 0755) == 0)||(errno == EEXIST)) ? B_NO_ERROR : B_ERROR;
+}
+
+static uint32 GetNumCPUCores()
+{
+   const long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+   return (numCores > 0) ? (uint32) numCores : 1;
+}
 
-// Routine for parsing the output of Linux's objdump disassembler utility
-static Hashtable<String, SymbolRecord> ParseObjdumpOutput(const char * fileName)
+int main(int argc, char ** argv) 
 {
-   const char * otoolPath = "/usr/bin/objdump";
+   CompleteSetupSystem css;
 
-   const FilePathInfo fpi(otoolPath);
-   if (fpi.Exists() == false)
+   Hashtable<String, String> options;
+   Queue<String> paths;
+   ParseCommandLine(argc, argv, options, paths);
+
+   const String * serverArg = options.Get("server");
+   const String * clientArg = options.Get("client");
+   if ((paths.GetNumItems() < 2)&&(serverArg == NULL))
    {
-      String toolName = otoolPath;
-      toolName = toolName.Substring("/");  // only include the executable name itself
-      LogTime(MUSCLE_LOG_CRITICALERROR, "%s not found -- executable_diff needs to be able run %s in order to function.\n", otoolPath, toolName());
-      exit(10);
+      LogTime(MUSCLE_LOG_CRITICALERROR, "Usage:  ./executable_diff [--jobs=N] [--cache-dir=path] [--cache-max-mb=MB] [--no-cache] [--prefilter] [--stats] [--no-renames] [--json] [--low-memory[=path]] [--quick] [--client[=socket]] ./CueStationA.app/Contents/MacOS/CueStation ./CueStationB.app/Contents/MacOS/CueStation\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "   or:  ./executable_diff --server[=socket] [--server-memory=MB] [--jobs=N] [--cache-dir=path] [--cache-max-mb=MB] [--no-cache] [executables to preload...]\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --jobs=N         : the number of disassembler processes and worker threads to run at once (defaults to the number of CPU cores)\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --cache-dir=path : the directory to cache parsed symbol tables in (defaults to %s)\n", GetDefaultSymbolCacheDirectory()());
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --cache-max-mb=MB : delete the least recently used cache files whenever the cache gets bigger than this (defaults to %u; 0 means no limit)\n", (unsigned int) DEFAULT_SYMBOL_CACHE_MAX_MB);
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --no-cache       : always parse both executables from scratch, and don't write anything to the cache\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --prefilter      : compare the functions' raw machine code first, and only disassemble the ones that might differ (ELF only)\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --stats          : write the time, CPU, I/O and memory used by each phase of the run to a JSON file next to the diffs report\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --no-renames     : don't try to pair up symbols that are present in only one executable as renames, by comparing their contents\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --json           : also write the diffs as JSON lines (one object per symbol) to a .jsonl file next to the diffs report\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --low-memory[=path] : keep the symbols' text in temporary files (in path, defaulting to $TMPDIR or /tmp) and only hold the differing symbols' text in memory\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --quick          : just decide whether the executables are equivalent, as fast as possible; exits with 0 if they are, or 1 if they differ\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --server[=socket] : keep running, and compare executables on behalf of --client processes, keeping recently used symbol tables in memory (socket defaults to %s)\n", GetDefaultDiffServerSocketPath()());
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --server-memory=MB : how much memory the server may use to keep symbol tables in memory (defaults to %u)\n", (unsigned int) DEFAULT_DIFF_SERVER_MEMORY_MB);
+      LogTime(MUSCLE_LOG_CRITICALERROR, "  --client[=socket] : have the server (which must be running on this machine, as the same user) do the comparison, and write its results here\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "If both paths are directories, each executable file in the first one is compared against the file with the same relative path in the second.\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "If more than two executables are specified, the first one is treated as a baseline that each of the others gets compared against.\n");
+      return 10;
    }
 
-   FILE * fpIn = popen(String("%1 -d --no-show-raw-insn '%2'").Arg(otoolPath).Arg(fileName)(), "r");
-   if (fpIn == NULL)
+   const bool detectRenames = (options.ContainsKey("no-renames") == false);
+   const bool writeJSON     = options.ContainsKey("json");
+
+   const String * socketArg = clientArg ? clientArg : serverArg;
+   const String socketPath  = ((socketArg)&&(socketArg->HasChars())) ? *socketArg : GetDefaultDiffServerSocketPath();
+   if ((socketArg)&&(socketPath.IsEmpty()))
    {
-      LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to open executable [%s] for reading\n", fileName);
-      exit(10);
+      LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to determine where the diff server's socket should go; please specify it, e.g. --%s=/path/to/socket\n", clientArg ? "client" : "server");
+      return 10;
    }
 
-   LogTime(MUSCLE_LOG_INFO, "Opening executable file [%s]...\n", fileName);
-   Hashtable<String, SymbolRecord> symbols;
-   (void) symbols.EnsureSize(100000);  // try to avoid reallocations as they could be expensive
+   if (clientArg)
+   {
+      if (paths.GetNumItems() > 2) LogTime(MUSCLE_LOG_WARNING, "--client can only compare two executables; ignoring all but the first two.\n");
+      printf("\n");
+      return RunDiffClient(socketPath, paths[0](), paths[1](), detectRenames, writeJSON);
+   }
 
-   SymbolRecord * curSymbolContents  = NULL;
+   const String * jobsArg = options.Get("jobs");
+   const uint32 numJobs = ((jobsArg)&&(jobsArg->HasChars())) ? (uint32) atol((*jobsArg)()) : GetNumCPUCores();
 
-   uint32 lineNumber  = 1;
-   uint32 numSymbols  = 0;
-   uint64 lastPrintAt = GetRunTime64();
+   // Since both executables get parsed at the same time, each of them gets half of the jobs
+   ParseSettings settings;
+   settings._numDisassemblyJobs  = muscleMax(numJobs/2, (uint32)1);
+   settings._numSanitizerThreads = settings._numDisassemblyJobs;
 
-   char buf[2048];
-   (void) fgets(buf, sizeof(buf), fpIn);   // skip the first line, as it is just the name of the executable
-   while(fgets(buf, sizeof(buf), fpIn))
+   if (options.ContainsKey("no-cache") == false)
    {
-      String line = buf;
-      line = line.Trim();
+      const String * cacheDirArg = options.Get("cache-dir");
+      settings._cacheDirectory = cacheDirArg ? *cacheDirArg : GetDefaultSymbolCacheDirectory();
 
-      if (line.EndsWith(">:"))
-      {
-         const uint64 addr = Atoxll(line());
-         if (addr == 0) continue;
-
-         if (curSymbolContents)
-         {
-            curSymbolContents->_length = muscleMax(curSymbolContents->_length, (addr-curSymbolContents->_startAddress));
-            curSymbolContents = NULL;
-         }
-
-         curSymbolContents = symbols.PutAndGet(GetUniqueSymbolName(line.Substring("<").Substring(0,">"), symbols));
-         if (curSymbolContents)
-         {
-             curSymbolContents->_startAddress = addr;
-             numSymbols++;
-         }
-         else WARN_OUT_OF_MEMORY;
-      }
-      else if (curSymbolContents)
+      const String * cacheMaxArg = options.Get("cache-max-mb");
+      settings._cacheMaxBytes = (((cacheMaxArg)&&(cacheMaxArg->HasChars())) ? (uint64) atoll((*cacheMaxArg)()) : (uint64) DEFAULT_SYMBOL_CACHE_MAX_MB)*1024*1024;
+      if ((settings._cacheDirectory.HasChars())&&(CreateDirectoryIfNecessary(settings._cacheDirectory) != B_NO_ERROR))
       {
-         const int32 firstTabIdx = line.IndexOf('\t');
-         if (firstTabIdx >= 0) line = line.Substring(firstTabIdx+1).Trim();  // skip past the address-column (e.g. "  4137ac:\t")
-
-         const bool neutralize = (line.Contains("%rip"))||(line.Contains("%rsp"))||(line.EndsWith('>'))||((line.StartsWith("call"))||(line.StartsWith("jmp")));
-         String & text = curSymbolContents->_text;
-         text += neutralize ? GetWithNeutralizedAddresses(line) : line;
-         text += '\n';
+         LogTime(MUSCLE_LOG_WARNING, "Unable to create symbol cache directory [%s], symbol tables won't be cached.\n", settings._cacheDirectory());
+         settings._cacheDirectory.Clear();
       }
+   }
 
-      if (OnceEvery(MillisToMicros(100), lastPrintAt)) LogTime(MUSCLE_LOG_INFO, "Parsing objdump output: " UINT32_FORMAT_SPEC " lines (" UINT32_FORMAT_SPEC " symbols) ...\r", lineNumber, numSymbols);
-      lineNumber++;
+   const String * lowMemoryArg = options.Get("low-memory");
+   if (lowMemoryArg)
+   {
+      const char * tmpDir = getenv("TMPDIR");
+      settings._spillDirectory = lowMemoryArg->HasChars() ? *lowMemoryArg : (((tmpDir)&&(*tmpDir)) ? String(tmpDir) : String("/tmp"));
    }
-   pclose(fpIn);
 
-   symbols.SortByValue(CompareStartAddressesFunctor());
+   if (serverArg)
+   {
+      if ((lowMemoryArg)||(options.ContainsKey("stats"))||(options.ContainsKey("prefilter"))) LogTime(MUSCLE_LOG_WARNING, "--low-memory, --stats and --prefilter can't be used with --server, ignoring them.\n");
+      settings._spillDirectory.Clear();
 
-   Queue<NameAndSymbolRecord> index;  // used for quick (O(logN)) address-lookups
-   (void) index.EnsureSize(symbols.GetNumItems());
-   for (HashtableIterator<String, SymbolRecord> iter(symbols); iter.HasData(); iter++) (void) index.AddTail(NameAndSymbolRecord(&iter.GetKey(), iter.GetValue()));
+      const String * memoryArg = options.Get("server-memory");
+      const uint64 maxMegabytes = ((memoryArg)&&(memoryArg->HasChars())) ? (uint64) atoll((*memoryArg)()) : (uint64) DEFAULT_DIFF_SERVER_MEMORY_MB;
+      if ((serverArg->IsEmpty())&&(CreateDirectoryIfNecessary(socketPath.Substring(0, socketPath.LastIndexOf('/'))) != B_NO_ERROR)) LogTime(MUSCLE_LOG_WARNING, "Unable to create the directory for socket [%s]\n", socketPath());
+      return RunDiffServer(socketPath, paths, settings, numJobs, maxMegabytes*1024*1024);
+   }
 
-   // For Linux, we'll also need to parse out the .rodata section by hand,
-   // since objdump doesn't have the helpful literal-annotations that otool has
-   uint64 roStart = 0;
-   ByteBufferRef roData = GetByteBufferFromPool(0);
-   if (roData())
-   {
-      FILE * fpIn = popen(String("%1 -sj .rodata '%2'").Arg(otoolPath).Arg(fileName)(), "r");
-      if (fpIn)
-      {
-         String scratchHexStr;
+   const char * fileA = paths[0]();
+   const char * fileB = paths[1]();
 
-         bool parse = false;
-         while(fgets(buf, sizeof(buf), fpIn))
-         {
-            if (parse)
-            {
-               String b = buf; b = b.Trim();
-               StringTokenizer tok(b(), " ");
-               const char * addr = tok();
-               if (roStart == 0) roStart = Atoxll(addr);
+   RunStats runStats;
+   if (options.ContainsKey("stats")) settings._optStats = &runStats;
+   PhaseRecorder totalPhase(settings._optStats, "total");
 
-               scratchHexStr.Clear();
-               for (uint32 i=0; i<4; i++) scratchHexStr += tok();
+   printf("\n");
 
-               for (uint32 i=0; (i+1)<scratchHexStr.Length(); i+=2)
-               {
-                  char tempBuf[3];
-                  memcpy(tempBuf, scratchHexStr()+i, 2);
-                  tempBuf[2] = '\0';
-                  (void) roData()->AppendByte((uint8) strtol(tempBuf, NULL, 16));
-               }
-            } 
-            else if (strncmp(buf, "Contents of section .rodata:", 28) == 0) parse = true;
-         }
+   if ((paths.GetNumItems() == 2)&&(FilePathInfo(fileA).IsDirectory())&&(FilePathInfo(fileB).IsDirectory()))
+   {
+      if (options.ContainsKey("prefilter")) LogTime(MUSCLE_LOG_WARNING, "--prefilter can't be used when comparing directory trees, ignoring it.\n");
+      if (options.ContainsKey("quick"))     LogTime(MUSCLE_LOG_WARNING, "--quick can't be used when comparing directory trees, ignoring it.\n");
 
-         pclose(fpIn);
-      }
+      String dirA = paths[0], dirB = paths[1];
+      while((dirA.Length() > 1)&&(dirA.EndsWith('/'))) dirA = dirA.Substring(0, dirA.Length()-1);
+      while((dirB.Length() > 1)&&(dirB.EndsWith('/'))) dirB = dirB.Substring(0, dirB.Length()-1);
+      return CompareTrees(dirA, dirB, settings, numJobs, detectRenames, writeJSON, totalPhase);
    }
-   
-   // Now go through and replace any absolute addresses with symbol-relative representations
-   // (necessary since the addresses of the symbols may be different)
-   uint32 count = 0;
-   for (HashtableIterator<String, SymbolRecord> iter(symbols); iter.HasData(); iter++,count++)
+
+   if (paths.GetNumItems() > 2)
    {
-      SanitizeAddresses(iter.GetValue()._text, index, roData(), roStart);
-      if (OnceEvery(MillisToMicros(100), lastPrintAt)) PrintSanitizerStatus(count, symbols.GetNumItems());
-   }
-   PrintSanitizerStatus(count, symbols.GetNumItems());
-   printf("\n");
+      if (options.ContainsKey("prefilter")) LogTime(MUSCLE_LOG_WARNING, "--prefilter can only be used when comparing two executables, ignoring it.\n");
+      if (options.ContainsKey("quick"))     LogTime(MUSCLE_LOG_WARNING, "--quick can only be used when comparing two executables, ignoring it.\n");
 
-   symbols.SortByKey();
-   LogTime(MUSCLE_LOG_INFO, "Parsed " UINT32_FORMAT_SPEC " unique symbols from %s\n", symbols.GetNumItems(), fileName);
+      Queue<String> buildFiles = paths;
+      (void) buildFiles.RemoveHead();
+      return CompareBuildsAgainstBaseline(fileA, buildFiles, settings, numJobs, detectRenames, writeJSON, totalPhase);
+   }
 
-   return symbols;
-}
-#endif
+   if (options.ContainsKey("quick"))
+   {
+      if (lowMemoryArg) LogTime(MUSCLE_LOG_WARNING, "--low-memory can't be used with --quick, ignoring it.\n");
+      settings._spillDirectory.Clear();
+      return CheckEquivalence(fileA, fileB, settings, numJobs, totalPhase);
+   }
 
-static Hashtable<String, SymbolRecord> ParseExecutableFile(const char * fileName)
-{
+   ParseSettings settingsA = settings;
+   ParseSettings settingsB = settings;
+   settingsA._lineTable = settingsB._lineTable = LineTableRef(newnothrow LineTable);  // so that A's and B's line IDs can be compared
+   if (settingsA._lineTable() == NULL) WARN_OUT_OF_MEMORY;
+   uint32 numPrefilterMatches = 0;
 #ifdef __APPLE__
-   return ParseOtoolOutput(fileName);
+   if (options.ContainsKey("prefilter")) LogTime(MUSCLE_LOG_WARNING, "--prefilter is only supported for ELF executables, ignoring it.\n");
 #else
-   return ParseObjdumpOutput(fileName);
-#endif
-}
-
-static uint32 RemoveMatchingSymbolsAux(Hashtable<String, SymbolRecord> & tableA, Hashtable<String, SymbolRecord> & tableB)
-{
-   uint32 ret = 0;
-   for (HashtableIterator<String, SymbolRecord> iter(tableA); iter.HasData(); iter++)
+   PrefilterImage imageA, imageB;
+   DisassemblyTargets targetsA, targetsB;
+   if (options.ContainsKey("prefilter"))
    {
-      const String & symbolName = iter.GetKey();
-      const SymbolRecord & valA = iter.GetValue();
-      const SymbolRecord * valB = tableB.Get(symbolName);
-      if ((valB)&&(valB->_text == valA._text))
+      PhaseRecorder prefilterPhase(settings._optStats, "prefilter");
+      if (OpenPrefilterImages(fileA, imageA, fileB, imageB) == B_NO_ERROR)
       {
-         (void) tableB.Remove(symbolName);
-         (void) tableA.Remove(symbolName);  // gotta do this last, as it invalidates (symbolName)
-         ret++;
+         PrefilterExecutables(imageA, targetsA, imageB, targetsB, muscleMax(numJobs, (uint32)1), numPrefilterMatches);
+         prefilterPhase.GetStats()._numSymbols = imageA.GetFunctions().GetNumItems()+imageB.GetFunctions().GetNumItems();
+         settingsA._optTargets = &targetsA;
+         settingsB._optTargets = &targetsB;
       }
+      else LogTime(MUSCLE_LOG_WARNING, "Unable to read the symbol tables of [%s] and [%s], so the prefilter can't be used.  Disassembling everything instead.\n", fileA, fileB);
    }
-   return ret;
-}
+#endif
 
-static void ReportDifferingSymbolsAux(const char * fileA, const Hashtable<String, SymbolRecord> & tableA, const char * fileB, const Hashtable<String, SymbolRecord> & tableB, Hashtable<String, Void> & reported, FILE * fpOut)
-{
-   for (HashtableIterator<String, SymbolRecord> iter(tableA); iter.HasData(); iter++)
+   // Parse both executables at once; each parse is dominated by waiting on its own objdump/otool process anyway.
+   // In low-memory mode, though, B's symbols get compared against A's as they are resolved, so that only the ones
+   // that differ need to keep their text; that means A has to be parsed first (and so each parse gets all of the jobs).
+   const bool lowMemory = settings._spillDirectory.HasChars();
+   if (lowMemory)
    {
-      const String & symbolName = iter.GetKey();
-      if (reported.ContainsKey(symbolName) == false)
-      {
-         (void) reported.PutWithDefault(symbolName);
-
-         const SymbolRecord & valA = iter.GetValue();
-         const SymbolRecord * valB = tableB.Get(symbolName);
-         if (valB) 
-         {
-            LogTime(MUSCLE_LOG_WARNING, "Diffs detected in symbol [%s]\n", symbolName());
-            if (fpOut) PrintSymbolDiffs(symbolName, valA._text, valB->_text, fpOut);
-         }
-         else LogTime(MUSCLE_LOG_WARNING, "Symbol [%s] exists in [%s] but is not present in [%s]\n", symbolName(), fileA, fileB);
-      }
+      settingsA._numDisassemblyJobs = settingsA._numSanitizerThreads = muscleMax(numJobs, (uint32)1);
+      settingsB._numDisassemblyJobs = settingsB._numSanitizerThreads = settingsA._numDisassemblyJobs;
    }
-}
 
-int main(int argc, char ** argv) 
-{
-   CompleteSetupSystem css;
+   ParseExecutableThread parseA(fileA, "A", settingsA);
+   parseA.Start();
+   if (lowMemory) settingsB._optBaseline = &parseA.GetResults()._symbols;
 
-   if (argc < 3)
+   ParseExecutableThread parseB(fileB, "B", settingsB);
+   parseB.Start();
+   Hashtable<String, SymbolRecord> & tableA = parseA.GetResults()._symbols;
+   Hashtable<String, SymbolRecord> & tableB = parseB.GetResults()._symbols;
+   if ((parseA.GetStatus() != B_NO_ERROR)||(parseB.GetStatus() != B_NO_ERROR))
    {
-      LogTime(MUSCLE_LOG_CRITICALERROR, "Usage:  ./executable_diff ./CueStationA.app/Contents/MacOS/CueStation ./CueStationB.app/Contents/MacOS/CueStation\n");
+      LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to disassemble [%s], so it can't be compared.\n", (parseA.GetStatus() != B_NO_ERROR) ? fileA : fileB);
       return 10;
    }
 
-   const char * fileA = argv[1];
-   const char * fileB = argv[2];
-
-   printf("\n");
-   Hashtable<String, SymbolRecord> tableA = ParseExecutableFile(fileA);
-
    printf("\n");
-   Hashtable<String, SymbolRecord> tableB = ParseExecutableFile(fileB);
 
-   printf("\n");
+   // Get rid of everything that didn't change, we're not interested in that.
+   // Note that a single pass is sufficient:  any symbol that is present in both tables with matching
+   // text gets removed from both tables here, so a second (B-to-A) pass could never find anything more.
+   PhaseRecorder comparePhase(settings._optStats, "compare");
+   comparePhase.GetStats()._numSymbols = tableA.GetNumItems()+tableB.GetNumItems();
+   const uint32 numRemoved = RemoveMatchingSymbolsAux(tableA, tableB)+numPrefilterMatches;
+   comparePhase.Finish();
 
-   // Get rid of everything that didn't change, we're not interested in that
-   uint32 numRemoved = 0;
-   numRemoved += RemoveMatchingSymbolsAux(tableA, tableB);
-   numRemoved += RemoveMatchingSymbolsAux(tableB, tableA);
+   Queue<RenamedSymbol> renames;
+   if (detectRenames)
+   {
+      PhaseRecorder renamesPhase(settings._optStats, "match renames");
+      FindRenamedSymbols(tableA, tableB, *parseB.GetResults()._lineTable(), renames);
+      renamesPhase.GetStats()._numSymbols = renames.GetNumItems()*2;
+   }
 
    printf("\n");
    printf("-------------------------------------------------------------\n");
    printf("\n");
 
-   LogTime(MUSCLE_LOG_INFO, "Found " UINT32_FORMAT_SPEC " matching symbols and " UINT32_FORMAT_SPEC " non-matching symbols.\n", numRemoved, tableA.GetNumItems(), tableB.GetNumItems());
+   LogComparisonSummary(numRemoved, tableA.GetNumItems(), renames.GetNumItems());
 
-   String reportFileName = String("executable_diffs_report_") + GetHumanReadableTimeString(GetCurrentTime64()) + ".txt";
-   reportFileName.Replace('/', '_');
-   reportFileName.Replace(':', '_');
-   reportFileName.Replace(' ', '_');
+   const String timestamp = GetFileNameTimestamp();
+   const String reportFileName = String("executable_diffs_report_") + timestamp + ".txt";
    FILE * fpOut = fopen(reportFileName(), "w");
-   
-   Hashtable<String, Void> reported;
-   ReportDifferingSymbolsAux(fileA, tableA, fileB, tableB, reported, fpOut);
-   ReportDifferingSymbolsAux(fileB, tableB, fileA, tableA, reported, fpOut);
 
+   const String jsonFileName = String("executable_diffs_report_") + timestamp + ".jsonl";
+   FILE * fpJSON = writeJSON ? fopen(jsonFileName(), "w") : NULL;
+   if ((writeJSON)&&(fpJSON == NULL)) LogTime(MUSCLE_LOG_ERROR, "Unable to write JSON report file [%s]\n", jsonFileName());
+
+   PhaseRecorder reportPhase(settings._optStats, "report");
+   Queue<ReportEntry> entries;
+   CollectReportEntries(tableA, tableB, renames, entries);
+   LogReportEntries(fileA, fileB, entries);
+   const status_t writeRet = WriteReportFiles(fileA, fileB, entries, *parseB.GetResults()._lineTable(), fpOut, fpJSON, muscleMax(numJobs, (uint32)1));
+   reportPhase.GetStats()._numSymbols = entries.GetNumItems();
+
+   if (writeRet != B_NO_ERROR) LogTime(MUSCLE_LOG_ERROR, "Error writing the diffs report!\n");
    if (fpOut)
    {
       LogTime(MUSCLE_LOG_INFO, "Diffs report written to file [%s]\n", reportFileName());
       fclose(fpOut);
    }
+   if (fpJSON)
+   {
+      LogTime(MUSCLE_LOG_INFO, "JSON diffs report written to file [%s]\n", jsonFileName());
+      fclose(fpJSON);
+   }
+   reportPhase.Finish();
+
+   if (settings._optStats)
+   {
+      totalPhase.Finish();
+      WriteStatsFile(runStats, timestamp, paths);
+   }
 
    return 0;
 }
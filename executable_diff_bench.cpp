@@ -0,0 +1,518 @@
+/* This file is Copyright 2002 Level Control Systems.  See the included LICENSE.txt file for details. */
+
+// Benchmark harness for executable_diff's parsing and sanitizing hot paths.  Rather than running a disassembler
+// on real executables, it generates synthetic disassembler output and read-only data of a configurable size, and
+// times each phase of the sanitizing pipeline on them.  Build and run it via "make bench"; see PrintUsage() below.
+//
+// executable_diff.cpp is #included directly, so that its (static) functions can be called from here.
+
+#define EXECUTABLE_DIFF_COUNT_ALLOCATIONS  // so that each phase's heap allocations get counted
+#define main executable_diff_main
+#include "executable_diff.cpp"
+#undef main
+
+/** Resets the process's peak-RSS counter, if the OS lets us (Linux 4.0 and later do), so that each phase's peak can be measured separately */
+static void ResetPeakMemoryUsage()
+{
+#ifndef __APPLE__
+   FILE * fp = fopen("/proc/self/clear_refs", "w");
+   if (fp)
+   {
+      (void) fputs("5", fp);  // 5 means "reset the peak RSS to the current RSS"
+      fclose(fp);
+   }
+#endif
+}
+
+/** A small, fast, deterministic pseudo-random number generator (xorshift64), so that every run generates the same input */
+class BenchmarkRandom
+{
+public:
+   BenchmarkRandom(uint64 seed) : _state(seed ? seed : 1) {/* empty */}
+
+   /** Returns a pseudo-random number between 0 and (range-1), inclusive */
+   uint32 GetNext(uint32 range)
+   {
+      _state ^= (_state << 13);
+      _state ^= (_state >> 7);
+      _state ^= (_state << 17);
+      return (uint32)(_state % range);
+   }
+
+private:
+   uint64 _state;
+};
+
+/** Synthetic stand-in for a parsed executable:  a set of functions, their lines of disassembly, and a read-only data section
+  * that their instructions refer to.  The lines are in the form the parsers hand them to AppendRawLine() in (i.e. objdump-style
+  * under Linux and otool-style under MacOS/X), and under Linux the full objdump output is also written to a temporary file,
+  * so that the parse loop itself can be benchmarked too.
+  */
+class SyntheticExecutable
+{
+public:
+   SyntheticExecutable() : _numLines(0), _numLineBytes(0), _optDisassemblyFile(NULL), _numDisassemblyLines(0), _numDisassemblyBytes(0) {/* empty */}
+   ~SyntheticExecutable() {if (_optDisassemblyFile) fclose(_optDisassemblyFile);}
+
+   status_t Generate(uint32 numSymbols, uint32 linesPerSymbol, uint64 seed)
+   {
+      BenchmarkRandom rand(seed);
+
+      // Lay out the functions first, so that the calls and jumps below can refer to real addresses
+      const uint64 textStart = 0x401000;
+      Queue<uint64> starts, lengths;
+      if ((starts.EnsureSize(numSymbols) != B_NO_ERROR)||(lengths.EnsureSize(numSymbols) != B_NO_ERROR)||(_symbols.EnsureSize(numSymbols) != B_NO_ERROR)) return B_ERROR;
+
+      uint64 addr = textStart;
+      for (uint32 i=0; i<numSymbols; i++)
+      {
+         const uint64 length = (linesPerSymbol*4)+rand.GetNext(linesPerSymbol*2);
+         (void) starts.AddTail(addr);
+         (void) lengths.AddTail(length);
+         addr = (addr+length+15)&~((uint64)15);  // functions are 16-byte aligned
+      }
+
+      // The read-only data section goes after the text, and holds a mix of string literals and offset-tables (see IsOffset())
+      const uint64 roDataStart = (addr+0xFFFF)&~((uint64)0xFFFF);
+      Queue<uint64> literalAddresses;
+      const uint32 numLiterals = (numSymbols/4)+1;
+      for (uint32 i=0; i<numLiterals; i++)
+      {
+         char buf[64];
+         const uint64 literalAddr = roDataStart+_roDataBytes.GetNumBytes();
+         if (rand.GetNext(8) == 0)
+         {
+            const uint8 offsetEntry[8] = {(uint8)rand.GetNext(256), (uint8)rand.GetNext(256), 0, 0, 0, 0, 0, 0};
+            if (_roDataBytes.AppendBytes(offsetEntry, sizeof(offsetEntry)) != B_NO_ERROR) return B_ERROR;
+         }
+         else
+         {
+            muscleSprintf(buf, "string literal #" UINT32_FORMAT_SPEC "%s", i, (rand.GetNext(4) == 0) ? "\n" : "");
+            if (_roDataBytes.AppendBytes((const uint8 *) buf, (uint32) strlen(buf)+1) != B_NO_ERROR) return B_ERROR;
+         }
+         if (literalAddresses.AddTail(literalAddr) != B_NO_ERROR) return B_ERROR;
+      }
+      if (_roData.AddRegion(ReadOnlyDataRegion(roDataStart, _roDataBytes.GetBuffer(), _roDataBytes.GetNumBytes())) != B_NO_ERROR) return B_ERROR;
+
+#ifndef __APPLE__
+      _optDisassemblyFile = tmpfile();
+      if (_optDisassemblyFile == NULL) return B_ERROR;
+      WriteDisassemblyLine("");
+      WriteDisassemblyLine("synthetic_executable:     file format elf64-x86-64");
+      WriteDisassemblyLine("");
+      WriteDisassemblyLine("");
+      WriteDisassemblyLine("Disassembly of section .text:");
+#endif
+
+      char buf[256];
+      for (uint32 i=0; i<numSymbols; i++)
+      {
+         char name[64];
+         muscleSprintf(name, "synthetic_function_" UINT32_FORMAT_SPEC, i);
+
+         SymbolRecord rec;
+         rec._startAddress = starts[i];
+         rec._length       = lengths[i];
+         if (_symbols.Put(name, rec) != B_NO_ERROR) return B_ERROR;
+
+#ifndef __APPLE__
+         WriteDisassemblyLine("");
+         muscleSprintf(buf, "%016llx <%s>:", (unsigned long long) starts[i], name);
+         WriteDisassemblyLine(buf);
+#endif
+
+         _lineArena.BeginSpan();
+         uint64 insnAddr = starts[i];
+         for (uint32 j=0; j<linesPerSymbol; j++)
+         {
+            const uint64 nextAddr = muscleMin(insnAddr+1+rand.GetNext(7), starts[i]+lengths[i]-1);
+            const uint32 callee   = rand.GetNext(numSymbols);
+            const uint64 literal  = literalAddresses[rand.GetNext(numLiterals)];
+            const uint64 target   = starts[i]+rand.GetNext((uint32)lengths[i]);
+            const uint32 ripDelta = rand.GetNext(0x100000);
+
+            uint32 kind = (j < 3) ? j : ((j+2 >= linesPerSymbol) ? (12+(linesPerSymbol-j)) : (3+rand.GetNext(10)));
+            bool neutralize = false;
+            switch(kind)
+            {
+#ifdef __APPLE__
+               case 0:  muscleSprintf(buf, "pushq\t%%rbp");                                                                   break;
+               case 1:  muscleSprintf(buf, "movq\t%%rsp, %%rbp");                                                             break;
+               case 2:  muscleSprintf(buf, "subq\t$0x20, %%rsp");                                                             break;
+               case 3:  muscleSprintf(buf, "movl\t%%edi, -0x14(%%rbp)");                                                      break;
+               case 4:  muscleSprintf(buf, "leaq\t0x%x(%%rip), %%rdi", ripDelta);                                  neutralize = true; break;
+               case 5:  muscleSprintf(buf, "movq\t0x%x(%%rip), %%rax", ripDelta);                                  neutralize = true; break;
+               case 6:  muscleSprintf(buf, "callq\t0x" XINT64_FORMAT_SPEC, starts[callee]);                       neutralize = true; break;
+               case 7:  muscleSprintf(buf, "je\t0x" XINT64_FORMAT_SPEC, target);                                                      break;
+               case 8:  muscleSprintf(buf, "movabsq\t$0x" XINT64_FORMAT_SPEC ", %%rsi", literal);                                     break;
+               case 9:  muscleSprintf(buf, "xorl\t%%eax, %%eax");                                                             break;
+               case 10: muscleSprintf(buf, "addq\t$0x8, %%rsp");                                                              break;
+               case 11: muscleSprintf(buf, "movl\t0x%x(%%rbx,%%rcx,4), %%edx", rand.GetNext(0x100));                         break;
+               case 12: muscleSprintf(buf, "jmp\t0x" XINT64_FORMAT_SPEC, starts[callee]);                         neutralize = true; break;
+               case 13: muscleSprintf(buf, "retq");                                                                           break;
+               default: muscleSprintf(buf, "popq\t%%rbp");                                                                    break;
+#else
+               case 0:  muscleSprintf(buf, "push   %%rbp");                                                                   break;
+               case 1:  muscleSprintf(buf, "mov    %%rsp,%%rbp");                                                 neutralize = true; break;
+               case 2:  muscleSprintf(buf, "sub    $0x20,%%rsp");                                                 neutralize = true; break;
+               case 3:  muscleSprintf(buf, "mov    %%edi,-0x14(%%rbp)");                                                      break;
+               case 4:  muscleSprintf(buf, "lea    0x%x(%%rip),%%rdi        # " XINT64_FORMAT_SPEC " <.rodata+0x" XINT64_FORMAT_SPEC ">", ripDelta, literal, literal-roDataStart); neutralize = true; break;
+               case 5:  muscleSprintf(buf, "mov    0x%x(%%rip),%%rax        # " XINT64_FORMAT_SPEC " <synthetic_global_%u>", ripDelta, roDataStart+0x10000000+ripDelta, ripDelta); neutralize = true; break;
+               case 6:  muscleSprintf(buf, "call   " XINT64_FORMAT_SPEC " <synthetic_function_" UINT32_FORMAT_SPEC ">", starts[callee], callee); neutralize = true; break;
+               case 7:  muscleSprintf(buf, "je     " XINT64_FORMAT_SPEC " <%s+0x" XINT64_FORMAT_SPEC ">", target, name, target-starts[i]); neutralize = true; break;
+               case 8:  muscleSprintf(buf, "mov    $0x" XINT64_FORMAT_SPEC ",%%esi", literal);                                            break;
+               case 9:  muscleSprintf(buf, "xor    %%eax,%%eax");                                                             break;
+               case 10: muscleSprintf(buf, "add    $0x8,%%rsp");                                                  neutralize = true; break;
+               case 11: muscleSprintf(buf, "mov    0x%x(%%rbx,%%rcx,4),%%edx", rand.GetNext(0x100));                          break;
+               case 12: muscleSprintf(buf, "jmp    " XINT64_FORMAT_SPEC " <synthetic_function_" UINT32_FORMAT_SPEC ">", starts[callee], callee); neutralize = true; break;
+               case 13: muscleSprintf(buf, "ret");                                                                            break;
+               default: muscleSprintf(buf, "leave");                                                                          break;
+#endif
+            }
+
+            const uint32 lineLength = (uint32) strlen(buf);
+            if ((_lineArena.Append(buf, lineLength+1) != B_NO_ERROR)||(_neutralizeFlags.AddTail(neutralize) != B_NO_ERROR)) return B_ERROR;
+            _numLines++;
+            _numLineBytes += lineLength;
+
+#ifndef __APPLE__
+            char lineBuf[300];
+            muscleSprintf(lineBuf, "  " XINT64_FORMAT_SPEC ":\t%s", insnAddr, buf);
+            WriteDisassemblyLine(lineBuf);
+#endif
+            insnAddr = nextAddr;
+         }
+         if (_symbolLines.AddTail(_lineArena.EndSpan()) != B_NO_ERROR) return B_ERROR;
+      }
+
+      if ((_optDisassemblyFile)&&(fflush(_optDisassemblyFile) != 0)) return B_ERROR;
+      return B_NO_ERROR;
+   }
+
+   /** Rewinds the disassembly file (if any) to its start, and returns it, or returns NULL if we don't have one */
+   FILE * RewindDisassemblyFile()
+   {
+      if (_optDisassemblyFile) rewind(_optDisassemblyFile);
+      return _optDisassemblyFile;
+   }
+
+   Hashtable<String, SymbolRecord> _symbols;  // the functions, in address-order (with no text)
+   TextArena _lineArena;                      // holds each function's lines, each one NUL-terminated
+   Queue<TextSpan> _symbolLines;              // each function's lines, within (_lineArena)
+   Queue<bool> _neutralizeFlags;              // for each line, whether the parser would neutralize it
+   uint64 _numLines;                          // total number of lines in (_symbolLines)
+   uint64 _numLineBytes;                      // total number of bytes in (_symbolLines), not counting NUL terminators
+   ByteBuffer _roDataBytes;                   // the contents of the read-only data section
+   ReadOnlyData _roData;                      // describes (_roDataBytes)
+
+   FILE * _optDisassemblyFile;                // the full objdump output (Linux only)
+   uint64 _numDisassemblyLines;
+   uint64 _numDisassemblyBytes;
+
+private:
+   SyntheticExecutable(const SyntheticExecutable &);  // deliberately unimplemented
+   SyntheticExecutable & operator = (const SyntheticExecutable &);  // deliberately unimplemented
+
+   void WriteDisassemblyLine(const char * line)
+   {
+      const size_t lineLength = strlen(line);
+      (void) fwrite(line, 1, lineLength, _optDisassemblyFile);
+      (void) fputc('\n', _optDisassemblyFile);
+      _numDisassemblyLines++;
+      _numDisassemblyBytes += lineLength+1;
+   }
+};
+
+/** Runs each phase of the benchmark on (exe), one at a time, recording each one's measurements into (stats).
+  * The number of bytes each phase processed is recorded as its PhaseStats::_numBytesRead.
+  */
+static void RunBenchmarks(SyntheticExecutable & exe, uint32 numThreads, RunStats & stats)
+{
+   // Phase 1:  neutralizing addresses (what the parse loops do with each line, via StreamingSanitizer::AddRawLine())
+   TextArena rawArena;
+   Queue<TextSpan> rawTexts;
+   (void) rawTexts.EnsureSize(exe._symbolLines.GetNumItems());
+   {
+      ResetPeakMemoryUsage();
+      PhaseRecorder phase(&stats, "AppendWithNeutralizedAddresses");
+      uint32 lineIdx = 0;
+      for (uint32 i=0; i<exe._symbolLines.GetNumItems(); i++)
+      {
+         const TextSpan & lines = exe._symbolLines[i];
+         rawArena.BeginSpan();
+         for (const char * p=lines._chars; p<lines._chars+lines._length; lineIdx++)
+         {
+            const uint32 lineLength = (uint32) strlen(p);
+            AppendRawLine(p, lineLength, exe._neutralizeFlags[lineIdx], rawArena);
+            p += lineLength+1;
+         }
+         (void) rawTexts.AddTail(rawArena.EndSpan());
+      }
+      phase.GetStats()._numLines     = exe._numLines;
+      phase.GetStats()._numBytesRead = exe._numLineBytes;
+   }
+
+   // Phase 2:  the first stage of sanitizing (SanitizeLine(), including expanding read-only data into string literals)
+   TextArena sanitizedArena;
+   Queue<TextSpan> sanitizedTexts;
+   (void) sanitizedTexts.EnsureSize(rawTexts.GetNumItems());
+   {
+      ResetPeakMemoryUsage();
+      PhaseRecorder phase(&stats, "SanitizeLine");
+      for (uint32 i=0; i<rawTexts.GetNumItems(); i++)
+      {
+         (void) sanitizedTexts.AddTail(SanitizeAddresses(rawTexts[i], &exe._roData, sanitizedArena));
+         phase.GetStats()._numBytesRead += rawTexts[i]._length;
+      }
+      phase.GetStats()._numLines = exe._numLines;
+   }
+
+   // Phase 3:  the second stage of sanitizing (looking up the symbol that each remaining address points into)
+   AddressIndex index;
+   if (index.SetSymbols(exe._symbols) != B_NO_ERROR) return;
+   LineTable lineTable;
+   TextArena resolvedArena;
+   Queue<LineIDSpan> resolvedTexts;
+   (void) resolvedTexts.EnsureSize(sanitizedTexts.GetNumItems());
+   {
+      ResetPeakMemoryUsage();
+      PhaseRecorder phase(&stats, "ResolveSanitizedLine");
+      AddressLookupCache cache;
+      LineIDCache lineCache;
+      String scratchStr;
+      for (uint32 i=0; i<sanitizedTexts.GetNumItems(); i++)
+      {
+         (void) resolvedTexts.AddTail(ResolveSanitizedText(sanitizedTexts[i], index, lineTable, &cache, &lineCache, scratchStr, resolvedArena));
+         phase.GetStats()._numBytesRead += sanitizedTexts[i]._length;
+      }
+      phase.GetStats()._numLines = exe._numLines;
+   }
+
+   // Phase 4:  rename-matching, in the worst case where every symbol got renamed (so that none of them match by name)
+   {
+      Hashtable<String, SymbolRecord> tableA, tableB;
+      for (uint32 i=0; i<resolvedTexts.GetNumItems(); i++)
+      {
+         SymbolRecord rec;
+         rec._lines = resolvedTexts[i];
+         (void) tableA.Put(String("old_func_%1#0").Arg(i), rec);
+         (void) tableB.Put(String("new_func_%1#0").Arg(i), rec);
+      }
+
+      ResetPeakMemoryUsage();
+      PhaseRecorder phase(&stats, "FindRenamedSymbols");
+      Queue<RenamedSymbol> renames;
+      FindRenamedSymbols(tableA, tableB, lineTable, renames);
+      phase.GetStats()._numLines   = exe._numLines*2;
+      phase.GetStats()._numSymbols = tableA.GetNumItems()+tableB.GetNumItems();
+      for (uint32 i=0; i<resolvedTexts.GetNumItems(); i++) phase.GetStats()._numBytesRead += resolvedTexts[i]._numLines*sizeof(uint32)*2;
+      phase.Finish();
+
+      LogTime(MUSCLE_LOG_INFO, "FindRenamedSymbols() paired up " UINT32_FORMAT_SPEC " of " UINT32_FORMAT_SPEC " renamed symbols.\n", renames.GetNumItems(), resolvedTexts.GetNumItems());
+   }
+
+#ifndef __APPLE__
+   // Phase 5:  the whole objdump parse loop, from reading its output through to the fully-sanitized symbols
+   FILE * fpIn = exe.RewindDisassemblyFile();
+   if (fpIn)
+   {
+      ResetPeakMemoryUsage();
+      PhaseRecorder phase(&stats, "ParseObjdumpStream (end to end)");
+      ParseSettings settings;
+      settings._numSanitizerThreads = numThreads;
+
+      SymbolTable table;
+      table._lineTable = LineTableRef(newnothrow LineTable);
+      if (table._lineTable() == NULL) {WARN_OUT_OF_MEMORY; return;}
+      Hashtable<String, SymbolRecord> & symbols = table._symbols;
+      (void) symbols.EnsureSize(exe._symbols.GetNumItems());
+      {
+         StreamingSanitizer sanitizer("bench", &exe._roData, numThreads);
+         ObjdumpParseState state("bench", NULL, sanitizer, symbols);
+         ParseObjdumpStream(fpIn, true, state);
+         if (state._curSymbolContents) sanitizer.EndSymbol();
+         sanitizer.Finish(symbols);
+
+         symbols.SortByValue(CompareStartAddressesFunctor());
+         AddressIndex parsedIndex;
+         (void) parsedIndex.SetSymbols(symbols);
+         sanitizer.ResolveSymbols(table, parsedIndex, settings);
+      }
+      phase.GetStats()._numLines     = exe._numDisassemblyLines;
+      phase.GetStats()._numBytesRead = exe._numDisassemblyBytes;
+      phase.GetStats()._numSymbols   = symbols.GetNumItems();
+      phase.Finish();
+
+      if (symbols.GetNumItems() != exe._symbols.GetNumItems()) LogTime(MUSCLE_LOG_WARNING, "Parse loop found " UINT32_FORMAT_SPEC " symbols, but " UINT32_FORMAT_SPEC " were generated!\n", symbols.GetNumItems(), exe._symbols.GetNumItems());
+   }
+#else
+   (void) numThreads;
+#endif
+}
+
+static String GetHumanReadableRate(double perSecond)
+{
+   char buf[64];
+        if (perSecond >= 1e9) muscleSprintf(buf, "%.2fG", perSecond/1e9);
+   else if (perSecond >= 1e6) muscleSprintf(buf, "%.2fM", perSecond/1e6);
+   else if (perSecond >= 1e3) muscleSprintf(buf, "%.2fK", perSecond/1e3);
+   else                       muscleSprintf(buf, "%.0f",  perSecond);
+   return buf;
+}
+
+static void PrintResults(uint32 numSymbols, uint32 linesPerSymbol, const RunStats & stats)
+{
+   const Queue<PhaseStats> & results = stats.GetPhases();
+   printf("\n" UINT32_FORMAT_SPEC " symbols, " UINT32_FORMAT_SPEC " lines per symbol:\n", numSymbols, linesPerSymbol);
+   printf("  %-32s %12s %12s %10s %10s %10s %12s %10s\n", "Phase", "Lines", "Bytes", "Seconds", "Lines/sec", "Bytes/sec", "Allocations", "Peak RSS");
+   for (uint32 i=0; i<results.GetNumItems(); i++)
+   {
+      const PhaseStats & r = results[i];
+      const double seconds = muscleMax(r._wallMicros, (uint64)1)/1000000.0;
+      printf("  %-32s %12llu %12llu %10.3f %10s %10s %12llu %8.1fMB\n", r._name(), (unsigned long long) r._numLines, (unsigned long long) r._numBytesRead, seconds,
+             GetHumanReadableRate(r._numLines/seconds)(), GetHumanReadableRate(r._numBytesRead/seconds)(), (unsigned long long) r._numAllocations, r._peakMemoryUsage/(1024.0*1024.0));
+   }
+}
+
+#ifndef __APPLE__
+/** One known x86 encoding, and what DecodeX86Instruction() should make of it */
+struct X86DecoderTestCase
+{
+   bool _is64Bit;
+   const char * _hexBytes;        // the instruction's bytes, e.g. "e8 00 00 00 00"
+   int32 _expectedLength;         // the instruction's length, or -1 if it shouldn't be decodable
+   const char * _expectedFields;  // its address-fields, e.g. "R1.4 A6.4" means a 4-byte relative field at offset 1 and a 4-byte absolute one at offset 6
+   const char * _description;     // what objdump shows for it
+};
+
+static const X86DecoderTestCase _x86DecoderTestCases[] = {
+   {true,  "c3",                            1,  "",          "ret"},
+   {true,  "48 89 e5",                      3,  "",          "mov %rsp,%rbp"},
+   {true,  "e8 00 00 00 00",                5,  "R1.4",      "call rel32"},
+   {true,  "eb 05",                         2,  "R1.1",      "jmp rel8"},
+   {true,  "0f 84 10 00 00 00",             6,  "R2.4",      "je rel32"},
+   {true,  "48 8d 05 d9 2e 00 00",          7,  "R3.4",      "lea 0x2ed9(%rip),%rax"},
+   {true,  "48 c7 c0 78 56 34 12",          7,  "A3.4",      "mov $0x12345678,%rax"},
+   {true,  "48 b8 88 77 66 55 44 33 22 11", 10, "A2.8",      "movabs $0x1122334455667788,%rax"},
+   {true,  "a1 88 77 66 55 44 33 22 11",    9,  "A1.8",      "movabs 0x1122334455667788,%eax"},
+   {true,  "8b 04 85 40 40 40 00",          7,  "A3.4",      "mov 0x404040(,%rax,4),%eax"},
+   {true,  "c7 05 f0 2f 00 00 01 00 00 00", 10, "R2.4 A6.4", "movl $0x1,0x2ff0(%rip)"},
+   {true,  "48 69 c0 10 27 00 00",          7,  "A3.4",      "imul $0x2710,%rax,%rax"},
+   {true,  "66 0f 1f 44 00 00",             6,  "",          "nopw 0x0(%rax,%rax,1)"},
+   {true,  "0f 1f 80 00 00 00 00",          7,  "A3.4",      "nopl 0x0(%rax)"},
+   {true,  "f6 c3 01",                      3,  "",          "test $0x1,%bl"},
+   {true,  "f7 c3 ff 00 00 00",             6,  "A2.4",      "test $0xff,%ebx"},
+   {true,  "f7 d8",                         2,  "",          "neg %eax"},
+   {true,  "66 83 f8 01",                   4,  "",          "cmp $0x1,%ax"},
+   {true,  "66 05 34 12",                   4,  "",          "add $0x1234,%ax"},
+   {true,  "f3 0f 1e fa",                   4,  "",          "endbr64"},
+   {true,  "66 0f 3a 0f c1 08",             6,  "",          "palignr $0x8,%xmm1,%xmm0"},
+   {true,  "c5 f9 6f 05 00 00 00 00",       8,  "R4.4",      "vmovdqa 0x0(%rip),%xmm0"},
+   {true,  "62 f1 fd 48 28 05 00 00 00 00", 10, "R6.4",      "vmovapd 0x0(%rip),%zmm0"},
+   {true,  "e8 00 00",                      -1, "",          "call rel32, truncated"},
+   {true,  "06",                            -1, "",          "push %es (not valid in 64-bit mode)"},
+   {false, "a1 40 40 40 00",                5,  "A1.4",      "mov 0x404040,%eax"},
+   {false, "8b 05 40 40 40 00",             6,  "A2.4",      "mov 0x404040,%eax"},
+   {false, "e8 00 00 00 00",                5,  "R1.4",      "call rel32"}
+};
+
+/** Checks DecodeX86Instruction() against some known encodings, so that a decoding bug can't silently skew the prefilter's
+  * results (or its benchmark).  Returns B_NO_ERROR if every encoding was decoded as expected, or B_ERROR (after logging the
+  * mismatches) otherwise.
+  */
+static status_t CheckX86Decoder()
+{
+   status_t ret = B_NO_ERROR;
+   for (uint32 i=0; i<ARRAYITEMS(_x86DecoderTestCases); i++)
+   {
+      const X86DecoderTestCase & tc = _x86DecoderTestCases[i];
+
+      uint8 bytes[16];
+      uint32 numBytes = 0;
+      StringTokenizer byteTok(tc._hexBytes, " ");
+      const char * t;
+      while(((t = byteTok()) != NULL)&&(numBytes < sizeof(bytes))) bytes[numBytes++] = (uint8) strtoul(t, NULL, 16);
+
+      String fields;
+      X86Instruction insn;
+      const bool decoded = (DecodeX86Instruction(bytes, numBytes, tc._is64Bit, insn) == B_NO_ERROR);
+      for (uint32 j=0; ((decoded)&&(j<insn._numAddressFields)); j++)
+      {
+         const AddressField & af = insn._addressFields[j];
+         if (j > 0) fields += ' ';
+         fields += String("%1%2.%3").Arg((af._type == AddressField::TYPE_RELATIVE) ? "R" : "A").Arg(af._offset).Arg(af._numBytes);
+      }
+
+      const int32 length = decoded ? (int32) insn._length : -1;
+      if ((length != tc._expectedLength)||((decoded)&&(fields != tc._expectedFields)))
+      {
+         LogTime(MUSCLE_LOG_ERROR, "DecodeX86Instruction() self-check failed for [%s] (%s, %s):  got length " INT32_FORMAT_SPEC " and fields [%s], expected length " INT32_FORMAT_SPEC " and fields [%s]\n",
+                 tc._hexBytes, tc._description, tc._is64Bit ? "64-bit" : "32-bit", length, fields(), tc._expectedLength, tc._expectedFields);
+         ret = B_ERROR;
+      }
+   }
+   return ret;
+}
+#endif
+
+static void PrintUsage()
+{
+   LogTime(MUSCLE_LOG_CRITICALERROR, "Usage:  ./executable_diff_bench [--symbols=N[,N...]] [--lines=N] [--threads=N] [--seed=N]\n");
+   LogTime(MUSCLE_LOG_CRITICALERROR, "  --symbols=N[,N...] : how many synthetic symbols to generate; each size is benchmarked in turn (defaults to 10000,100000)\n");
+   LogTime(MUSCLE_LOG_CRITICALERROR, "  --lines=N          : how many lines of disassembly each symbol has (defaults to 16)\n");
+   LogTime(MUSCLE_LOG_CRITICALERROR, "  --threads=N        : how many sanitizer threads the end-to-end parse phase may use (defaults to the number of CPU cores)\n");
+   LogTime(MUSCLE_LOG_CRITICALERROR, "  --seed=N           : seed for the synthetic input's pseudo-random number generator (defaults to 1)\n");
+}
+
+int main(int argc, char ** argv)
+{
+   CompleteSetupSystem css;
+   EnableAllocationCounting();
+
+   Hashtable<String, String> options;
+   Queue<String> paths;
+   ParseCommandLine(argc, argv, options, paths);
+   if ((paths.HasItems())||(options.ContainsKey("help")))
+   {
+      PrintUsage();
+      return 10;
+   }
+
+#ifndef __APPLE__
+   if (CheckX86Decoder() != B_NO_ERROR)
+   {
+      LogTime(MUSCLE_LOG_CRITICALERROR, "The x86 instruction decoder is broken, so the prefilter can't be trusted.  Fix it before benchmarking!\n");
+      return 10;
+   }
+   LogTime(MUSCLE_LOG_INFO, "DecodeX86Instruction() decoded all " UINT32_FORMAT_SPEC " known encodings correctly.\n", (uint32) ARRAYITEMS(_x86DecoderTestCases));
+#endif
+
+   const String * linesArg   = options.Get("lines");
+   const String * threadsArg = options.Get("threads");
+   const String * seedArg    = options.Get("seed");
+   const uint32 linesPerSymbol = linesArg   ? muscleMax((uint32) atol((*linesArg)()), (uint32)4) : 16;
+   const uint32 numThreads     = threadsArg ? (uint32) atol((*threadsArg)()) : GetNumCPUCores();
+   const uint64 seed           = seedArg    ? (uint64) atoll((*seedArg)()) : 1;
+
+   const String sizesArg = options.GetWithDefault("symbols", "10000,100000");
+   StringTokenizer tok(sizesArg(), ",");
+   const char * t;
+   while((t = tok()) != NULL)
+   {
+      const uint32 numSymbols = (uint32) atol(t);
+      if (numSymbols == 0) continue;
+
+      LogTime(MUSCLE_LOG_INFO, "Generating " UINT32_FORMAT_SPEC " synthetic symbols...\n", numSymbols);
+      SyntheticExecutable exe;
+      if (exe.Generate(numSymbols, linesPerSymbol, seed) != B_NO_ERROR)
+      {
+         LogTime(MUSCLE_LOG_CRITICALERROR, "Unable to generate " UINT32_FORMAT_SPEC " synthetic symbols!\n", numSymbols);
+         return 10;
+      }
+
+      RunStats stats;
+      RunBenchmarks(exe, numThreads, stats);
+      PrintResults(numSymbols, linesPerSymbol, stats);
+   }
+   return 0;
+}